@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "types.h"
+#include "poll.h"
+#include "fcntl.h"
+
+__DECL_BEGIN
+
+#define EPOLLIN POLLIN
+#define EPOLLPRI POLLPRI
+#define EPOLLOUT POLLOUT
+#define EPOLLERR POLLERR
+#define EPOLLHUP POLLHUP
+#define EPOLLONESHOT (1u << 30) //Stop reporting events for the file descriptor once one has been reported
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+typedef union epoll_data {
+	void* ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+	uint32_t events;
+	epoll_data_t data;
+};
+
+struct epoll_ctl_args {
+	int epfd;
+	int op;
+	int fd;
+	struct epoll_event* event;
+};
+
+struct epoll_wait_args {
+	int epfd;
+	struct epoll_event* events;
+	int maxevents;
+	int timeout;
+};
+
+__DECL_END
@@ -19,9 +19,19 @@
 #define MAP_FILE		0x0
 #define MAP_FIXED		0x4
 #define MAP_GROWSDOWN	0x8
+#define MAP_POPULATE	0x10
+#define MAP_NORESERVE	0x20
 
 #define MAP_FAILED ((void*) -1)
 
+#define MADV_NORMAL		0
+#define MADV_RANDOM		1
+#define MADV_SEQUENTIAL	2
+#define MADV_WILLNEED	3
+#define MADV_DONTNEED	4
+
+#define MREMAP_MAYMOVE	0x1
+
 __DECL_BEGIN
 
 struct mmap_args {
@@ -35,6 +45,14 @@ struct mmap_args {
 	const char* name;
 };
 
+struct mremap_args {
+	void* old_address;
+	size_t old_size;
+	size_t new_size;
+	int flags;
+	void** new_address_p;
+};
+
 struct shmcreate_args {
 	void* addr;
 	size_t size;
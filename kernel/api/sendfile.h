@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "types.h"
+
+__DECL_BEGIN
+
+struct copy_file_range_args {
+	int fd_in;
+	off_t* off_in;
+	int fd_out;
+	off_t* off_out;
+	size_t len;
+	unsigned int flags;
+};
+
+struct sendfile_args {
+	int out_fd;
+	int in_fd;
+	off_t* offset;
+	size_t count;
+};
+
+#define SPLICE_F_MOVE 0x1
+#define SPLICE_F_NONBLOCK 0x2
+#define SPLICE_F_MORE 0x4
+
+struct splice_args {
+	int fd_in;
+	off_t* off_in;
+	int fd_out;
+	off_t* off_out;
+	size_t len;
+	unsigned int flags;
+};
+
+__DECL_END
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "types.h"
+
+__DECL_BEGIN
+
+#define POSIX_SPAWN_RESETIDS	0x1
+#define POSIX_SPAWN_SETPGROUP	0x2
+#define POSIX_SPAWN_SETSID		0x4
+
+#define POSIX_SPAWN_FILE_ACTION_OPEN	1
+#define POSIX_SPAWN_FILE_ACTION_CLOSE	2
+#define POSIX_SPAWN_FILE_ACTION_DUP2	3
+
+struct posix_spawn_file_action {
+	int type;
+	int fd;
+	int newfd;
+	const char* path;
+	int oflag;
+	mode_t mode;
+};
+
+struct posix_spawn_args {
+	const char* path;
+	char* const* argv;
+	char* const* envp;
+	const struct posix_spawn_file_action* file_actions;
+	size_t num_file_actions;
+	int flags;
+	pid_t pgroup;
+	pid_t* pid_p;
+};
+
+__DECL_END
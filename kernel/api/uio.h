@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "types.h"
+
+__DECL_BEGIN
+
+/** The most buffers that can be passed to readv() and friends at once. **/
+#define IOV_MAX 1024
+
+struct iovec {
+	void* iov_base;
+	size_t iov_len;
+};
+
+struct pread_args {
+	int fd;
+	void* buf;
+	size_t count;
+	off_t offset;
+};
+
+struct preadv_args {
+	int fd;
+	const struct iovec* iov;
+	int iovcnt;
+	off_t offset;
+};
+
+__DECL_END
@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/kstd/types.h>
+#include <kernel/memory/Memory.h>
+
+//PCI
+#define AHCI_PCI_PROG_IF 0x1
+#define AHCI_MAX_PORTS 32
+#define AHCI_MAX_SLOTS 32
+
+//Generic host control
+#define AHCI_CAP_NCS(cap) ((((cap) >> 8u) & 0x1Fu) + 1) //Number of command slots
+#define AHCI_CAP_SNCQ (1u << 30) //Supports native command queuing
+#define AHCI_GHC_HR (1u << 0) //HBA reset
+#define AHCI_GHC_IE (1u << 1) //Interrupt enable
+#define AHCI_GHC_AE (1u << 31) //AHCI enable
+
+//Port command and status
+#define AHCI_PORT_CMD_ST (1u << 0) //Start processing the command list
+#define AHCI_PORT_CMD_FRE (1u << 4) //FIS receive enable
+#define AHCI_PORT_CMD_FR (1u << 14) //FIS receive running
+#define AHCI_PORT_CMD_CR (1u << 15) //Command list running
+
+//Port interrupt status
+#define AHCI_PORT_IS_DHRS (1u << 0) //Device to host register FIS
+#define AHCI_PORT_IS_PSS (1u << 1) //PIO setup FIS
+#define AHCI_PORT_IS_DSS (1u << 2) //DMA setup FIS
+#define AHCI_PORT_IS_SDBS (1u << 3) //Set device bits FIS, used to complete queued commands
+#define AHCI_PORT_IS_IFS (1u << 27) //Interface fatal error
+#define AHCI_PORT_IS_HBDS (1u << 28) //Host bus data error
+#define AHCI_PORT_IS_HBFS (1u << 29) //Host bus fatal error
+#define AHCI_PORT_IS_TFES (1u << 30) //Task file error
+#define AHCI_PORT_IS_COMPLETE (AHCI_PORT_IS_DHRS | AHCI_PORT_IS_PSS | AHCI_PORT_IS_DSS | AHCI_PORT_IS_SDBS)
+#define AHCI_PORT_IS_ERROR (AHCI_PORT_IS_IFS | AHCI_PORT_IS_HBDS | AHCI_PORT_IS_HBFS | AHCI_PORT_IS_TFES)
+
+//Port SATA status and signature
+#define AHCI_PORT_SSTS_DET(ssts) ((ssts) & 0xFu)
+#define AHCI_PORT_SSTS_IPM(ssts) (((ssts) >> 8u) & 0xFu)
+#define AHCI_PORT_DET_PRESENT 0x3
+#define AHCI_PORT_IPM_ACTIVE 0x1
+#define AHCI_SIG_ATA 0x00000101
+
+//FIS
+#define AHCI_FIS_TYPE_REG_H2D 0x27
+#define AHCI_FIS_DEVICE_LBA 0x40
+
+/** The size of the received FIS area of a port. **/
+#define AHCI_RECEIVED_FIS_SIZE 256
+/** The number of PRDT entries that fit in a command table, so that each command table takes up exactly one page. **/
+#define AHCI_MAX_PRDT_ENTRIES ((PAGE_SIZE - 128) / sizeof(AHCI::PRDTEntry))
+/** The largest number of bytes a single PRDT entry can describe. **/
+#define AHCI_MAX_PRDT_ENTRY_SIZE 0x400000
+/** The largest number of sectors a single read or write command can transfer. **/
+#define AHCI_MAX_SECTORS_PER_COMMAND 65536
+
+namespace AHCI {
+	struct __attribute__((packed)) PortRegisters {
+		uint32_t clb; //Command list base address
+		uint32_t clbu;
+		uint32_t fb; //Received FIS base address
+		uint32_t fbu;
+		uint32_t is; //Interrupt status
+		uint32_t ie; //Interrupt enable
+		uint32_t cmd; //Command and status
+		uint32_t reserved_1;
+		uint32_t tfd; //Task file data
+		uint32_t sig; //Signature
+		uint32_t ssts; //SATA status
+		uint32_t sctl; //SATA control
+		uint32_t serr; //SATA error
+		uint32_t sact; //SATA active (Outstanding queued commands)
+		uint32_t ci; //Command issue
+		uint32_t sntf; //SATA notification
+		uint32_t fbs; //FIS-based switching control
+		uint32_t reserved_2[11];
+		uint32_t vendor[4];
+	};
+
+	struct __attribute__((packed)) HBARegisters {
+		uint32_t cap; //Host capabilities
+		uint32_t ghc; //Global host control
+		uint32_t is; //Interrupt status, one bit per port
+		uint32_t pi; //Ports implemented
+		uint32_t vs; //Version
+		uint32_t ccc_ctl;
+		uint32_t ccc_ports;
+		uint32_t em_loc;
+		uint32_t em_ctl;
+		uint32_t cap2;
+		uint32_t bohc;
+		uint8_t reserved[0xA0 - 0x2C];
+		uint8_t vendor[0x100 - 0xA0];
+		PortRegisters ports[AHCI_MAX_PORTS];
+	};
+
+	struct __attribute__((packed)) CommandHeader {
+		uint8_t fis_length : 5; //In dwords
+		uint8_t atapi : 1;
+		uint8_t write : 1;
+		uint8_t prefetchable : 1;
+		uint8_t reset : 1;
+		uint8_t bist : 1;
+		uint8_t clear_busy : 1;
+		uint8_t : 1;
+		uint8_t port_multiplier : 4;
+		uint16_t prdt_length; //In entries
+		volatile uint32_t prdt_byte_count; //Updated by the HBA as it transfers
+		uint32_t command_table_base;
+		uint32_t command_table_base_upper;
+		uint32_t reserved[4];
+	};
+
+	struct __attribute__((packed)) FISRegH2D {
+		uint8_t type;
+		uint8_t port_multiplier : 4;
+		uint8_t : 3;
+		uint8_t is_command : 1;
+		uint8_t command;
+		uint8_t feature_low;
+		uint8_t lba0;
+		uint8_t lba1;
+		uint8_t lba2;
+		uint8_t device;
+		uint8_t lba3;
+		uint8_t lba4;
+		uint8_t lba5;
+		uint8_t feature_high;
+		uint8_t count_low;
+		uint8_t count_high;
+		uint8_t icc;
+		uint8_t control;
+		uint8_t reserved[4];
+	};
+
+	struct __attribute__((packed)) PRDTEntry {
+		uint32_t addr; //Must be word-aligned
+		uint32_t addr_upper;
+		uint32_t reserved;
+		uint32_t byte_count : 22; //The number of bytes minus one, which must be odd
+		uint32_t : 9;
+		uint32_t interrupt : 1;
+	};
+
+	struct __attribute__((packed)) CommandTable {
+		uint8_t fis[64];
+		uint8_t atapi_command[16];
+		uint8_t reserved[48];
+		PRDTEntry prdt[];
+	};
+}
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "AHCIController.h"
+#include "AHCIDevice.h"
+#include <kernel/IO.h>
+#include <kernel/kstd/KLog.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/tasking/TaskManager.h>
+
+AHCIController* AHCIController::find() {
+	PCI::Address addr = {0, 0, 0};
+	PCI::enumerate_devices([](PCI::Address addr, PCI::ID id, uint16_t type, void* data) {
+		auto* found = (PCI::Address*) data;
+		if(type == PCI_TYPE_SATA_CONTROLLER && PCI::read_byte(addr, PCI_PROG_IF) == AHCI_PCI_PROG_IF && found->is_zero())
+			*found = addr;
+	}, &addr);
+	if(addr.is_zero())
+		return nullptr;
+	return new AHCIController(addr);
+}
+
+AHCIController::AHCIController(PCI::Address addr):
+	IRQHandler(PCI::read_byte(addr, PCI_INTERRUPT_LINE)), _pci_addr(addr)
+{
+	//Enable memory space access, bus mastering and the interrupt line
+	PCI::Command comm = {.value = PCI::read_word(addr, PCI_COMMAND)};
+	comm.attrs.mem_space = true;
+	PCI::write_word(addr, PCI_COMMAND, comm.value);
+	PCI::enable_bus_mastering(addr);
+	PCI::enable_interrupt(addr);
+
+	//Map the HBA's registers, which are pointed to by BAR5
+	PhysicalAddress abar = PCI::read_dword(addr, PCI_BAR5) & ~0xFu;
+	//The registers may not start on a page boundary, so map the page they start in and offset into it
+	PhysicalAddress abar_page = abar & ~(PAGE_SIZE - 1);
+	_hba_region = MM.alloc_mapped_region(abar_page, abar - abar_page + sizeof(AHCI::HBARegisters));
+	_hba = (volatile AHCI::HBARegisters*) (_hba_region->start() + (abar - abar_page));
+
+	reset();
+	_num_slots = AHCI_CAP_NCS(_hba->cap);
+	_supports_ncq = _hba->cap & AHCI_CAP_SNCQ;
+	KLog::info("AHCI", "Found AHCI %d.%d controller at %x:%x.%x with %d command slots%s",
+			   _hba->vs >> 16, (_hba->vs >> 8) & 0xFF, addr.bus, addr.slot, addr.function, _num_slots,
+			   _supports_ncq ? " and NCQ" : "");
+
+	//Set up a device for each port that has a SATA disk attached
+	uint32_t implemented = _hba->pi;
+	for(unsigned port_num = 0; port_num < AHCI_MAX_PORTS; port_num++) {
+		if(!(implemented & (1u << port_num)))
+			continue;
+		auto* port = &_hba->ports[port_num];
+		if(AHCI_PORT_SSTS_DET(port->ssts) != AHCI_PORT_DET_PRESENT || AHCI_PORT_SSTS_IPM(port->ssts) != AHCI_PORT_IPM_ACTIVE)
+			continue;
+		if(port->sig != AHCI_SIG_ATA) {
+			KLog::dbg("AHCI", "Skipping port %d with non-ATA signature 0x%x", port_num, port->sig);
+			continue;
+		}
+
+		auto* device = new AHCIDevice(*this, port_num, port);
+		if(!device->is_present()) {
+			Device::remove_device(device->major(), device->minor());
+			continue;
+		}
+		_ports[port_num] = device;
+		_disks.push_back((kstd::Arc<AHCIDevice>) device->shared_ptr());
+	}
+
+	//Now that the ports are ready, clear any pending interrupts and enable them
+	_hba->is = _hba->is;
+	_hba->ghc = _hba->ghc | AHCI_GHC_IE;
+}
+
+AHCIController::~AHCIController() = default;
+
+void AHCIController::reset() {
+	_hba->ghc = _hba->ghc | AHCI_GHC_AE;
+	_hba->ghc = _hba->ghc | AHCI_GHC_HR;
+	while(_hba->ghc & AHCI_GHC_HR);
+	_hba->ghc = _hba->ghc | AHCI_GHC_AE;
+
+	//Resetting the HBA resets the links too, so give the disks up to 10ms to come back
+	uint32_t implemented = _hba->pi;
+	for(unsigned port_num = 0; port_num < AHCI_MAX_PORTS; port_num++) {
+		if(!(implemented & (1u << port_num)))
+			continue;
+		for(int i = 0; i < 100 && AHCI_PORT_SSTS_DET(_hba->ports[port_num].ssts) != AHCI_PORT_DET_PRESENT; i++)
+			IO::wait(100);
+	}
+}
+
+void AHCIController::handle_irq(Registers* regs) {
+	uint32_t pending = _hba->is;
+	if(!pending)
+		return; //Interrupt wasn't for this
+	for(unsigned port_num = 0; port_num < AHCI_MAX_PORTS; port_num++) {
+		if((pending & (1u << port_num)) && _ports[port_num])
+			_ports[port_num]->handle_irq();
+	}
+	_hba->is = pending;
+	TaskManager::yield_if_idle();
+}
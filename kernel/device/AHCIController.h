@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/pci/PCI.h>
+#include <kernel/interrupt/IRQHandler.h>
+#include <kernel/memory/VMRegion.h>
+#include <kernel/kstd/vector.hpp>
+#include "AHCI.h"
+
+class AHCIDevice;
+
+/**
+ * An AHCI host bus adapter. Sets up each port that has a SATA disk attached as an AHCIDevice and passes interrupts on
+ * to the ports that raised them.
+ */
+class AHCIController: public IRQHandler {
+public:
+	/** Finds the first AHCI controller on the PCI bus and sets up its disks. **/
+	static AHCIController* find();
+
+	~AHCIController();
+
+	const kstd::vector<kstd::Arc<AHCIDevice>>& disks() const { return _disks; }
+	/** The number of command slots each port has. **/
+	size_t num_slots() const { return _num_slots; }
+	/** Whether the controller supports native command queuing. **/
+	bool supports_ncq() const { return _supports_ncq; }
+
+protected:
+	//IRQHandler
+	void handle_irq(Registers* regs) override;
+
+private:
+	explicit AHCIController(PCI::Address addr);
+
+	/** Resets the controller and puts it into AHCI mode. **/
+	void reset();
+
+	PCI::Address _pci_addr;
+	kstd::Arc<VMRegion> _hba_region;
+	volatile AHCI::HBARegisters* _hba;
+	size_t _num_slots;
+	bool _supports_ncq;
+	AHCIDevice* _ports[AHCI_MAX_PORTS] = {nullptr};
+	kstd::vector<kstd::Arc<AHCIDevice>> _disks;
+};
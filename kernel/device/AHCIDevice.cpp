@@ -0,0 +1,321 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "AHCIDevice.h"
+#include "AHCIController.h"
+#include "ATA.h"
+#include <kernel/IO.h>
+#include <kernel/kstd/KLog.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/tasking/TaskManager.h>
+
+AHCIDevice::AHCIDevice(AHCIController& controller, unsigned port_num, volatile AHCI::PortRegisters* port):
+	DiskDevice(8, port_num), _controller(controller), _port_num(port_num), _port(port)
+{
+	stop();
+
+	//Allocate the command list and received FIS area, and a command table for each slot
+	_command_list_region = MM.alloc_dma_region(sizeof(AHCI::CommandHeader) * AHCI_MAX_SLOTS + AHCI_RECEIVED_FIS_SIZE);
+	_command_table_region = MM.alloc_dma_region(PAGE_SIZE * controller.num_slots());
+	_command_list = (AHCI::CommandHeader*) _command_list_region->start();
+	memset(_command_list, 0, _command_list_region->size());
+	memset((void*) _command_table_region->start(), 0, _command_table_region->size());
+	for(size_t slot = 0; slot < controller.num_slots(); slot++)
+		_command_list[slot].command_table_base = _command_table_region->object()->physical_page(slot).paddr();
+
+	PhysicalAddress command_list_addr = _command_list_region->object()->physical_page(0).paddr();
+	_port->clb = command_list_addr;
+	_port->clbu = 0;
+	_port->fb = command_list_addr + sizeof(AHCI::CommandHeader) * AHCI_MAX_SLOTS;
+	_port->fbu = 0;
+
+	//Clear any errors and pending interrupts, and start the port with interrupts off until the disk is identified
+	_port->serr = _port->serr;
+	_port->is = _port->is;
+	_port->ie = 0;
+	start();
+
+	if(identify().is_error()) {
+		KLog::err("AHCI", "Couldn't identify disk on port %d", port_num);
+		stop();
+		return;
+	}
+
+	_use_ncq = _use_ncq && controller.supports_ncq();
+	size_t num_slots = max_active_requests();
+	_free_slots = num_slots == 32 ? 0xFFFFFFFF : (1u << num_slots) - 1;
+	_port->ie = AHCI_PORT_IS_COMPLETE | AHCI_PORT_IS_ERROR;
+	_present = true;
+
+	if(_use_ncq)
+		KLog::info("AHCI", "Setup disk %s on port %d using NCQ with %d slots (%d blocks)", _model_number, port_num, num_slots, _max_addressable_block);
+	else
+		KLog::info("AHCI", "Setup disk %s on port %d using DMA (%d blocks)", _model_number, port_num, _max_addressable_block);
+}
+
+AHCIDevice::~AHCIDevice() {
+	stop();
+}
+
+void AHCIDevice::stop() {
+	_port->cmd = _port->cmd & ~AHCI_PORT_CMD_ST;
+	while(_port->cmd & AHCI_PORT_CMD_CR);
+	_port->cmd = _port->cmd & ~AHCI_PORT_CMD_FRE;
+	while(_port->cmd & AHCI_PORT_CMD_FR);
+}
+
+void AHCIDevice::start() {
+	while(_port->cmd & AHCI_PORT_CMD_CR);
+	_port->cmd = _port->cmd | AHCI_PORT_CMD_FRE;
+	_port->cmd = _port->cmd | AHCI_PORT_CMD_ST;
+}
+
+void AHCIDevice::recover() {
+	LOCK(_recovery_lock);
+	if(!_port_failed)
+		return;
+
+	//Every command the port was processing has already been failed, and nothing is issued until the flag is cleared
+	stop();
+	_port->serr = _port->serr;
+	_port->is = _port->is;
+	start();
+	_port_failed = false;
+}
+
+Result AHCIDevice::identify() {
+	auto& slot = _slots[0];
+	slot.bounce_region = MM.alloc_dma_region(PAGE_SIZE);
+	use_bounce_prdt(0, 1);
+	prepare_command(0, ATA_IDENTIFY, false, 1);
+	_port->ci = 1;
+
+	//Interrupts aren't enabled for the port yet, so poll for the command to finish (For up to a second or so)
+	for(size_t i = 0; _port->ci & 1; i++) {
+		if((_port->is & AHCI_PORT_IS_ERROR) || i > 100000)
+			return Result(-EIO);
+		IO::wait(10);
+	}
+	if(_port->is & AHCI_PORT_IS_ERROR)
+		return Result(-EIO);
+	_port->is = _port->is;
+
+	//Model is byte-swapped, padded with spaces, and not null-terminated, so let's fix that
+	auto* identity = (uint16_t*) slot.bounce_region->start();
+	auto* model_number = (uint8_t*) &identity[ATA_IDENTITY_MODEL_NUMBER_START];
+	for(auto i = 0; i < ATA_IDENTITY_MODEL_NUMBER_LENGTH; i += 2) {
+		_model_number[i] = (char) model_number[i + 1];
+		_model_number[i + 1] = (char) model_number[i];
+	}
+	for(auto i = ATA_IDENTITY_MODEL_NUMBER_LENGTH - 1; i >= 0 && _model_number[i] == ' '; i--)
+		_model_number[i] = '\0';
+	_model_number[ATA_IDENTITY_MODEL_NUMBER_LENGTH - 1] = '\0';
+
+	//Disk size
+	if(identity[ATA_IDENTITY_COMMAND_SET_2] & ATA_IDENTITY_COMMAND_SET_2_LBA48) {
+		_max_addressable_block = 0;
+		for(int i = 3; i >= 0; i--)
+			_max_addressable_block = (_max_addressable_block << 16) | identity[ATA_IDENTITY_LBA48_SECTORS + i];
+	} else {
+		_max_addressable_block = identity[ATA_IDENTITY_LBA28_SECTORS] | (identity[ATA_IDENTITY_LBA28_SECTORS + 1] << 16);
+	}
+
+	//NCQ support
+	if(identity[ATA_IDENTITY_SATA_CAPABILITIES] & ATA_IDENTITY_SATA_CAPABILITIES_NCQ) {
+		_use_ncq = true;
+		_queue_depth = (identity[ATA_IDENTITY_QUEUE_DEPTH] & 0x1F) + 1;
+	}
+
+	return Result(SUCCESS);
+}
+
+size_t AHCIDevice::acquire_slot() {
+	LOCK(_slot_lock);
+	ASSERT(_free_slots);
+	size_t slot = __builtin_ctz(_free_slots);
+	_free_slots &= ~(1u << slot);
+	return slot;
+}
+
+void AHCIDevice::release_slot(size_t slot) {
+	LOCK(_slot_lock);
+	_free_slots |= 1u << slot;
+}
+
+AHCI::CommandTable& AHCIDevice::command_table(size_t slot) {
+	return *(AHCI::CommandTable*) (_command_table_region->start() + slot * PAGE_SIZE);
+}
+
+Result AHCIDevice::perform_request(BlockRequest& request) {
+	size_t slot = acquire_slot();
+	size_t count = request.total_blocks();
+	bool write = request.type == BlockRequest::Write;
+	Result result = Result(SUCCESS);
+	for(size_t done = 0; done < count;) {
+		//Straight to and from the request's buffers if possible
+		size_t num_entries = 1;
+		size_t num_sectors = build_prdt(slot, request, done, min((size_t) AHCI_MAX_SECTORS_PER_COMMAND, count - done), num_entries);
+		bool bounce = !num_sectors;
+		if(bounce) {
+			num_sectors = min(PAGE_SIZE / 512, count - done);
+			if(!_slots[slot].bounce_region)
+				_slots[slot].bounce_region = MM.alloc_dma_region(PAGE_SIZE);
+			use_bounce_prdt(slot, num_sectors);
+		}
+
+		auto* bounce_buf = bounce ? (uint8_t*) _slots[slot].bounce_region->start() : nullptr;
+		if(bounce && write)
+			request.gather(done, num_sectors, bounce_buf, 512);
+		result = issue_command(slot, write, request.block + done, num_sectors, num_entries);
+		if(result.is_error())
+			break;
+		if(bounce && !write)
+			request.scatter(done, num_sectors, bounce_buf, 512);
+		done += num_sectors;
+	}
+	release_slot(slot);
+	return result;
+}
+
+size_t AHCIDevice::max_active_requests() {
+	return _use_ncq ? min(_controller.num_slots(), _queue_depth) : 1;
+}
+
+size_t AHCIDevice::build_prdt(size_t slot, BlockRequest& request, size_t sector_offset, size_t num_sectors, size_t& num_entries) {
+	auto* prdt = command_table(slot).prdt;
+	BlockRequest::SegmentLimits limits = {
+		.max_segments = AHCI_MAX_PRDT_ENTRIES,
+		.max_segment_size = AHCI_MAX_PRDT_ENTRY_SIZE,
+		.alignment = 2
+	};
+	return request.build_segments(sector_offset, num_sectors, 512, limits, num_entries,
+		[&](size_t entry, PhysicalAddress addr, size_t size) {
+			prdt[entry].addr = addr;
+			prdt[entry].addr_upper = 0;
+			prdt[entry].byte_count = size - 1;
+			prdt[entry].interrupt = 0;
+		});
+}
+
+void AHCIDevice::use_bounce_prdt(size_t slot, size_t num_sectors) {
+	ASSERT(num_sectors <= PAGE_SIZE / 512);
+	auto& entry = command_table(slot).prdt[0];
+	entry.addr = _slots[slot].bounce_region->object()->physical_page(0).paddr();
+	entry.addr_upper = 0;
+	entry.byte_count = num_sectors * 512 - 1;
+	entry.interrupt = 0;
+}
+
+AHCI::FISRegH2D* AHCIDevice::prepare_command(size_t slot, uint8_t command, bool write, size_t num_entries) {
+	auto* fis = (AHCI::FISRegH2D*) command_table(slot).fis;
+	memset(fis, 0, sizeof(AHCI::FISRegH2D));
+	fis->type = AHCI_FIS_TYPE_REG_H2D;
+	fis->is_command = 1;
+	fis->command = command;
+	fis->device = AHCI_FIS_DEVICE_LBA;
+
+	auto& header = _command_list[slot];
+	header.fis_length = sizeof(AHCI::FISRegH2D) / sizeof(uint32_t);
+	header.atapi = 0;
+	header.write = write;
+	header.prefetchable = 0;
+	header.clear_busy = 0;
+	header.prdt_length = num_entries;
+	header.prdt_byte_count = 0;
+	return fis;
+}
+
+Result AHCIDevice::issue_command(size_t slot, bool write, uint64_t lba, size_t num_sectors, size_t num_entries) {
+	uint8_t command;
+	if(_use_ncq)
+		command = write ? ATA_WRITE_FPDMA_QUEUED : ATA_READ_FPDMA_QUEUED;
+	else
+		command = write ? ATA_WRITE_DMA_EXT : ATA_READ_DMA_EXT;
+
+	auto* fis = prepare_command(slot, command, write, num_entries);
+	fis->lba0 = lba & 0xFF;
+	fis->lba1 = (lba >> 8) & 0xFF;
+	fis->lba2 = (lba >> 16) & 0xFF;
+	fis->lba3 = (lba >> 24) & 0xFF;
+	fis->lba4 = (lba >> 32) & 0xFF;
+	fis->lba5 = (lba >> 40) & 0xFF;
+
+	//A count of 0 means 65536 sectors. Queued commands keep the count in the features field and the tag in the count.
+	if(_use_ncq) {
+		fis->feature_low = num_sectors & 0xFF;
+		fis->feature_high = (num_sectors >> 8) & 0xFF;
+		fis->count_low = slot << 3;
+	} else {
+		fis->count_low = num_sectors & 0xFF;
+		fis->count_high = (num_sectors >> 8) & 0xFF;
+	}
+
+	auto& slot_info = _slots[slot];
+	uint32_t slot_bit = 1u << slot;
+	slot_info.blocker.set_ready(false);
+	while(true) {
+		if(_port_failed)
+			recover();
+
+		//Issue the command without the IRQ handler seeing it half-issued, unless the port failed again in the meantime
+		TaskManager::ScopedCritical critical;
+		if(_port_failed)
+			continue;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		_issued_slots = _issued_slots | slot_bit;
+		if(_use_ncq)
+			_port->sact = slot_bit;
+		_port->ci = slot_bit;
+		break;
+	}
+
+	TaskManager::current_thread()->block(slot_info.blocker);
+	return slot_info.result;
+}
+
+void AHCIDevice::handle_irq() {
+	uint32_t status = _port->is;
+	_port->is = status;
+
+	auto complete_slots = [&](uint32_t slots, Result result) {
+		for(size_t slot = 0; slot < AHCI_MAX_SLOTS; slot++) {
+			if(!(slots & (1u << slot)))
+				continue;
+			_slots[slot].result = result;
+			_slots[slot].blocker.set_ready(true);
+		}
+		_issued_slots = _issued_slots & ~slots;
+	};
+
+	if(status & AHCI_PORT_IS_ERROR) {
+		//An error aborts every outstanding command, so fail all of them. The port is restarted before the next command
+		//is issued, since waiting for it to stop doesn't belong in an interrupt handler.
+		KLog::err("AHCI", "Port %d failed with interrupt status 0x%x, task file 0x%x, and SATA error 0x%x",
+				  _port_num, status, _port->tfd, _port->serr);
+		complete_slots(_issued_slots, Result(-EIO));
+		_port_failed = true;
+		return;
+	}
+
+	//Commands are done once the disk clears their bits in the command issue and SATA active registers
+	complete_slots(_issued_slots & ~(_port->ci | _port->sact), Result(SUCCESS));
+}
+
+size_t AHCIDevice::block_size() {
+	return 512;
+}
+
+ssize_t AHCIDevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	// The disk may be larger than a size_t can hold, so compare in blocks
+	if(offset / block_size() >= _max_addressable_block)
+		return 0;
+	uint64_t bytes_left = _max_addressable_block * block_size() - offset;
+	return DiskDevice::read(fd, offset, buffer, (size_t) min((uint64_t) count, bytes_left));
+}
+
+ssize_t AHCIDevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	if((uint64_t) offset + count > _max_addressable_block * block_size())
+		return -ENOSPC;
+	return DiskDevice::write(fd, offset, buffer, count);
+}
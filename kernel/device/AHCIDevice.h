@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "AHCI.h"
+#include "DiskDevice.h"
+#include <kernel/tasking/BooleanBlocker.h>
+
+class AHCIController;
+
+/**
+ * A SATA disk attached to a port of an AHCI controller. Each request that the disk performs gets its own command slot,
+ * so with native command queuing up to one request per slot can be in flight at once.
+ */
+class AHCIDevice: public DiskDevice {
+public:
+	AHCIDevice(AHCIController& controller, unsigned port_num, volatile AHCI::PortRegisters* port);
+	~AHCIDevice() override;
+
+	/** Whether a disk was found on the port and set up successfully. **/
+	bool is_present() const { return _present; }
+	/** Completes the commands that finished. Called by the controller when the port raises an interrupt. **/
+	void handle_irq();
+
+	//BlockDevice
+	size_t block_size() override;
+
+	//File
+	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+
+protected:
+	//DiskDevice
+	Result perform_request(BlockRequest& request) override;
+	size_t max_active_requests() override;
+
+private:
+	struct Slot {
+		UninterruptibleBooleanBlocker blocker;
+		Result result = Result(SUCCESS);
+		kstd::Arc<VMRegion> bounce_region; ///< Allocated the first time a request's buffers can't be DMA'd to directly.
+	};
+
+	/** Stops the port from processing its command list and receiving FISes. **/
+	void stop();
+	/** Starts the port processing its command list and receiving FISes. **/
+	void start();
+	/** Restarts the port after the IRQ handler saw it fail. Called before issuing a command. **/
+	void recover();
+	/** Identifies the disk on the port, polling for the command to finish. **/
+	Result identify();
+
+	/** Takes a free command slot. There's always one, since there are never more active requests than slots. **/
+	size_t acquire_slot();
+	void release_slot(size_t slot);
+	AHCI::CommandTable& command_table(size_t slot);
+
+	/**
+	 * Fills a slot's PRDT with the physical memory backing part of a request, so the disk can transfer to it directly.
+	 * @return The number of sectors the PRDT covers, or 0 if the request's buffers can't be used for DMA.
+	 */
+	size_t build_prdt(size_t slot, BlockRequest& request, size_t sector_offset, size_t num_sectors, size_t& num_entries);
+	/** Issues a read or write command using the PRDT in the given slot, and waits for it to complete. **/
+	Result issue_command(size_t slot, bool write, uint64_t lba, size_t num_sectors, size_t num_entries);
+	/** Points a slot's PRDT at its bounce buffer. **/
+	void use_bounce_prdt(size_t slot, size_t num_sectors);
+	/** Fills in the command header for a command in the given slot, and returns its command FIS to be filled in. **/
+	AHCI::FISRegH2D* prepare_command(size_t slot, uint8_t command, bool write, size_t num_entries);
+
+	AHCIController& _controller;
+	unsigned _port_num;
+	volatile AHCI::PortRegisters* _port;
+	bool _present = false;
+
+	//Drive info
+	char _model_number[40];
+	uint64_t _max_addressable_block = 0;
+	bool _use_ncq = false;
+	size_t _queue_depth = 1;
+
+	//DMA stuff
+	kstd::Arc<VMRegion> _command_list_region; ///< Holds the command list, followed by the received FIS area.
+	kstd::Arc<VMRegion> _command_table_region; ///< Holds one page-sized command table per slot.
+	AHCI::CommandHeader* _command_list = nullptr;
+
+	//Slots
+	Slot _slots[AHCI_MAX_SLOTS];
+	uint32_t _free_slots = 0;
+	volatile uint32_t _issued_slots = 0; ///< Slots with a command the disk hasn't completed yet.
+	volatile bool _port_failed = false; ///< Set by the IRQ handler when the port needs to be restarted.
+	SpinLock _slot_lock;
+	SpinLock _recovery_lock;
+};
@@ -33,6 +33,8 @@
 #define ATA_PACKET            0xA0
 #define ATA_IDENTIFY_PACKET   0xA1
 #define ATA_IDENTIFY          0xEC
+#define ATA_READ_FPDMA_QUEUED  0x60
+#define ATA_WRITE_FPDMA_QUEUED 0x61
 
 //Status
 #define ATA_STATUS_ERR  0b00000001u
@@ -73,12 +75,19 @@
 //Other
 #define ATA_IDENTITY_MODEL_NUMBER_START 27 //Words
 #define ATA_IDENTITY_MODEL_NUMBER_LENGTH 40 //Bytes
+#define ATA_IDENTITY_LBA28_SECTORS 60 //Words
+#define ATA_IDENTITY_QUEUE_DEPTH 75 //Words
+#define ATA_IDENTITY_SATA_CAPABILITIES 76 //Words
+#define ATA_IDENTITY_SATA_CAPABILITIES_NCQ (1u << 8)
+#define ATA_IDENTITY_COMMAND_SET_2 83 //Words
+#define ATA_IDENTITY_COMMAND_SET_2_LBA48 (1u << 10)
+#define ATA_IDENTITY_LBA48_SECTORS 100 //Words
 
 typedef struct __attribute__((packed)) PRDT {
 public:
 	uint32_t addr; //Address of memory region
 	uint16_t size; //Size (in bytes) of region (0 means 64k)
-	uint16_t eot;
+	uint16_t eot; //0x8000 on the last entry of the table
 } PRDT;
 
 typedef struct __attribute__((packed)) ATAIdentity {
@@ -43,6 +43,10 @@ size_t BlockDevice::block_size() {
 	return 0;
 }
 
+Result BlockDevice::sync() {
+	return Result(SUCCESS);
+}
+
 bool BlockDevice::is_block_device() {
 	return true;
 }
@@ -31,6 +31,7 @@ public:
 	virtual Result read_blocks(uint32_t block, uint32_t count, uint8_t *buffer);
 	virtual Result write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer);
 	virtual size_t block_size();
+	Result sync() override;
 
 	bool is_block_device() override;
 };
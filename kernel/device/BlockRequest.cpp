@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "BlockRequest.h"
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+
+BlockRequest::BlockRequest(Type type, size_t block, size_t count, uint8_t* buffer):
+	type(type), block(block), count(count), buffer(buffer) {}
+
+size_t BlockRequest::total_blocks() const {
+	size_t total = 0;
+	for(auto* request = this; request; request = request->next)
+		total += request->count;
+	return total;
+}
+
+void BlockRequest::gather(size_t block_offset, size_t num_blocks, uint8_t* dest, size_t block_size) const {
+	for(auto* request = this; request && num_blocks; request = request->next) {
+		if(block_offset >= request->count) {
+			block_offset -= request->count;
+			continue;
+		}
+		size_t to_copy = min(request->count - block_offset, num_blocks);
+		memcpy(dest, request->buffer + block_offset * block_size, to_copy * block_size);
+		dest += to_copy * block_size;
+		num_blocks -= to_copy;
+		block_offset = 0;
+	}
+}
+
+void BlockRequest::scatter(size_t block_offset, size_t num_blocks, const uint8_t* src, size_t block_size) {
+	for(auto* request = this; request && num_blocks; request = request->next) {
+		if(block_offset >= request->count) {
+			block_offset -= request->count;
+			continue;
+		}
+		size_t to_copy = min(request->count - block_offset, num_blocks);
+		memcpy(request->buffer + block_offset * block_size, src, to_copy * block_size);
+		src += to_copy * block_size;
+		num_blocks -= to_copy;
+		block_offset = 0;
+	}
+}
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/Result.hpp>
+#include <kernel/time/Time.h>
+#include <kernel/tasking/BooleanBlocker.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/kstd/kstdlib.h>
+
+/**
+ * A request to read or write a run of blocks on a DiskDevice. Requests for adjacent blocks may be merged while they
+ * wait in the device's queue, in which case they're chained together and performed as one.
+ */
+class BlockRequest {
+public:
+	enum Type {
+		Read,
+		Write
+	};
+
+	/** Limits on the physical memory segments a disk controller can transfer to or from in a single command. **/
+	struct SegmentLimits {
+		size_t max_segments;
+		size_t max_segment_size;
+		size_t boundary = 0; ///< Segments can't cross a multiple of this many bytes, or 0 if there's no such limit.
+		size_t alignment = 1; ///< The alignment each buffer in the request chain needs to start at.
+	};
+
+	BlockRequest(Type type, size_t block, size_t count, uint8_t* buffer);
+
+	/** The number of blocks in this request and every request merged into it. **/
+	size_t total_blocks() const;
+	/** The block right after the last block of this request and every request merged into it. **/
+	size_t end_block() const { return block + total_blocks(); }
+
+	/** Copies num_blocks blocks starting block_offset blocks into the request chain's buffers to dest. **/
+	void gather(size_t block_offset, size_t num_blocks, uint8_t* dest, size_t block_size) const;
+	/** Copies num_blocks blocks from src into the request chain's buffers, starting block_offset blocks in. **/
+	void scatter(size_t block_offset, size_t num_blocks, const uint8_t* src, size_t block_size);
+
+	/**
+	 * Walks the physical memory backing num_blocks blocks of the request chain starting block_offset blocks in,
+	 * merging physically adjacent pages into segments within the given limits. set_segment(index, addr, size) is
+	 * called whenever a segment is added or grows so that the driver can fill in its own table; only the first
+	 * num_segments segments are valid once it returns.
+	 * @return The number of whole blocks the segments cover, or 0 if the buffers can't be used for DMA.
+	 */
+	template<typename SetSegmentF>
+	size_t build_segments(size_t block_offset, size_t num_blocks, size_t block_size, const SegmentLimits& limits,
+						  size_t& num_segments, SetSegmentF set_segment) const;
+
+	const Type type;
+	const size_t block;
+	const size_t count;
+	uint8_t* const buffer;
+	BlockRequest* next = nullptr; ///< The request merged after this one, which starts where this one ends.
+	Time submitted_at;
+	Result result = Result(SUCCESS);
+	bool done = false;
+	bool dispatch = false; ///< Set when the thread that submitted this request has to perform it.
+	UninterruptibleBooleanBlocker blocker;
+};
+
+template<typename SetSegmentF>
+size_t BlockRequest::build_segments(size_t block_offset, size_t num_blocks, size_t block_size, const SegmentLimits& limits,
+									size_t& num_segments, SetSegmentF set_segment) const
+{
+	size_t max_bytes = num_blocks * block_size;
+	while(true) {
+		PhysicalAddress segment_addr = 0;
+		size_t segment_size = 0;
+		size_t total_bytes = 0;
+		size_t offset = block_offset;
+		bool full = false;
+		num_segments = 0;
+
+		for(auto* request = this; request && total_bytes < max_bytes && !full; request = request->next) {
+			if(offset >= request->count) {
+				offset -= request->count;
+				continue;
+			}
+
+			auto vaddr = (VirtualAddress) request->buffer + offset * block_size;
+			size_t buffer_bytes = min((request->count - offset) * block_size, max_bytes - total_bytes);
+			offset = 0;
+			if(vaddr % limits.alignment)
+				return 0;
+
+			while(buffer_bytes) {
+				size_t piece = min(PAGE_SIZE - vaddr % PAGE_SIZE, buffer_bytes);
+				size_t paddr = MM.kernel_page_directory.get_physaddr(vaddr);
+				if(paddr == (size_t) -1)
+					return 0;
+
+				//Extend the last segment if this piece follows it physically and it stays within the limits
+				if(num_segments
+					&& segment_addr + segment_size == paddr
+					&& segment_size + piece <= limits.max_segment_size
+					&& (!limits.boundary || segment_addr / limits.boundary == (paddr + piece - 1) / limits.boundary))
+				{
+					segment_size += piece;
+				} else {
+					if(num_segments == limits.max_segments) {
+						full = true;
+						break;
+					}
+					segment_addr = paddr;
+					segment_size = piece;
+					num_segments++;
+				}
+				set_segment(num_segments - 1, segment_addr, segment_size);
+
+				vaddr += piece;
+				buffer_bytes -= piece;
+				total_bytes += piece;
+			}
+		}
+
+		//Only whole blocks can be transferred, so if the table filled up partway through one, build it again up to the
+		//last whole block. That covers a prefix of the same segments, so it's sure to fit.
+		size_t excess = total_bytes % block_size;
+		if(!excess)
+			return num_segments ? total_bytes / block_size : 0;
+		max_bytes = total_bytes - excess;
+		if(!max_bytes)
+			return 0;
+	}
+}
@@ -22,58 +22,205 @@
 #include <kernel/memory/MemoryManager.h>
 #include "DiskDevice.h"
 #include "kernel/kstd/KLog.h"
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/SleepBlocker.h>
 
 size_t DiskDevice::s_used_cache_memory = 0;
 kstd::vector<DiskDevice*> DiskDevice::s_disk_devices;
 SpinLock DiskDevice::s_disk_devices_lock;
+Atomic<size_t, MemoryOrder::SeqCst> DiskDevice::s_dirty_pages = 0;
+SpinLock DiskDevice::s_flush_lock;
+kstd::Arc<VMRegion> DiskDevice::s_flush_buffer;
+SpinLock DiskDevice::s_prefetch_lock;
+BooleanBlocker DiskDevice::s_prefetch_blocker;
+kstd::vector<DiskDevice::PrefetchRequest> DiskDevice::s_prefetch_requests;
+
+void kflusher_entry() {
+	while(true) {
+		auto blocker = SleepBlocker(Time(DISK_FLUSH_INTERVAL_MS / 1000, (DISK_FLUSH_INTERVAL_MS % 1000) * 1000));
+		TaskManager::current_thread()->block(blocker);
+
+		// Write back everything if too much of the cache is dirty, otherwise just what has been dirty for too long
+		size_t dirty_pages = DiskDevice::s_dirty_pages.load();
+		size_t cache_pages = DiskDevice::s_used_cache_memory / PAGE_SIZE;
+		bool only_expired = dirty_pages < DISK_DIRTY_MIN_PAGES || dirty_pages < cache_pages / DISK_DIRTY_BACKGROUND_RATIO;
+
+		for(auto& device : DiskDevice::disk_devices()) {
+			auto res = device->write_back(only_expired);
+			if(res.is_error())
+				KLog::err("DiskDevice", "Error writing back cache for device %d,%d: %d", device->major(), device->minor(), res.code());
+		}
+	}
+}
+
+void kprefetch_entry() {
+	while(true) {
+		DiskDevice::PrefetchRequest request;
+		{
+			LOCK(DiskDevice::s_prefetch_lock);
+			if(DiskDevice::s_prefetch_requests.empty()) {
+				DiskDevice::s_prefetch_blocker.set_ready(false);
+				request.device = nullptr;
+			} else {
+				request = DiskDevice::s_prefetch_requests[0];
+				DiskDevice::s_prefetch_requests.erase(0);
+			}
+		}
+
+		if(!request.device) {
+			TaskManager::current_thread()->block(DiskDevice::s_prefetch_blocker);
+			continue;
+		}
+
+		// Read in whatever part of the request isn't cached yet, as few requests to the disk as possible
+		auto device = request.device;
+		for(size_t page = 0; page < request.num_pages; page++) {
+			size_t block = request.start_block + page * device->blocks_per_cache_region();
+			{
+				LOCK(device->_cache_lock);
+				if(device->_cache_regions.contains(block))
+					continue;
+			}
+			auto res = device->get_cache_region(block, request.num_pages - page);
+			if(res.is_error())
+				break;
+		}
+	}
+}
 
 DiskDevice::DiskDevice(unsigned int major, unsigned int minor): BlockDevice(major, minor) {
 	s_disk_devices.push_back(this);
 }
 
 DiskDevice::~DiskDevice() {
-	LOCK(s_disk_devices_lock);
-	for(size_t i = 0; i < s_disk_devices.size(); i++) {
-		if(s_disk_devices[i] == this) {
-			s_disk_devices.erase(i);
-			break;
+	{
+		LOCK(s_disk_devices_lock);
+		for(size_t i = 0; i < s_disk_devices.size(); i++) {
+			if(s_disk_devices[i] == this) {
+				s_disk_devices.erase(i);
+				break;
+			}
 		}
 	}
+
+	LOCK(s_prefetch_lock);
+	for(size_t i = 0; i < s_prefetch_requests.size();) {
+		if(s_prefetch_requests[i].device == this)
+			s_prefetch_requests.erase(i);
+		else
+			i++;
+	}
 };
 
 Result DiskDevice::read_blocks(uint32_t start_block, uint32_t count, uint8_t* buffer) {
-	kstd::Arc<BlockCacheRegion> cache_region;
-	for(size_t i = 0; i < count; i++) {
-		size_t block = start_block + i;
-		if(!cache_region || !cache_region->has_block(block))
-			cache_region = get_cache_region(block);
-		LOCK(cache_region->lock);
-		cache_region->last_used = Time::now();
-		memcpy(buffer + i * block_size(), cache_region->block_data(block), block_size());
-	}
-	return Result(SUCCESS);
+	return cached_read(start_block, 0, KernelPointer<uint8_t>(buffer), count * block_size());
 }
 
 Result DiskDevice::write_blocks(uint32_t start_block, uint32_t count, const uint8_t* buffer) {
-	kstd::Arc<BlockCacheRegion> cache_region;
-	for(size_t i = 0; i < count; i++) {
-		size_t block = start_block + i;
-		if(!cache_region || !cache_region->has_block(block))
-			cache_region = get_cache_region(block);
-		LOCK(cache_region->lock);
-		cache_region->last_used = Time::now();
-		cache_region->dirty = true;
-		memcpy(cache_region->block_data(block), buffer + i * block_size(), block_size());
+	return cached_write(start_block, 0, KernelPointer<uint8_t>((uint8_t*) buffer), count * block_size());
+}
+
+void DiskDevice::prefetch(size_t offset, size_t count) {
+	if(!count)
+		return;
+	size_t start_block = block_cache_region_start(offset / block_size());
+	size_t end_block = (offset + count + block_size() - 1) / block_size();
+	size_t num_pages = (end_block - start_block + blocks_per_cache_region() - 1) / blocks_per_cache_region();
+
+	LOCK(s_prefetch_lock);
+	if(s_prefetch_requests.size() >= DISK_MAX_PREFETCH_REQUESTS)
+		return;
+	for(auto& request : s_prefetch_requests) {
+		if(request.device == this && request.start_block == start_block)
+			return;
 	}
+	s_prefetch_requests.push_back({this, start_block, num_pages});
+	s_prefetch_blocker.set_ready(true);
+}
+
+ssize_t DiskDevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	auto res = cached_read(offset / block_size(), offset % block_size(), buffer, count);
+	if(res.is_error())
+		return res.code();
+	return count;
+}
+
+ssize_t DiskDevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	auto res = cached_write(offset / block_size(), offset % block_size(), buffer, count);
+	if(res.is_error())
+		return res.code();
+	return count;
+}
 
-	//TODO: Flush cached writes to disk periodically instead of on every write
-	return write_uncached_blocks(start_block, count, buffer);
+Result DiskDevice::sync() {
+	return write_back(false);
+}
+
+Result DiskDevice::sync_range(size_t offset, size_t count) {
+	if(!count)
+		return Result(SUCCESS);
+	return write_back(false, offset / block_size(), (offset + count + block_size() - 1) / block_size());
+}
+
+Result DiskDevice::sync_all() {
+	Result ret = Result(SUCCESS);
+	for(auto& device : disk_devices()) {
+		auto res = device->write_back(false);
+		if(res.is_error())
+			ret = res;
+	}
+	return ret;
 }
 
 size_t DiskDevice::used_cache_memory() {
 	return s_used_cache_memory;
 }
 
+size_t DiskDevice::dirty_cache_memory() {
+	return s_dirty_pages.load() * PAGE_SIZE;
+}
+
+kstd::vector<kstd::Arc<DiskDevice>> DiskDevice::disk_devices() {
+	LOCK(s_disk_devices_lock);
+	kstd::vector<kstd::Arc<DiskDevice>> devices;
+	devices.reserve(s_disk_devices.size());
+	for(auto device : s_disk_devices) {
+		// Devices that have been removed have no references left to take
+		auto device_ptr = device->shared_ptr();
+		if(device_ptr)
+			devices.push_back(kstd::static_pointer_cast<DiskDevice>(device_ptr));
+	}
+	return devices;
+}
+
+void DiskDevice::iterate_devices(kstd::IterationFunc<DiskDevice*> callback) {
+	LOCK(s_disk_devices_lock);
+	for(auto device : s_disk_devices)
+		ITER_BREAK(callback(device));
+}
+
+DiskDevice::Stats DiskDevice::stats() {
+	Stats stats;
+	{
+		LOCK(_cache_lock);
+		stats.hits = _cache_hits;
+		stats.misses = _cache_misses;
+		stats.evictions = _cache_evictions;
+		stats.cached_pages = _cache_regions.size();
+	}
+	{
+		LOCK(_dirty_lock);
+		stats.dirty_pages = _dirty_regions.size();
+	}
+	LOCK(_queue_lock);
+	stats.reads = _num_reads;
+	stats.writes = _num_writes;
+	stats.merges = _num_merges;
+	stats.queue_depth = _request_queue.size() + _num_active_requests;
+	stats.service_time = _service_time;
+	return stats;
+}
+
 size_t DiskDevice::free_pages(size_t num_pages) {
 	size_t num_freed = 0;
 	LOCK(s_disk_devices_lock);
@@ -102,14 +249,24 @@ size_t DiskDevice::free_pages(size_t num_pages) {
 			break;
 
 		// Flush it if necessary
-		if(lru_region->dirty)
-			lru_device->write_uncached_blocks(lru_region->start_block, lru_region->num_blocks(), (uint8_t*) lru_region->region->start());
+		{
+			LOCK_N(lru_region->lock, region_lock);
+			if(lru_region->dirty) {
+				lru_device->write_uncached_blocks(lru_region->start_block, lru_region->num_blocks(), (uint8_t*) lru_region->region->start());
+				lru_region->dirty = false;
+				s_dirty_pages.sub(1);
+				LOCK_N(lru_device->_dirty_lock, dirty_lock);
+				lru_device->_dirty_regions.erase(lru_region->start_block);
+			}
+		}
 
 		// Free it
 		num_freed += lru_region->region->size() / PAGE_SIZE;
 		s_used_cache_memory -= lru_region->region->size();
+		LOCK_N(lru_device->_cache_lock, device_lock);
+		lru_device->_cache_regions.erase(lru_region->start_block);
+		lru_device->_cache_evictions++;
 		lru_region.reset();
-		lru_device->_cache_regions.prune(1);
 	}
 
 	if(num_freed != num_pages)
@@ -118,35 +275,414 @@ size_t DiskDevice::free_pages(size_t num_pages) {
 	return num_freed;
 }
 
-kstd::Arc<DiskDevice::BlockCacheRegion> DiskDevice::get_cache_region(size_t block) {
-	_cache_lock.acquire();
+Result DiskDevice::cached_read(size_t start_block, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	size_t nread = 0;
+	while(nread < count) {
+		size_t skip = offset + nread;
+		size_t block = start_block + skip / block_size();
+		size_t region_start = block_cache_region_start(block);
+		size_t region_offset = (block - region_start) * block_size() + skip % block_size();
+		size_t bytes_left = count - nread;
+		auto out = SafePointer<uint8_t>(buffer.raw() + nread, buffer.is_user());
+
+		// Copy it out of the cache, reading the rest of the request along with it on a miss
+		size_t pages_left = (region_offset + bytes_left + PAGE_SIZE - 1) / PAGE_SIZE;
+		size_t to_copy = min(PAGE_SIZE - region_offset, bytes_left);
+		auto region = TRY(get_cache_region(block, pages_left));
+		{
+			LOCK(region->lock);
+			region->last_used = Time::now();
+		}
+
+		// Our reference keeps the page alive even if it's evicted. We can't hold the region's lock while copying,
+		// since faulting in the buffer may need to read from the disk and take cache locks of its own.
+		out.write((uint8_t*) region->region->start() + region_offset, to_copy);
+		nread += to_copy;
+	}
+	return Result(SUCCESS);
+}
+
+Result DiskDevice::cached_write(size_t start_block, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	size_t nwritten = 0;
+	while(nwritten < count) {
+		size_t skip = offset + nwritten;
+		size_t block = start_block + skip / block_size();
+		size_t region_start = block_cache_region_start(block);
+		size_t region_offset = (block - region_start) * block_size() + skip % block_size();
+		size_t to_copy = min(PAGE_SIZE - region_offset, count - nwritten);
+		auto in = SafePointer<uint8_t>(buffer.raw() + nwritten, buffer.is_user());
+
+		if(to_copy == PAGE_SIZE) {
+			// We're overwriting the whole region, so there's no need to read it first
+			overwrite_cache_region(region_start, in);
+		} else {
+			// Copy the data in before taking the region's lock, since faulting in the buffer may need to read from the
+			// disk (see cached_read). The region itself is only modified with its lock held, so that a write back
+			// never snapshots it half-written.
+			uint8_t data[PAGE_SIZE];
+			in.read(data, to_copy);
+			auto region = TRY(get_cache_region(block));
+			LOCK(region->lock);
+			memcpy((uint8_t*) region->region->start() + region_offset, data, to_copy);
+			region->last_used = Time::now();
+			mark_dirty(region);
+		}
+		nwritten += to_copy;
+	}
+
+	// The writes will be written back by the flusher thread, unless there's too much dirty data already.
+	size_t dirty_pages = s_dirty_pages.load();
+	if(dirty_pages > DISK_DIRTY_MIN_PAGES && dirty_pages > s_used_cache_memory / PAGE_SIZE / DISK_DIRTY_LIMIT_RATIO)
+		return write_back(false);
+	return Result(SUCCESS);
+}
+
+ResultRet<kstd::Arc<DiskDevice::BlockCacheRegion>> DiskDevice::get_cache_region(size_t block, size_t max_pages) {
+	size_t start_block = block_cache_region_start(block);
+	kstd::Arc<BlockCacheRegion> cached_reg;
+	kstd::vector<kstd::Arc<BlockCacheRegion>> regions;
+	{
+		LOCK(_cache_lock);
+
+		//See if we already have the block
+		auto reg_opt = _cache_regions.get(start_block);
+		if(reg_opt) {
+			_cache_hits++;
+			cached_reg = reg_opt.value();
+		} else {
+			//Read as many of the following uncached regions as we can in the same request
+			size_t num_pages = 1;
+			max_pages = min(max_pages, (size_t) DISK_MAX_READ_PAGES);
+			while(num_pages < max_pages && !_cache_regions.contains(start_block + num_pages * blocks_per_cache_region()))
+				num_pages++;
+			_cache_misses += num_pages;
+
+			//Put the regions in the cache before reading them, so that anyone else looking for them waits for our read
+			//instead of starting their own, and the cache can be used by everyone else while we read
+			regions.reserve(num_pages);
+			for(size_t i = 0; i < num_pages; i++) {
+				auto reg = kstd::Arc<BlockCacheRegion>::make(start_block + i * blocks_per_cache_region(), block_size());
+				reg->filled.set_ready(false);
+				s_used_cache_memory += PAGE_SIZE;
+				_cache_regions.insert(reg->start_block, reg);
+				regions.push_back(reg);
+			}
+
+			//The requested region should be the most recently used
+			_cache_regions.promote(start_block);
+		}
+	}
+
+	if(cached_reg) {
+		auto fill_res = wait_for_fill(cached_reg);
+		if(fill_res.is_error())
+			return fill_res;
+		return cached_reg;
+	}
+
+	auto res = transfer_regions(BlockRequest::Read, regions);
+	if(res.is_error()) {
+		//Take the regions back out of the cache, unless they've been evicted already
+		LOCK(_cache_lock);
+		for(auto& reg : regions) {
+			if(!_cache_regions.contains(reg->start_block))
+				continue;
+			auto cur_reg = _cache_regions.get(reg->start_block);
+			if(cur_reg.value() == reg) {
+				s_used_cache_memory -= PAGE_SIZE;
+				_cache_regions.erase(reg->start_block);
+			}
+		}
+	}
+
+	for(auto& reg : regions) {
+		reg->fill_result = res;
+		reg->filled.set_ready(true);
+	}
+	if(res.is_error())
+		return res;
+	return regions[0];
+}
+
+Result DiskDevice::wait_for_fill(const kstd::Arc<BlockCacheRegion>& region) {
+	if(!region->filled.is_ready())
+		TaskManager::current_thread()->block(region->filled);
+	return region->fill_result;
+}
+
+void DiskDevice::overwrite_cache_region(size_t start_block, SafePointer<uint8_t> buffer) {
+	// Like in cached_write, copy the data in before taking any locks
+	uint8_t data[PAGE_SIZE];
+	buffer.read(data, PAGE_SIZE);
+
+	kstd::Arc<BlockCacheRegion> new_reg;
+	while(true) {
+		kstd::Arc<BlockCacheRegion> reg;
+		{
+			LOCK(_cache_lock);
+			auto reg_opt = _cache_regions.get(start_block);
+			if(reg_opt) {
+				reg = reg_opt.value();
+			} else if(new_reg) {
+				s_used_cache_memory += PAGE_SIZE;
+				_cache_regions.insert(start_block, new_reg);
+				LOCK_N(new_reg->lock, region_lock);
+				mark_dirty(new_reg);
+				return;
+			}
+		}
+
+		if(reg) {
+			//If the region is still being read, wait so the read doesn't clobber our data. If the read failed, the
+			//region has been taken out of the cache, so look again.
+			if(wait_for_fill(reg).is_error())
+				continue;
+			LOCK(reg->lock);
+			memcpy((void*) reg->region->start(), data, PAGE_SIZE);
+			reg->last_used = Time::now();
+			mark_dirty(reg);
+			return;
+		}
+
+		//Nobody else can see the new region until it's in the cache, so fill it in first
+		new_reg = kstd::Arc<BlockCacheRegion>::make(start_block, block_size());
+		memcpy((void*) new_reg->region->start(), data, PAGE_SIZE);
+	}
+}
+
+Result DiskDevice::read_uncached_blocks(uint32_t block, uint32_t count, uint8_t* buffer) {
+	BlockRequest request(BlockRequest::Read, block, count, buffer);
+	return submit_request(request);
+}
+
+Result DiskDevice::write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	BlockRequest request(BlockRequest::Write, block, count, (uint8_t*) buffer);
+	return submit_request(request);
+}
+
+Result DiskDevice::submit_request(BlockRequest& request) {
+	auto now = Time::now();
+	for(auto* cur_request = &request; cur_request; cur_request = cur_request->next)
+		cur_request->submitted_at = now;
+	{
+		LOCK(_queue_lock);
+		if(!merge_request(request)) {
+			size_t index = 0;
+			while(index < _request_queue.size() && _request_queue[index]->block <= request.block)
+				index++;
+			_request_queue.insert(index, &request);
+		}
 
-	//See if we already have the block
-	auto reg_opt = _cache_regions.get(block_cache_region_start(block));
-	if(reg_opt) {
-		_cache_lock.release();
-		return reg_opt.value();
+		// If the disk can take on more requests, they can be performed right away
+		dispatch_requests();
 	}
 
-	//Create a new cache region
-	auto reg = kstd::Arc<BlockCacheRegion>::make(block_cache_region_start(block), block_size());
-	s_used_cache_memory += PAGE_SIZE;
-	reg->lock.acquire();
-	_cache_regions.insert(block_cache_region_start(block), reg);
+	while(true) {
+		TaskManager::current_thread()->block(request.blocker);
+		if(request.done)
+			return request.result;
 
-	//Read the blocks into it
-	read_uncached_blocks(reg->start_block, blocks_per_cache_region(), (uint8_t*) reg->region->start());
+		// The disk was handed to us, so perform our request along with everything merged into it
+		ASSERT(request.dispatch);
+		auto result = perform_request(request);
+		now = Time::now();
 
-	//TODO: Figure out how to read the block after releasing the cache lock so that other blocks can be used in the meantime
-	//(We cannot do this currently as that would result in acquiring / releasing locks in the wrong order)
-	reg->lock.release();
-	_cache_lock.release();
+		LOCK(_queue_lock);
+		auto* cur_request = &request;
+		while(cur_request) {
+			// Other requests may be gone as soon as they're marked done, so get the next one first
+			auto* next = cur_request->next;
+			auto service_time = now - cur_request->submitted_at;
+			_service_time += service_time.sec() * 1000000 + service_time.usec();
+			if(cur_request->type == BlockRequest::Read)
+				_num_reads++;
+			else
+				_num_writes++;
+			cur_request->result = result;
+			cur_request->done = true;
+			cur_request->blocker.set_ready(true);
+			cur_request = next;
+		}
 
-	//Return the requested region
-	return reg;
+		// Hand the disk over to whoever submitted the next request
+		_num_active_requests--;
+		dispatch_requests();
+	}
+}
+
+void DiskDevice::dispatch_requests() {
+	while(_num_active_requests < max_active_requests()) {
+		auto* request = next_request();
+		if(!request)
+			return;
+		_head_position = request->end_block();
+		_num_active_requests++;
+		request->dispatch = true;
+		request->blocker.set_ready(true);
+	}
+}
+
+bool DiskDevice::merge_request(BlockRequest& request) {
+	size_t max_blocks = DISK_MAX_MERGED_PAGES * blocks_per_cache_region();
+	for(size_t i = 0; i < _request_queue.size(); i++) {
+		auto* queued = _request_queue[i];
+		if(queued->type != request.type || queued->total_blocks() + request.total_blocks() > max_blocks)
+			continue;
+
+		if(queued->end_block() == request.block) {
+			// The request starts where the queued one ends, so tack it onto the end
+			auto* last = queued;
+			while(last->next)
+				last = last->next;
+			last->next = &request;
+			_num_merges++;
+			return true;
+		}
+
+		if(request.end_block() == queued->block) {
+			// The request ends where the queued one starts, so it takes the queued one's place
+			auto* last = &request;
+			while(last->next)
+				last = last->next;
+			last->next = queued;
+			_request_queue[i] = &request;
+			_num_merges++;
+			return true;
+		}
+	}
+	return false;
+}
+
+BlockRequest* DiskDevice::next_request() {
+	if(_request_queue.empty())
+		return nullptr;
+
+	// Keep moving in the same direction across the disk, and go back to the lowest request once we reach the end
+	size_t index = 0;
+	while(index < _request_queue.size() && _request_queue[index]->block < _head_position)
+		index++;
+	if(index == _request_queue.size())
+		index = 0;
+
+	auto* request = _request_queue[index];
+	_request_queue.erase(index);
+	return request;
+}
+
+Result DiskDevice::write_back(bool only_expired, size_t start_block, size_t end_block) {
+	LOCK(s_flush_lock);
+
+	// Take the dirty regions off of the dirty list. If they're written to again before we write them back, they'll
+	// stay dirty and we'll write back the new data. If they're written to afterwards, they'll be put back on the list.
+	kstd::vector<kstd::Arc<BlockCacheRegion>> regions;
+	auto expire_time = Time::now() - Time(DISK_DIRTY_EXPIRE_MS / 1000, (DISK_DIRTY_EXPIRE_MS % 1000) * 1000);
+	{
+		LOCK(_dirty_lock);
+		if(_dirty_regions.empty())
+			return Result(SUCCESS);
+		regions.reserve(_dirty_regions.size());
+		for(auto& pair : _dirty_regions) {
+			if(pair.first + blocks_per_cache_region() > start_block && pair.first < end_block)
+				regions.push_back(pair.second);
+		}
+	}
+
+	// Split the regions into runs of adjacent regions and write back each run that needs it
+	Result ret = Result(SUCCESS);
+	kstd::vector<kstd::Arc<BlockCacheRegion>> run;
+	bool run_expired = false;
+	auto finish_run = [&] {
+		if(!run.empty() && (run_expired || !only_expired)) {
+			{
+				LOCK(_dirty_lock);
+				for(auto& region : run)
+					_dirty_regions.erase(region->start_block);
+			}
+			auto res = write_back_run(run);
+			if(res.is_error())
+				ret = res;
+		}
+		run.resize(0);
+		run_expired = false;
+	};
+
+	for(auto& region : regions) {
+		bool adjacent = !run.empty() && run[run.size() - 1]->start_block + blocks_per_cache_region() == region->start_block;
+		if(!adjacent || run.size() == DISK_MAX_FLUSH_PAGES)
+			finish_run();
+		run.push_back(region);
+		if(region->dirtied_at <= expire_time)
+			run_expired = true;
+	}
+	finish_run();
+
+	return ret;
+}
+
+Result DiskDevice::write_back_run(kstd::vector<kstd::Arc<BlockCacheRegion>>& run) {
+	ASSERT(run.size() <= DISK_MAX_FLUSH_PAGES);
+	if(!s_flush_buffer)
+		s_flush_buffer = MM.alloc_kernel_region(DISK_MAX_FLUSH_PAGES * PAGE_SIZE);
+
+	// Write back a snapshot of the regions instead of the regions themselves, so they can't be modified while the disk
+	// is reading them. If a region is written to again after its snapshot is taken, it'll be marked dirty again and
+	// written back later.
+	auto* snapshot = (uint8_t*) s_flush_buffer->start();
+	size_t num_written = 0;
+	for(size_t i = 0; i < run.size(); i++) {
+		auto& region = run[i];
+		LOCK(region->lock);
+		memcpy(snapshot + i * PAGE_SIZE, (void*) region->region->start(), PAGE_SIZE);
+		if(region->dirty) {
+			region->dirty = false;
+			num_written++;
+		}
+	}
+	s_dirty_pages.sub(num_written);
+
+	auto res = write_uncached_blocks(run[0]->start_block, run.size() * blocks_per_cache_region(), snapshot);
+	if(res.is_error()) {
+		// Put the regions back on the dirty list so we can try again later
+		for(auto& region : run) {
+			LOCK(region->lock);
+			mark_dirty(region);
+		}
+	}
+	return res;
+}
+
+Result DiskDevice::transfer_regions(BlockRequest::Type type, kstd::vector<kstd::Arc<BlockCacheRegion>>& regions) {
+	ASSERT(regions.size() <= DISK_MAX_READ_PAGES);
+
+	// Chain together a request for each region so the driver can transfer straight to or from their pages at once
+	alignas(BlockRequest) uint8_t storage[DISK_MAX_READ_PAGES * sizeof(BlockRequest)];
+	auto* requests = (BlockRequest*) storage;
+	for(size_t i = 0; i < regions.size(); i++) {
+		auto& region = regions[i];
+		new (&requests[i]) BlockRequest(type, region->start_block, blocks_per_cache_region(), (uint8_t*) region->region->start());
+		if(i)
+			requests[i - 1].next = &requests[i];
+	}
+	auto res = submit_request(requests[0]);
+	for(size_t i = 0; i < regions.size(); i++)
+		requests[i].~BlockRequest();
+	return res;
+}
+
+void DiskDevice::mark_dirty(const kstd::Arc<BlockCacheRegion>& region) {
+	if(region->dirty)
+		return;
+	region->dirty = true;
+	region->dirtied_at = Time::now();
+	s_dirty_pages.add(1);
+	LOCK(_dirty_lock);
+	_dirty_regions.insert({region->start_block, region});
 }
 
 DiskDevice::BlockCacheRegion::BlockCacheRegion(size_t start_block, size_t block_size):
-		region(MemoryManager::inst().alloc_kernel_region(PAGE_SIZE)), block_size(block_size), start_block(start_block) {}
+		region(MemoryManager::inst().alloc_kernel_region(PAGE_SIZE)), block_size(block_size), start_block(start_block)
+{
+	filled.set_ready(true);
+}
 
 DiskDevice::BlockCacheRegion::~BlockCacheRegion() = default;
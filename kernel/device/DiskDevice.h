@@ -22,7 +22,33 @@
 #include <kernel/time/Time.h>
 #include <kernel/memory/MemoryManager.h>
 #include "BlockDevice.h"
+#include "BlockRequest.h"
 #include "../kstd/LRUCache.h"
+#include "../kstd/map.hpp"
+#include "../kstd/Iteration.h"
+#include "../tasking/BooleanBlocker.h"
+
+/** How often the flusher thread writes back dirty cache regions. **/
+#define DISK_FLUSH_INTERVAL_MS 1000
+/** How long a cache region can stay dirty before the flusher writes it back. **/
+#define DISK_DIRTY_EXPIRE_MS 5000
+/** If more than 1/N of the cache is dirty, the flusher writes all of it back instead of just the expired regions. **/
+#define DISK_DIRTY_BACKGROUND_RATIO 10
+/** If more than 1/N of the cache is dirty, writers have to write back the cache themselves before continuing. **/
+#define DISK_DIRTY_LIMIT_RATIO 4
+/** The minimum number of dirty pages before either of the ratios above apply. **/
+#define DISK_DIRTY_MIN_PAGES 64
+/** The maximum number of adjacent dirty cache regions merged into a single write. **/
+#define DISK_MAX_FLUSH_PAGES 16
+/** The maximum number of uncached pages read from the disk in a single request. **/
+#define DISK_MAX_READ_PAGES 16
+/** The maximum number of prefetch requests that can be waiting to be handled. Further requests are dropped. **/
+#define DISK_MAX_PREFETCH_REQUESTS 32
+/** The maximum number of blocks queued requests can be merged into, in pages. **/
+#define DISK_MAX_MERGED_PAGES 32
+
+void kflusher_entry();
+void kprefetch_entry();
 
 class DiskDevice: public BlockDevice {
 public:
@@ -32,13 +58,53 @@ public:
 	Result read_blocks(uint32_t block, uint32_t count, uint8_t *buffer) override final;
 	Result write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override final;
 
-	virtual Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) = 0;
-	virtual Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) = 0;
+	/** Reads blocks straight from the disk, bypassing the cache. The read is queued behind any other requests. **/
+	Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer);
+	/** Writes blocks straight to the disk, bypassing the cache. The write is queued behind any other requests. **/
+	Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer);
 
+	Result sync() override final;
+
+	//File
+	void prefetch(size_t offset, size_t count) override;
+	Result sync_range(size_t offset, size_t count) override;
+	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+
+	/** Writes back the dirty cache regions of every disk. **/
+	static Result sync_all();
 	static size_t used_cache_memory();
+	static size_t dirty_cache_memory();
+	/** Returns a reference to every disk device, so they can be used without holding the device list's lock. **/
+	static kstd::vector<kstd::Arc<DiskDevice>> disk_devices();
+	/** Calls the given function for each disk device. **/
+	static void iterate_devices(kstd::IterationFunc<DiskDevice*> callback);
 	/** Tries to free a number of pages from the cache. Returns the number of pages that could be freed. **/
 	static size_t free_pages(size_t num_pages);
 
+	struct Stats {
+		size_t hits; ///< The number of lookups that were served from the cache.
+		size_t misses; ///< The number of lookups that had to read from the disk.
+		size_t evictions; ///< The number of regions freed from the cache to reclaim memory.
+		size_t cached_pages; ///< The number of pages currently in the cache.
+		size_t dirty_pages; ///< The number of cached pages waiting to be written back.
+		size_t reads; ///< The number of read requests performed.
+		size_t writes; ///< The number of write requests performed.
+		size_t merges; ///< The number of requests that were merged into another queued request.
+		size_t queue_depth; ///< The number of requests currently queued or being performed.
+		uint64_t service_time; ///< The total time requests took from being submitted to completing, in microseconds.
+	};
+	Stats stats();
+
+protected:
+	/**
+	 * Performs a request on the disk, along with every request merged into it. Requests are performed by the threads
+	 * that submitted them, and up to max_active_requests() of them may be performed at once.
+	 */
+	virtual Result perform_request(BlockRequest& request) = 0;
+	/** The number of requests the disk can have in flight at once. **/
+	virtual size_t max_active_requests() { return 1; }
+
 private:
 	class BlockCacheRegion {
 	public:
@@ -53,19 +119,94 @@ private:
 		size_t block_size;
 		size_t start_block;
 		Time last_used = Time::now();
+		Time dirtied_at;
 		bool dirty = false;
 		SpinLock lock;
+		UninterruptibleBooleanBlocker filled; ///< Ready once the region's data is in memory.
+		Result fill_result = Result(SUCCESS); ///< The result of reading the region from the disk, once it's filled.
 	};
 
+	friend void kflusher_entry();
+	friend void kprefetch_entry();
+
+	struct PrefetchRequest {
+		DiskDevice* device;
+		size_t start_block;
+		size_t num_pages;
+	};
+
+	/**
+	 * Writes back dirty cache regions, merging adjacent regions into single writes.
+	 * @param only_expired If true, only runs of regions containing at least one expired region will be written.
+	 * @param start_block The first block to write back.
+	 * @param end_block The block after the last one to write back.
+	 */
+	Result write_back(bool only_expired, size_t start_block = 0, size_t end_block = SIZE_MAX);
+	/**
+	 * Reads or writes a run of up to DISK_MAX_READ_PAGES adjacent cache regions straight to or from their pages as a
+	 * single request.
+	 */
+	Result transfer_regions(BlockRequest::Type type, kstd::vector<kstd::Arc<BlockCacheRegion>>& regions);
+	/** Writes back a run of adjacent dirty cache regions. Must be called with s_flush_lock held. **/
+	Result write_back_run(kstd::vector<kstd::Arc<BlockCacheRegion>>& run);
+	/** Marks a cache region dirty. Must be called with the region's lock held. **/
+	void mark_dirty(const kstd::Arc<BlockCacheRegion>& region);
+
+	/**
+	 * Copies count bytes starting offset bytes into the given block through the cache into the buffer. The position
+	 * is kept as a block and offset so that disks larger than 4 GiB can be addressed.
+	 **/
+	Result cached_read(size_t start_block, size_t offset, SafePointer<uint8_t> buffer, size_t count);
+	/** Copies count bytes from the buffer through the cache to the position offset bytes into the given block. **/
+	Result cached_write(size_t start_block, size_t offset, SafePointer<uint8_t> buffer, size_t count);
+	/**
+	 * Gets the cache region containing the given block, reading it from the disk if it isn't cached.
+	 * @param max_pages On a miss, up to this many consecutive uncached regions will be read in the same request.
+	 */
+	ResultRet<kstd::Arc<BlockCacheRegion>> get_cache_region(size_t block, size_t max_pages = 1);
+	/**
+	 * Waits for a cache region to be read from the disk, if it's still being read. If the read failed, the region will
+	 * have been taken out of the cache and the error is returned.
+	 */
+	Result wait_for_fill(const kstd::Arc<BlockCacheRegion>& region);
+	/** Queues a request, waits for it to be dispatched to this thread or completed by another, and returns its result. **/
+	Result submit_request(BlockRequest& request);
+	/** Tries to merge a request into one that's already queued. Must be called with _queue_lock held. **/
+	bool merge_request(BlockRequest& request);
+	/** Hands queued requests to their threads until the disk is full or the queue is empty. Must be called with _queue_lock held. **/
+	void dispatch_requests();
+	/** Dequeues the next request to perform using C-LOOK. Must be called with _queue_lock held. **/
+	BlockRequest* next_request();
+	/** Overwrites the whole cache region starting at the given block without reading it from the disk first. **/
+	void overwrite_cache_region(size_t start_block, SafePointer<uint8_t> buffer);
+
 	// Static
 	static SpinLock s_disk_devices_lock;
 	static size_t s_used_cache_memory;
 	static kstd::vector<DiskDevice*> s_disk_devices;
+	static Atomic<size_t, MemoryOrder::SeqCst> s_dirty_pages;
+	static SpinLock s_flush_lock;
+	static kstd::Arc<VMRegion> s_flush_buffer; ///< Where write_back_run snapshots regions. Guarded by s_flush_lock.
+	static SpinLock s_prefetch_lock;
+	static BooleanBlocker s_prefetch_blocker;
+	static kstd::vector<PrefetchRequest> s_prefetch_requests;
 
 	kstd::LRUCache<size_t, kstd::Arc<BlockCacheRegion>> _cache_regions;
-	kstd::Arc<BlockCacheRegion> get_cache_region(size_t block);
 	inline size_t blocks_per_cache_region() { return PAGE_SIZE / block_size(); }
 	inline size_t block_cache_region_start(size_t block) { return block - (block % blocks_per_cache_region()); }
 	SpinLock _cache_lock;
+	size_t _cache_hits = 0;
+	size_t _cache_misses = 0;
+	size_t _cache_evictions = 0;
+	kstd::map<size_t, kstd::Arc<BlockCacheRegion>> _dirty_regions;
+	SpinLock _dirty_lock;
+	kstd::vector<BlockRequest*> _request_queue; ///< Requests waiting to be performed, sorted by block.
+	size_t _num_active_requests = 0;
+	size_t _head_position = 0; ///< The block right after the last request dispatched.
+	SpinLock _queue_lock;
+	size_t _num_reads = 0;
+	size_t _num_writes = 0;
+	size_t _num_merges = 0;
+	uint64_t _service_time = 0;
 };
 
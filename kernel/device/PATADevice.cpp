@@ -93,6 +93,12 @@ PATADevice::PATADevice(PCI::Address addr, PATADevice::Channel channel, PATADevic
 		use_pio = true;
 	}
 	_max_addressable_block = identity_block->user_addressable_sectors;
+	if(identity[ATA_IDENTITY_COMMAND_SET_2] & ATA_IDENTITY_COMMAND_SET_2_LBA48) {
+		_use_lba48 = true;
+		_max_addressable_block = 0;
+		for(int i = 3; i >= 0; i--)
+			_max_addressable_block = (_max_addressable_block << 16) | identity[ATA_IDENTITY_LBA48_SECTORS + i];
+	}
 
 	//Delete the identity buffers
 	delete[] identity;
@@ -102,7 +108,7 @@ PATADevice::PATADevice(PCI::Address addr, PATADevice::Channel channel, PATADevic
 	PCI::enable_interrupt(addr);
 	if(!use_pio) {
 		PCI::enable_bus_mastering(addr);
-		_prdt_region = MM.alloc_kernel_region(sizeof(PRDT));
+		_prdt_region = MM.alloc_dma_region(ATA_MAX_PRDT_ENTRIES * sizeof(PRDT));
 		_prdt = (PRDT*) _prdt_region->start();
 		_dma_region = MM.alloc_dma_region(ATA_MAX_SECTORS_AT_ONCE * 512);
 
@@ -127,18 +133,11 @@ void PATADevice::wait_ready() {
 		status = IO::inb(_control_base);
 }
 
-Result PATADevice::read_sectors_dma(uint32_t lba, uint8_t num_sectors, uint8_t *buf) {
-	ASSERT(num_sectors <= ATA_MAX_SECTORS_AT_ONCE);
+Result PATADevice::read_sectors_dma(uint32_t lba, uint32_t num_sectors) {
 	LOCK(_lock);
 
-	if(num_sectors * 512 > _dma_region->object()->physical_page(0).paddr())
-		return Result(-EINVAL);
-	_prdt->addr = _dma_region->object()->physical_page(0).paddr();
-	_prdt->size = num_sectors * 512;
-	_prdt->eot = 0x8000;
-
 	//Select drive and wait 10us
-	IO::outb(_io_base + ATA_DRIVESEL, 0xA0u | (_drive == SLAVE ? 0x8u : 0x0u));
+	IO::outb(_io_base + ATA_DRIVESEL, 0xE0u | (_drive == SLAVE ? 0x10u : 0x0u));
 	IO::wait(10);
 
 	//Stop bus master, write PRDT, clear flags, and set direction to read
@@ -148,7 +147,7 @@ Result PATADevice::read_sectors_dma(uint32_t lba, uint8_t num_sectors, uint8_t *
 	IO::outb(_bus_master_base + ATA_BM_STATUS, IO::inb(_bus_master_base + ATA_BM_STATUS) | 0x6u);
 
 	//Access the drive
-	access_drive(ATA_READ_DMA, lba, num_sectors);
+	access_drive(_use_lba48 ? ATA_READ_DMA_EXT : ATA_READ_DMA, lba, num_sectors);
 
 	//Wait for DRQ bit and start bus master
 	while(!(IO::inb(_control_base) & ATA_STATUS_DRQ));
@@ -164,30 +163,17 @@ Result PATADevice::read_sectors_dma(uint32_t lba, uint8_t num_sectors, uint8_t *
 		return Result(-EIO);
 	}
 
-	//Copy to buffer
-	memcpy((void *) buf, (void*) _dma_region->start(), 512 * num_sectors);
-
 	//Tell bus master we're done
 	IO::outb(_bus_master_base + ATA_BM_STATUS, IO::inb(_bus_master_base + ATA_BM_STATUS) | 0x6u);
 
 	return Result(SUCCESS);
 }
 
-Result PATADevice::write_sectors_dma(uint32_t lba, uint8_t num_sectors, const uint8_t *buf) {
-	ASSERT(num_sectors <= ATA_MAX_SECTORS_AT_ONCE);
+Result PATADevice::write_sectors_dma(uint32_t lba, uint32_t num_sectors) {
 	LOCK(_lock);
 
-	if(num_sectors * 512 > _dma_region->size())
-		return Result(-EINVAL);
-	_prdt->addr = _dma_region->object()->physical_page(0).paddr();
-	_prdt->size = num_sectors * 512;
-	_prdt->eot = 0x8000;
-
-	//Copy to buffer
-	memcpy((void*) _dma_region->start(), buf, 512 * num_sectors);
-
 	//Select drive and wait 10us
-	IO::outb(_io_base + ATA_DRIVESEL, 0xA0u | (_drive == SLAVE ? 0x8u : 0x0u));
+	IO::outb(_io_base + ATA_DRIVESEL, 0xE0u | (_drive == SLAVE ? 0x10u : 0x0u));
 	IO::wait(10);
 
 	//Stop bus master, write PRDT, and clear flags
@@ -195,7 +181,7 @@ Result PATADevice::write_sectors_dma(uint32_t lba, uint8_t num_sectors, const ui
 	IO::outl(_bus_master_base + ATA_BM_PRDT, _prdt_region->object()->physical_page(0).paddr());
 	IO::outb(_bus_master_base + ATA_BM_STATUS, IO::inb(_bus_master_base + ATA_BM_STATUS) | 0x6u);
 
-	access_drive(ATA_WRITE_DMA, lba, num_sectors);
+	access_drive(_use_lba48 ? ATA_WRITE_DMA_EXT : ATA_WRITE_DMA, lba, num_sectors);
 
 	//Wait for DRQ / not busy and start bus master
 	while(IO::inb(_control_base) & ATA_STATUS_BSY || !(IO::inb(_control_base) & ATA_STATUS_DRQ));
@@ -255,18 +241,26 @@ void PATADevice::read_sectors_pio(uint32_t sector, uint8_t sectors, uint8_t *buf
 	uninstall_irq();
 }
 
-void PATADevice::access_drive(uint8_t command, uint32_t lba, uint8_t num_sectors) {
+void PATADevice::access_drive(uint8_t command, uint32_t lba, uint32_t num_sectors) {
 	TaskManager::enter_critical();
-
-	//TODO: Support 48-bit LBA
 	wait_ready();
 
-	//Select drive
-	IO::outb(_io_base + ATA_DRIVESEL, 0xe0u | (_drive == SLAVE ? 0x8u : 0x0u) | ((lba & 0xF000000) >> 24));
-	IO::wait(20);
+	if(command == ATA_READ_DMA_EXT || command == ATA_WRITE_DMA_EXT) {
+		//Select drive in LBA48 mode and set the high bytes of the count and lba (bits 32-47 of our lba are always 0)
+		IO::outb(_io_base + ATA_DRIVESEL, 0x40u | (_drive == SLAVE ? 0x10u : 0x0u));
+		IO::wait(20);
+		IO::outb(_io_base + ATA_SECCNT0, (num_sectors & 0xFF00u) >> 8u);
+		IO::outb(_io_base + ATA_LBA0, (lba & 0xFF000000u) >> 24u);
+		IO::outb(_io_base + ATA_LBA1, 0);
+		IO::outb(_io_base + ATA_LBA2, 0);
+	} else {
+		//Select drive
+		IO::outb(_io_base + ATA_DRIVESEL, 0xe0u | (_drive == SLAVE ? 0x10u : 0x0u) | ((lba & 0xF000000) >> 24));
+		IO::wait(20);
+	}
 
-	//Set count and lba
-	IO::outb(_io_base + ATA_SECCNT0, num_sectors);
+	//Set count and lba (a count of 0 means 256 sectors, or 65536 with LBA48)
+	IO::outb(_io_base + ATA_SECCNT0, num_sectors & 0xFFu);
 	IO::outb(_io_base + ATA_LBA0, (lba & 0xFFu));
 	IO::outb(_io_base + ATA_LBA1, (lba & 0xFF00u) >> 8u);
 	IO::outb(_io_base + ATA_LBA2, (lba & 0xFF0000u) >> 16u);
@@ -279,51 +273,80 @@ void PATADevice::access_drive(uint8_t command, uint32_t lba, uint8_t num_sectors
 	IO::outb(_io_base + ATA_COMMAND, command);
 }
 
-Result PATADevice::read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) {
+Result PATADevice::perform_request(BlockRequest& request) {
 	if(!_use_pio) {
-		//DMA mode
-		size_t num_chunks = (count + ATA_MAX_SECTORS_AT_ONCE - 1) / ATA_MAX_SECTORS_AT_ONCE;
-		for (size_t i = 0; i < num_chunks; i++) {
-			uint32_t num_sectors = min((size_t) ATA_MAX_SECTORS_AT_ONCE, count);
-			Result res = read_sectors_dma(block + i * ATA_MAX_SECTORS_AT_ONCE, num_sectors, buffer + (512 * i * ATA_MAX_SECTORS_AT_ONCE));
-			if (res.is_error()) return res;
-			count -= num_sectors;
+		//DMA mode, straight to and from the request's buffers if possible
+		size_t max_sectors = _use_lba48 ? 65536 : 256;
+		size_t count = request.total_blocks();
+		for(size_t done = 0; done < count;) {
+			size_t num_sectors = build_prdt(request, done, min(max_sectors, count - done));
+			bool bounce = !num_sectors;
+			if(bounce) {
+				num_sectors = min((size_t) ATA_MAX_SECTORS_AT_ONCE, count - done);
+				use_bounce_prdt(num_sectors);
+			}
+
+			auto* bounce_buf = (uint8_t*) _dma_region->start();
+			if(request.type == BlockRequest::Read) {
+				Result res = read_sectors_dma(request.block + done, num_sectors);
+				if(res.is_error()) return res;
+				if(bounce)
+					request.scatter(done, num_sectors, bounce_buf, 512);
+			} else {
+				if(bounce)
+					request.gather(done, num_sectors, bounce_buf, 512);
+				Result res = write_sectors_dma(request.block + done, num_sectors);
+				if(res.is_error()) return res;
+			}
+			done += num_sectors;
 		}
 		return Result(SUCCESS);
 	} else {
-		//PIO mode
-		while(count) {
-			uint8_t to_read = min(count, 0xFFu);
-			read_sectors_pio(block, to_read, buffer);
-			block += to_read;
-			count -= to_read;
+		//PIO mode, straight into each merged request's buffer
+		for(auto* cur_request = &request; cur_request; cur_request = cur_request->next) {
+			uint32_t block = cur_request->block;
+			uint32_t count = cur_request->count;
+			uint8_t* buffer = cur_request->buffer;
+			while(count) {
+				uint8_t to_transfer = min(count, 0xFFu);
+				if(request.type == BlockRequest::Read)
+					read_sectors_pio(block, to_transfer, buffer);
+				else
+					write_sectors_pio(block, to_transfer, buffer);
+				block += to_transfer;
+				count -= to_transfer;
+				buffer += to_transfer * 512;
+			}
 		}
 		return Result(SUCCESS);
 	}
 }
 
-Result PATADevice::write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) {
-	if(!_use_pio) {
-		//DMA mode
-		size_t num_chunks = (count + ATA_MAX_SECTORS_AT_ONCE - 1) / ATA_MAX_SECTORS_AT_ONCE;
-		for (size_t i = 0; i < num_chunks; i++) {
-			uint32_t num_sectors = min((size_t) ATA_MAX_SECTORS_AT_ONCE, count);
-			Result res = write_sectors_dma(block + i * ATA_MAX_SECTORS_AT_ONCE, num_sectors, buffer + (512 * i * ATA_MAX_SECTORS_AT_ONCE));
-			if(res.is_error())
-				return res;
-			count -= num_sectors;
-		}
-		return Result(SUCCESS);
-	} else {
-		//PIO mode
-		while(count) {
-			uint8_t to_read = min(count, 0xFFu);
-			write_sectors_pio(block, to_read, buffer);
-			block += to_read;
-			count -= to_read;
-		}
-		return Result(SUCCESS);
-	}
+size_t PATADevice::build_prdt(BlockRequest& request, size_t sector_offset, size_t num_sectors) {
+	//Entries are at most 64KiB (which is stored as a size of 0) and can't cross a 64KiB boundary
+	BlockRequest::SegmentLimits limits = {
+		.max_segments = ATA_MAX_PRDT_ENTRIES,
+		.max_segment_size = 0x10000,
+		.boundary = 0x10000,
+		.alignment = 2
+	};
+	size_t num_entries = 0;
+	size_t num_built = request.build_segments(sector_offset, num_sectors, 512, limits, num_entries,
+		[&](size_t entry, PhysicalAddress addr, size_t size) {
+			_prdt[entry].addr = addr;
+			_prdt[entry].size = size;
+			_prdt[entry].eot = 0;
+		});
+	if(num_built)
+		_prdt[num_entries - 1].eot = 0x8000;
+	return num_built;
+}
+
+void PATADevice::use_bounce_prdt(size_t num_sectors) {
+	ASSERT(num_sectors <= ATA_MAX_SECTORS_AT_ONCE);
+	_prdt[0].addr = _dma_region->object()->physical_page(0).paddr();
+	_prdt[0].size = num_sectors * 512;
+	_prdt[0].eot = 0x8000;
 }
 
 size_t PATADevice::block_size() {
@@ -331,93 +354,17 @@ size_t PATADevice::block_size() {
 }
 
 ssize_t PATADevice::read(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	size_t first_block = offset / block_size();
-	size_t first_block_start = offset % block_size();
-	size_t bytes_left = count;
-	size_t block = first_block;
-	ssize_t nread = 0;
-
-	uint8_t block_buf[block_size()];
-	while(bytes_left) {
-		if(block > _max_addressable_block)
-			break;
-
-		Result res = read_block(block, block_buf);
-		if(res.is_error())
-			return res.code();
-
-		if(block == first_block) {
-			if(count < block_size() - first_block_start) {
-				buffer.write(block_buf + first_block_start, count);
-				nread += count;
-				bytes_left = 0;
-			} else {
-				buffer.write(block_buf + first_block_start, block_size() - first_block_start);
-				nread += block_size() - first_block_start;
-				bytes_left -= block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < block_size()) {
-				buffer.write(block_buf, count - bytes_left, bytes_left);
-				nread += bytes_left;
-				bytes_left = 0;
-			} else {
-				buffer.write(block_buf, count - bytes_left, block_size());
-				nread += block_size();
-				bytes_left -= block_size();
-			}
-		}
-		block++;
-	}
-
-	return nread;
+	// The disk may be larger than a size_t can hold, so compare in blocks
+	if(offset / block_size() >= _max_addressable_block)
+		return 0;
+	uint64_t bytes_left = _max_addressable_block * block_size() - offset;
+	return DiskDevice::read(fd, offset, buffer, (size_t) min((uint64_t) count, bytes_left));
 }
 
 ssize_t PATADevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	size_t first_block = offset / block_size();
-	size_t last_block = (offset + count) / block_size();
-	size_t first_block_start = offset % block_size();
-	size_t bytes_left = count;
-	size_t block = first_block;
-
-	if(last_block > _max_addressable_block)
+	if((uint64_t) offset + count > _max_addressable_block * block_size())
 		return -ENOSPC;
-
-	uint8_t block_buf[block_size()];
-	while(bytes_left) {
-		//Read the block into a buffer
-		Result res = read_block(block, block_buf);
-		if(res.is_error()) {
-			return res.code();
-		}
-
-		//Copy the appropriate portion of the buffer into the appropriate portion of the block buffer
-		if(block == first_block) {
-			if(count < block_size() - first_block_start) {
-				buffer.read(block_buf + first_block_start, count);
-				bytes_left = 0;
-			} else {
-				buffer.read(block_buf + first_block_start, block_size() - first_block_start);
-				bytes_left -= block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < block_size()) {
-				buffer.read(block_buf, count - bytes_left, bytes_left);
-				bytes_left = 0;
-			} else {
-				buffer.read(block_buf, count - bytes_left, block_size());
-				bytes_left -= block_size();
-			}
-		}
-
-		res = write_block(block, block_buf);
-		if(res.is_error()) {
-			return res.code();
-		}
-		block++;
-	}
-
-	return count;
+	return DiskDevice::write(fd, offset, buffer, count);
 }
 
 void PATADevice::handle_irq(Registers *regs) {
@@ -28,7 +28,10 @@
 #include <kernel/tasking/SpinLock.h>
 #include <kernel/memory/MemoryManager.h>
 
+/** The number of sectors that fit in the bounce buffer, used when a request's buffers can't be DMA'd to directly. **/
 #define ATA_MAX_SECTORS_AT_ONCE (PAGE_SIZE / 512)
+/** The number of entries that fit in the PRDT, each of which covers up to 64KiB of physically contiguous memory. **/
+#define ATA_MAX_PRDT_ENTRIES (PAGE_SIZE / sizeof(PRDT))
 
 class PATADevice: public IRQHandler, public DiskDevice {
 public:
@@ -41,16 +44,16 @@ public:
 	~PATADevice();
 	uint8_t wait_status(uint8_t flags = ATA_STATUS_BSY);
 	void wait_ready();
-	Result read_sectors_dma(uint32_t sector, uint8_t num_sectors, uint8_t* buf);
-	Result write_sectors_dma(uint32_t sector, uint8_t num_sectors, const uint8_t* buf);
+	/** Reads sectors into the memory described by the PRDT. **/
+	Result read_sectors_dma(uint32_t sector, uint32_t num_sectors);
+	/** Writes sectors from the memory described by the PRDT. **/
+	Result write_sectors_dma(uint32_t sector, uint32_t num_sectors);
 	void read_sectors_pio(uint32_t sector, uint8_t sectors, uint8_t *buffer);
 	void write_sectors_pio(uint32_t sector, uint8_t sectors, const uint8_t *buffer);
-	void access_drive(uint8_t command, uint32_t lba, uint8_t num_sectors);
+	void access_drive(uint8_t command, uint32_t lba, uint32_t num_sectors);
 
 
 	//BlockDevice
-	Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) override;
-	Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override;
 	size_t block_size() override;
 
 	//File
@@ -60,9 +63,21 @@ public:
 	//IRQHandler
 	void handle_irq(Registers* regs) override;
 
+protected:
+	//DiskDevice
+	Result perform_request(BlockRequest& request) override;
+
 private:
 	PATADevice(PCI::Address addr, Channel channel, DriveType drive, bool use_pio);
 
+	/**
+	 * Fills the PRDT with the physical memory backing part of a request, so the disk can transfer to it directly.
+	 * @return The number of sectors the PRDT covers, or 0 if the request's buffers can't be used for DMA.
+	 */
+	size_t build_prdt(BlockRequest& request, size_t sector_offset, size_t num_sectors);
+	/** Points the PRDT at the bounce buffer. **/
+	void use_bounce_prdt(size_t num_sectors);
+
 	//Addresses
 	PCI::Address _pci_addr;
 	uint16_t _io_base;
@@ -74,6 +89,7 @@ private:
 	DriveType _drive;
 	char _model_number[40];
 	bool _use_pio = false;
+	bool _use_lba48 = false;
 	uint64_t _max_addressable_block;
 
 	//DMA stuff
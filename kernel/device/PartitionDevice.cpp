@@ -45,6 +45,18 @@ size_t PartitionDevice::block_size() {
 	return _parent->block_size();
 }
 
+void PartitionDevice::prefetch(size_t offset, size_t count) {
+	_parent->prefetch(offset + _offset, count);
+}
+
+Result PartitionDevice::sync() {
+	return _parent->sync();
+}
+
+Result PartitionDevice::sync_range(size_t offset, size_t count) {
+	return _parent->sync_range(offset + _offset, count);
+}
+
 size_t PartitionDevice::part_offset() {
 	return _offset;
 }
@@ -29,6 +29,9 @@ public:
 	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	size_t block_size() override;
+	void prefetch(size_t offset, size_t count) override;
+	Result sync() override;
+	Result sync_range(size_t offset, size_t count) override;
 	size_t part_offset();
 	kstd::Arc<File> parent();
 private:
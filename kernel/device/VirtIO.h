@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/kstd/types.h>
+
+//PCI
+#define VIRTIO_PCI_VENDOR 0x1AF4
+#define VIRTIO_PCI_DEVICE_BLOCK_LEGACY 0x1001
+
+//Legacy PCI registers (Offsets into BAR0)
+#define VIRTIO_PCI_DEVICE_FEATURES 0x00 //32
+#define VIRTIO_PCI_GUEST_FEATURES 0x04 //32
+#define VIRTIO_PCI_QUEUE_ADDRESS 0x08 //32, in pages
+#define VIRTIO_PCI_QUEUE_SIZE 0x0C //16
+#define VIRTIO_PCI_QUEUE_SELECT 0x0E //16
+#define VIRTIO_PCI_QUEUE_NOTIFY 0x10 //16
+#define VIRTIO_PCI_DEVICE_STATUS 0x12 //8
+#define VIRTIO_PCI_ISR_STATUS 0x13 //8, cleared on read
+#define VIRTIO_PCI_DEVICE_CONFIG 0x14 //Device-specific configuration starts here when MSI-X is disabled
+
+//Device status
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x1
+#define VIRTIO_STATUS_DRIVER 0x2
+#define VIRTIO_STATUS_DRIVER_OK 0x4
+#define VIRTIO_STATUS_FAILED 0x80
+
+//ISR status
+#define VIRTIO_ISR_QUEUE 0x1
+#define VIRTIO_ISR_CONFIG 0x2
+
+//Common features
+#define VIRTIO_F_RING_INDIRECT_DESC (1u << 28)
+#define VIRTIO_F_RING_EVENT_IDX (1u << 29)
+
+//Virtqueue flags
+#define VIRTQ_DESC_F_NEXT 0x1
+#define VIRTQ_DESC_F_WRITE 0x2 //The device writes to the buffer instead of reading from it
+#define VIRTQ_DESC_F_INDIRECT 0x4
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 0x1
+#define VIRTQ_USED_F_NO_NOTIFY 0x1
+
+/** Legacy virtqueues have their used ring aligned to this. **/
+#define VIRTQ_ALIGN 4096
+
+namespace VirtIO {
+	struct __attribute__((packed)) Descriptor {
+		uint64_t addr;
+		uint32_t length;
+		uint16_t flags;
+		uint16_t next;
+	};
+
+	struct AvailableRing {
+		uint16_t flags;
+		uint16_t index;
+		uint16_t ring[]; //Followed by used_event when VIRTIO_F_RING_EVENT_IDX is negotiated
+	};
+
+	struct UsedElement {
+		uint32_t id; //The head of the descriptor chain that was used
+		uint32_t length; //The number of bytes written into the chain
+	};
+
+	struct UsedRing {
+		uint16_t flags;
+		uint16_t index;
+		UsedElement ring[]; //Followed by avail_event when VIRTIO_F_RING_EVENT_IDX is negotiated
+	};
+}
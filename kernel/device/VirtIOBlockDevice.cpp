@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "VirtIOBlockDevice.h"
+#include <kernel/kstd/KLog.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/tasking/TaskManager.h>
+
+VirtIOBlockDevice* VirtIOBlockDevice::find() {
+	auto addr = VirtIOPCIDevice::find(VIRTIO_PCI_DEVICE_BLOCK_LEGACY);
+	if(addr.is_zero())
+		return nullptr;
+	auto* device = new VirtIOBlockDevice(addr);
+	if(!device->_present) {
+		device->uninstall_irq();
+		Device::remove_device(device->major(), device->minor());
+		return nullptr;
+	}
+	return device;
+}
+
+VirtIOBlockDevice::VirtIOBlockDevice(PCI::Address addr):
+	VirtIOPCIDevice(addr), DiskDevice(254, 0)
+{
+	uint32_t features = negotiate_features(VIRTIO_F_RING_INDIRECT_DESC | VIRTIO_F_RING_EVENT_IDX | VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_RO);
+	_use_indirect = features & VIRTIO_F_RING_INDIRECT_DESC;
+	_read_only = features & VIRTIO_BLK_F_RO;
+
+	auto queue_res = setup_queue(0, features & VIRTIO_F_RING_EVENT_IDX);
+	if(queue_res.is_error()) {
+		KLog::err("VirtIO", "virtio-blk device at %x:%x.%x has no request queue", addr.bus, addr.slot, addr.function);
+		fail_init();
+		return;
+	}
+	_queue = queue_res.value();
+
+	//With indirect descriptors, each slot only takes up one descriptor in the queue. Otherwise, each slot gets an
+	//equal share of the queue's descriptors, which has to fit at least a header, some data, and a status.
+	_num_slots = min((size_t) VIRTIO_BLK_MAX_REQUESTS, _use_indirect ? (size_t) _queue->size() : (size_t) _queue->size() / 3);
+	if(!_num_slots) {
+		KLog::err("VirtIO", "virtio-blk device at %x:%x.%x has a request queue that's too small", addr.bus, addr.slot, addr.function);
+		fail_init();
+		return;
+	}
+	_free_slots = _num_slots == 32 ? 0xFFFFFFFF : (1u << _num_slots) - 1;
+	for(size_t slot = 0; slot < _num_slots; slot++)
+		_slots[slot].region = MM.alloc_dma_region(PAGE_SIZE);
+
+	_max_segments = slot_num_descriptors() - 2;
+	if(features & VIRTIO_BLK_F_SEG_MAX)
+		_max_segments = max(min(_max_segments, (size_t) read_config32(VIRTIO_BLK_CONFIG_SEG_MAX)), (size_t) 1);
+	_max_addressable_block = read_config64(VIRTIO_BLK_CONFIG_CAPACITY);
+
+	finish_init();
+	_present = true;
+	KLog::info("VirtIO", "Setup virtio-blk disk with %d request slots%s%s (%d blocks)", _num_slots,
+			   _use_indirect ? ", indirect descriptors" : "", _read_only ? ", read-only" : "", _max_addressable_block);
+}
+
+VirtIOBlockDevice::~VirtIOBlockDevice() = default;
+
+size_t VirtIOBlockDevice::acquire_slot() {
+	LOCK(_slot_lock);
+	ASSERT(_free_slots);
+	size_t slot = __builtin_ctz(_free_slots);
+	_free_slots &= ~(1u << slot);
+	return slot;
+}
+
+void VirtIOBlockDevice::release_slot(size_t slot) {
+	LOCK(_slot_lock);
+	_free_slots |= 1u << slot;
+}
+
+VirtIO::Descriptor* VirtIOBlockDevice::slot_descriptors(size_t slot) {
+	if(_use_indirect)
+		return (VirtIO::Descriptor*) (_slots[slot].region->start() + VIRTIO_BLK_INDIRECT_TABLE_OFFSET);
+	return _queue->descriptors();
+}
+
+uint16_t VirtIOBlockDevice::slot_first_descriptor(size_t slot) {
+	return _use_indirect ? 0 : slot * slot_num_descriptors();
+}
+
+size_t VirtIOBlockDevice::slot_num_descriptors() {
+	return _use_indirect ? VIRTIO_BLK_INDIRECT_DESCRIPTORS : _queue->size() / _num_slots;
+}
+
+Result VirtIOBlockDevice::perform_request(BlockRequest& request) {
+	bool write = request.type == BlockRequest::Write;
+	if(write && _read_only)
+		return Result(-EROFS);
+
+	size_t slot = acquire_slot();
+	size_t count = request.total_blocks();
+	Result result = Result(SUCCESS);
+	for(size_t done = 0; done < count;) {
+		//Straight to and from the request's buffers if possible
+		size_t num_descriptors = 0;
+		size_t num_sectors = build_descriptors(slot, request, done, count - done, num_descriptors);
+		bool bounce = !num_sectors;
+		if(bounce) {
+			num_sectors = min(PAGE_SIZE / 512, count - done);
+			if(!_slots[slot].bounce_region)
+				_slots[slot].bounce_region = MM.alloc_dma_region(PAGE_SIZE);
+			num_descriptors = use_bounce_descriptors(slot, num_sectors, write);
+		}
+
+		auto* bounce_buf = bounce ? (uint8_t*) _slots[slot].bounce_region->start() : nullptr;
+		if(bounce && write)
+			request.gather(done, num_sectors, bounce_buf, 512);
+		result = issue_request(slot, write, request.block + done, num_descriptors);
+		if(result.is_error())
+			break;
+		if(bounce && !write)
+			request.scatter(done, num_sectors, bounce_buf, 512);
+		done += num_sectors;
+	}
+	release_slot(slot);
+	return result;
+}
+
+size_t VirtIOBlockDevice::max_active_requests() {
+	return _num_slots;
+}
+
+size_t VirtIOBlockDevice::build_descriptors(size_t slot, BlockRequest& request, size_t sector_offset, size_t num_sectors, size_t& num_descriptors) {
+	//Data descriptors go right after the header descriptor, and their lengths are 32 bits
+	auto* data = slot_descriptors(slot) + slot_first_descriptor(slot) + 1;
+	BlockRequest::SegmentLimits limits = {
+		.max_segments = _max_segments,
+		.max_segment_size = 0xFFFFFFFF
+	};
+	size_t num_data = 0;
+	size_t num_built = request.build_segments(sector_offset, num_sectors, 512, limits, num_data,
+		[&](size_t descriptor, PhysicalAddress addr, size_t size) {
+			data[descriptor].addr = addr;
+			data[descriptor].length = size;
+		});
+	if(num_built)
+		num_descriptors = link_descriptors(slot, num_data, request.type == BlockRequest::Write);
+	return num_built;
+}
+
+size_t VirtIOBlockDevice::use_bounce_descriptors(size_t slot, size_t num_sectors, bool write) {
+	ASSERT(num_sectors <= PAGE_SIZE / 512);
+	auto& data = slot_descriptors(slot)[slot_first_descriptor(slot) + 1];
+	data.addr = _slots[slot].bounce_region->object()->physical_page(0).paddr();
+	data.length = num_sectors * 512;
+	return link_descriptors(slot, 1, write);
+}
+
+size_t VirtIOBlockDevice::link_descriptors(size_t slot, size_t num_data_descriptors, bool write) {
+	auto* descriptors = slot_descriptors(slot);
+	uint16_t first = slot_first_descriptor(slot);
+	uint16_t last = first + num_data_descriptors + 1;
+	PhysicalAddress slot_addr = _slots[slot].region->object()->physical_page(0).paddr();
+
+	//The device reads the header, reads or writes the data, and then writes the status
+	descriptors[first].addr = slot_addr;
+	descriptors[first].length = sizeof(RequestHeader);
+	for(uint16_t i = first; i < last; i++) {
+		if(i != first)
+			descriptors[i].flags = VIRTQ_DESC_F_NEXT | (write ? 0 : VIRTQ_DESC_F_WRITE);
+		else
+			descriptors[i].flags = VIRTQ_DESC_F_NEXT;
+		descriptors[i].next = i + 1;
+	}
+	descriptors[last].addr = slot_addr + sizeof(RequestHeader);
+	descriptors[last].length = 1;
+	descriptors[last].flags = VIRTQ_DESC_F_WRITE;
+	descriptors[last].next = 0;
+	return num_data_descriptors + 2;
+}
+
+Result VirtIOBlockDevice::issue_request(size_t slot, bool write, uint64_t sector, size_t num_descriptors) {
+	auto& slot_info = _slots[slot];
+	auto* header = (RequestHeader*) slot_info.region->start();
+	header->type = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+	header->reserved = 0;
+	header->sector = sector;
+	auto* status = (volatile uint8_t*) (slot_info.region->start() + sizeof(RequestHeader));
+	*status = 0xFF;
+
+	//With indirect descriptors, the slot's descriptor in the queue points to its table
+	uint16_t head = slot_first_descriptor(slot);
+	if(_use_indirect) {
+		auto& descriptor = _queue->descriptors()[slot];
+		descriptor.addr = slot_info.region->object()->physical_page(0).paddr() + VIRTIO_BLK_INDIRECT_TABLE_OFFSET;
+		descriptor.length = num_descriptors * sizeof(VirtIO::Descriptor);
+		descriptor.flags = VIRTQ_DESC_F_INDIRECT;
+		descriptor.next = 0;
+		head = slot;
+	}
+
+	slot_info.blocker.set_ready(false);
+	if(_queue->submit(head))
+		notify(*_queue);
+	TaskManager::current_thread()->block(slot_info.blocker);
+
+	if(*status != VIRTIO_BLK_S_OK) {
+		KLog::err("VirtIO", "virtio-blk %s of sector %d failed with status %d", write ? "write" : "read", (size_t) sector, *status);
+		return Result(-EIO);
+	}
+	return Result(SUCCESS);
+}
+
+void VirtIOBlockDevice::handle_queue_irq() {
+	//Keep interrupts off while going through the used ring, and check it again if anything was used in the meantime
+	VirtIO::UsedElement element;
+	do {
+		_queue->disable_interrupts();
+		while(_queue->pop_used(element)) {
+			size_t slot = _use_indirect ? element.id : element.id / slot_num_descriptors();
+			_slots[slot].blocker.set_ready(true);
+		}
+	} while(!_queue->enable_interrupts());
+}
+
+size_t VirtIOBlockDevice::block_size() {
+	return 512;
+}
+
+ssize_t VirtIOBlockDevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	// The disk may be larger than a size_t can hold, so compare in blocks
+	if(offset / block_size() >= _max_addressable_block)
+		return 0;
+	uint64_t bytes_left = _max_addressable_block * block_size() - offset;
+	return DiskDevice::read(fd, offset, buffer, (size_t) min((uint64_t) count, bytes_left));
+}
+
+ssize_t VirtIOBlockDevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	if(_read_only)
+		return -EROFS;
+	if((uint64_t) offset + count > _max_addressable_block * block_size())
+		return -ENOSPC;
+	return DiskDevice::write(fd, offset, buffer, count);
+}
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "VirtIOPCIDevice.h"
+#include "DiskDevice.h"
+#include <kernel/tasking/BooleanBlocker.h>
+
+//Features
+#define VIRTIO_BLK_F_SEG_MAX (1u << 2)
+#define VIRTIO_BLK_F_RO (1u << 5)
+
+//Configuration
+#define VIRTIO_BLK_CONFIG_CAPACITY 0x0 //64, in 512-byte sectors
+#define VIRTIO_BLK_CONFIG_SEG_MAX 0xC //32
+
+//Requests
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+#define VIRTIO_BLK_S_OK 0
+
+/** The maximum number of requests that can be in flight at once. **/
+#define VIRTIO_BLK_MAX_REQUESTS 32
+/** Where each slot's indirect descriptor table starts in its page, after the request header and status. **/
+#define VIRTIO_BLK_INDIRECT_TABLE_OFFSET 64
+/** The number of descriptors that fit in each slot's indirect descriptor table. **/
+#define VIRTIO_BLK_INDIRECT_DESCRIPTORS ((PAGE_SIZE - VIRTIO_BLK_INDIRECT_TABLE_OFFSET) / sizeof(VirtIO::Descriptor))
+
+/**
+ * A virtio-blk paravirtual disk. Each request that the disk performs gets its own slot, with a page for the request's
+ * header, status and indirect descriptor table, so up to one request per slot can be in flight at once.
+ */
+class VirtIOBlockDevice: public VirtIOPCIDevice, public DiskDevice {
+public:
+	/** Finds the first virtio-blk device and sets it up. Returns nullptr if there isn't one or it couldn't be set up. **/
+	static VirtIOBlockDevice* find();
+
+	~VirtIOBlockDevice() override;
+
+	//BlockDevice
+	size_t block_size() override;
+
+	//File
+	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+
+protected:
+	//DiskDevice
+	Result perform_request(BlockRequest& request) override;
+	size_t max_active_requests() override;
+
+	//VirtIOPCIDevice
+	void handle_queue_irq() override;
+
+private:
+	struct __attribute__((packed)) RequestHeader {
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t sector;
+	};
+
+	struct Slot {
+		UninterruptibleBooleanBlocker blocker;
+		kstd::Arc<VMRegion> region; ///< Holds the request header, then the status, then the indirect descriptor table.
+		kstd::Arc<VMRegion> bounce_region; ///< Allocated the first time a request's buffers can't be DMA'd to directly.
+	};
+
+	explicit VirtIOBlockDevice(PCI::Address addr);
+
+	/** Takes a free slot. There's always one, since there are never more active requests than slots. **/
+	size_t acquire_slot();
+	void release_slot(size_t slot);
+
+	/**
+	 * Fills in a slot's descriptors with the request header, the physical memory backing part of a request, and the
+	 * status byte, so the disk can transfer to the request's buffers directly.
+	 * @return The number of sectors the descriptors cover, or 0 if the request's buffers can't be used for DMA.
+	 */
+	size_t build_descriptors(size_t slot, BlockRequest& request, size_t sector_offset, size_t num_sectors, size_t& num_descriptors);
+	/** Fills in a slot's descriptors with the request header, the slot's bounce buffer, and the status byte. **/
+	size_t use_bounce_descriptors(size_t slot, size_t num_sectors, bool write);
+	/**
+	 * Fills in the header and status descriptors around a slot's data descriptors and chains them all together.
+	 * @return The total number of descriptors in the chain.
+	 */
+	size_t link_descriptors(size_t slot, size_t num_data_descriptors, bool write);
+	/** Sends the request described by a slot's descriptors to the disk, and waits for it to complete. **/
+	Result issue_request(size_t slot, bool write, uint64_t sector, size_t num_descriptors);
+
+	/** The descriptor table used by a slot, which is either its indirect table or its share of the queue's. **/
+	VirtIO::Descriptor* slot_descriptors(size_t slot);
+	/** The index of the first descriptor a slot uses in its descriptor table. **/
+	uint16_t slot_first_descriptor(size_t slot);
+	/** The number of descriptors each slot can use. **/
+	size_t slot_num_descriptors();
+
+	bool _present = false;
+	uint64_t _max_addressable_block = 0;
+	bool _read_only = false;
+	bool _use_indirect = false;
+	size_t _max_segments = 0;
+
+	kstd::Arc<VirtQueue> _queue;
+	size_t _num_slots = 0;
+	Slot _slots[VIRTIO_BLK_MAX_REQUESTS];
+	uint32_t _free_slots = 0;
+	SpinLock _slot_lock;
+};
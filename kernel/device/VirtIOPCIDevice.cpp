@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "VirtIOPCIDevice.h"
+#include <kernel/IO.h>
+#include <kernel/tasking/TaskManager.h>
+
+PCI::Address VirtIOPCIDevice::find(uint16_t device_id) {
+	struct Search {
+		uint16_t device_id;
+		PCI::Address found;
+	} search = {device_id, {0, 0, 0}};
+	PCI::enumerate_devices([](PCI::Address addr, PCI::ID id, uint16_t type, void* data) {
+		auto* search = (Search*) data;
+		if(id.vendor == VIRTIO_PCI_VENDOR && id.device == search->device_id && search->found.is_zero())
+			search->found = addr;
+	}, &search);
+	return search.found;
+}
+
+VirtIOPCIDevice::VirtIOPCIDevice(PCI::Address addr):
+	IRQHandler(PCI::read_byte(addr, PCI_INTERRUPT_LINE)),
+	_pci_addr(addr),
+	_io_base(PCI::read_word(addr, PCI_BAR0) & ~1)
+{
+	PCI::enable_interrupt(addr);
+	PCI::enable_bus_mastering(addr);
+}
+
+uint32_t VirtIOPCIDevice::negotiate_features(uint32_t supported_features) {
+	//Reset the device and let it know we found it and know how to drive it
+	IO::outb(_io_base + VIRTIO_PCI_DEVICE_STATUS, 0);
+	IO::outb(_io_base + VIRTIO_PCI_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+	IO::outb(_io_base + VIRTIO_PCI_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+	uint32_t features = IO::inl(_io_base + VIRTIO_PCI_DEVICE_FEATURES) & supported_features;
+	IO::outl(_io_base + VIRTIO_PCI_GUEST_FEATURES, features);
+	return features;
+}
+
+ResultRet<kstd::Arc<VirtQueue>> VirtIOPCIDevice::setup_queue(uint16_t index, bool event_idx) {
+	IO::outw(_io_base + VIRTIO_PCI_QUEUE_SELECT, index);
+	uint16_t size = IO::inw(_io_base + VIRTIO_PCI_QUEUE_SIZE);
+	if(!size)
+		return Result(-ENOENT);
+	auto queue = kstd::make_shared<VirtQueue>(index, size, event_idx);
+	IO::outl(_io_base + VIRTIO_PCI_QUEUE_ADDRESS, queue->physical_address() / VIRTQ_ALIGN);
+	return queue;
+}
+
+void VirtIOPCIDevice::finish_init() {
+	IO::outb(_io_base + VIRTIO_PCI_DEVICE_STATUS, IO::inb(_io_base + VIRTIO_PCI_DEVICE_STATUS) | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void VirtIOPCIDevice::fail_init() {
+	IO::outb(_io_base + VIRTIO_PCI_DEVICE_STATUS, IO::inb(_io_base + VIRTIO_PCI_DEVICE_STATUS) | VIRTIO_STATUS_FAILED);
+}
+
+void VirtIOPCIDevice::notify(const VirtQueue& queue) {
+	IO::outw(_io_base + VIRTIO_PCI_QUEUE_NOTIFY, queue.index());
+}
+
+uint8_t VirtIOPCIDevice::read_config8(size_t offset) {
+	return IO::inb(_io_base + VIRTIO_PCI_DEVICE_CONFIG + offset);
+}
+
+uint16_t VirtIOPCIDevice::read_config16(size_t offset) {
+	return IO::inw(_io_base + VIRTIO_PCI_DEVICE_CONFIG + offset);
+}
+
+uint32_t VirtIOPCIDevice::read_config32(size_t offset) {
+	return IO::inl(_io_base + VIRTIO_PCI_DEVICE_CONFIG + offset);
+}
+
+uint64_t VirtIOPCIDevice::read_config64(size_t offset) {
+	return read_config32(offset) | ((uint64_t) read_config32(offset + 4) << 32);
+}
+
+void VirtIOPCIDevice::handle_irq(Registers* regs) {
+	//Reading the ISR status acknowledges the interrupt
+	uint8_t isr = IO::inb(_io_base + VIRTIO_PCI_ISR_STATUS);
+	if(!isr)
+		return; //Interrupt wasn't for this
+	if(isr & VIRTIO_ISR_QUEUE)
+		handle_queue_irq();
+	if(isr & VIRTIO_ISR_CONFIG)
+		handle_config_irq();
+	TaskManager::yield_if_idle();
+}
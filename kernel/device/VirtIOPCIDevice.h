@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "VirtIO.h"
+#include "VirtQueue.h"
+#include <kernel/pci/PCI.h>
+#include <kernel/interrupt/IRQHandler.h>
+
+/**
+ * The legacy virtio-pci transport, which talks to a virtio device through the I/O ports in its first BAR. Drivers for
+ * specific virtio devices build on top of this.
+ */
+class VirtIOPCIDevice: public IRQHandler {
+public:
+	/** Finds the first virtio device on the PCI bus with the given PCI device ID. Returns a zero address if there isn't one. **/
+	static PCI::Address find(uint16_t device_id);
+
+protected:
+	explicit VirtIOPCIDevice(PCI::Address addr);
+
+	/**
+	 * Resets the device and negotiates features with it.
+	 * @param supported_features The features the driver supports.
+	 * @return The features both the driver and device support, which are now in use.
+	 */
+	uint32_t negotiate_features(uint32_t supported_features);
+	/** Sets up one of the device's virtqueues. Fails if the device doesn't have it. **/
+	ResultRet<kstd::Arc<VirtQueue>> setup_queue(uint16_t index, bool event_idx);
+	/** Tells the device the driver is ready to go. **/
+	void finish_init();
+	/** Tells the device the driver gave up on it. **/
+	void fail_init();
+	/** Tells the device that new chains are available in a queue. **/
+	void notify(const VirtQueue& queue);
+
+	uint8_t read_config8(size_t offset);
+	uint16_t read_config16(size_t offset);
+	uint32_t read_config32(size_t offset);
+	uint64_t read_config64(size_t offset);
+
+	/** Called when the device uses chains in any of its queues. **/
+	virtual void handle_queue_irq() = 0;
+	/** Called when the device's configuration changes. **/
+	virtual void handle_config_irq() {}
+
+	//IRQHandler
+	void handle_irq(Registers* regs) override;
+
+	PCI::Address _pci_addr;
+	uint16_t _io_base;
+};
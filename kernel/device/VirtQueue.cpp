@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "VirtQueue.h"
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/kstd/cstring.h>
+
+VirtQueue::VirtQueue(uint16_t index, uint16_t size, bool event_idx):
+	_index(index), _size(size), _event_idx(event_idx)
+{
+	//The descriptors and available ring come first, and the used ring starts at the next aligned address
+	size_t avail_offset = sizeof(VirtIO::Descriptor) * size;
+	size_t used_offset = avail_offset + sizeof(VirtIO::AvailableRing) + sizeof(uint16_t) * (size + 1);
+	used_offset = ((used_offset + VIRTQ_ALIGN - 1) / VIRTQ_ALIGN) * VIRTQ_ALIGN;
+	size_t total_size = used_offset + sizeof(VirtIO::UsedRing) + sizeof(VirtIO::UsedElement) * size + sizeof(uint16_t);
+
+	_region = MM.alloc_dma_region(total_size);
+	memset((void*) _region->start(), 0, _region->size());
+	_descriptors = (VirtIO::Descriptor*) _region->start();
+	_avail = (VirtIO::AvailableRing*) (_region->start() + avail_offset);
+	_used = (VirtIO::UsedRing*) (_region->start() + used_offset);
+}
+
+PhysicalAddress VirtQueue::physical_address() const {
+	return _region->object()->physical_page(0).paddr();
+}
+
+bool VirtQueue::submit(uint16_t head) {
+	LOCK(_lock);
+	uint16_t old_index = _avail->index;
+	uint16_t new_index = old_index + 1;
+	_avail->ring[old_index % _size] = head;
+
+	//The device has to see the descriptors and the ring entry before the new index, and the index before we check
+	//whether it wants to be notified
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	_avail->index = new_index;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if(_event_idx) {
+		//Only notify if the device asked to be notified somewhere between the old and new index
+		uint16_t event = avail_event();
+		return (uint16_t) (new_index - event - 1) < (uint16_t) (new_index - old_index);
+	}
+	return !(_used->flags & VIRTQ_USED_F_NO_NOTIFY);
+}
+
+bool VirtQueue::pop_used(VirtIO::UsedElement& element) {
+	if(_last_used == _used->index)
+		return false;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	auto& used = _used->ring[_last_used % _size];
+	element.id = used.id;
+	element.length = used.length;
+	_last_used++;
+	return true;
+}
+
+void VirtQueue::disable_interrupts() {
+	if(_event_idx)
+		used_event() = _last_used - 1;
+	else
+		_avail->flags = _avail->flags | VIRTQ_AVAIL_F_NO_INTERRUPT;
+}
+
+bool VirtQueue::enable_interrupts() {
+	if(_event_idx)
+		used_event() = _last_used;
+	else
+		_avail->flags = _avail->flags & ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return _last_used == _used->index;
+}
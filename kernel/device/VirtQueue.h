@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "VirtIO.h"
+#include <kernel/memory/VMRegion.h>
+#include <kernel/tasking/SpinLock.h>
+
+/**
+ * A legacy split virtqueue, made up of a descriptor table, a ring of descriptor chains made available to the device,
+ * and a ring of chains the device has finished using. The layout of the descriptor table is left up to the driver.
+ */
+class VirtQueue {
+public:
+	/**
+	 * Allocates a virtqueue.
+	 * @param index The index of the queue on its device.
+	 * @param size The number of descriptors in the queue, as given by the device.
+	 * @param event_idx Whether VIRTIO_F_RING_EVENT_IDX was negotiated, which is used to suppress notifications and interrupts.
+	 */
+	VirtQueue(uint16_t index, uint16_t size, bool event_idx);
+
+	uint16_t index() const { return _index; }
+	uint16_t size() const { return _size; }
+	/** The physical address of the queue, which is given to the device. **/
+	PhysicalAddress physical_address() const;
+	VirtIO::Descriptor* descriptors() const { return _descriptors; }
+
+	/** Makes the descriptor chain starting at head available to the device. Returns whether the device needs to be notified. **/
+	bool submit(uint16_t head);
+	/** Pops the next chain the device finished using into element. Returns false if there aren't any. **/
+	bool pop_used(VirtIO::UsedElement& element);
+	/** Asks the device not to interrupt when it uses chains. **/
+	void disable_interrupts();
+	/** Asks the device to interrupt when it uses chains again. Returns false if some were used in the meantime. **/
+	bool enable_interrupts();
+
+private:
+	inline volatile uint16_t& used_event() { return _avail->ring[_size]; }
+	inline volatile uint16_t& avail_event() { return *(volatile uint16_t*) &_used->ring[_size]; }
+
+	uint16_t _index;
+	uint16_t _size;
+	bool _event_idx;
+	kstd::Arc<VMRegion> _region;
+	VirtIO::Descriptor* _descriptors;
+	volatile VirtIO::AvailableRing* _avail;
+	volatile VirtIO::UsedRing* _used;
+	uint16_t _last_used = 0; ///< The index in the used ring of the next chain to pop.
+	SpinLock _lock;
+};
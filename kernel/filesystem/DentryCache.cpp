@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "DentryCache.h"
+#include "Filesystem.h"
+
+DentryCache::DentryCache() {
+	for(auto& bucket : _buckets)
+		bucket = nullptr;
+	for(auto& generation : _generations)
+		generation = 0;
+}
+
+DentryCache::~DentryCache() {
+	clear();
+}
+
+bool DentryCache::lookup(const kstd::Arc<LinkedInode>& parent, const kstd::string& name, kstd::Arc<Inode>& inode, kstd::Arc<LinkedInode>& link) {
+	auto directory = parent->inode();
+	size_t name_hash = hash(directory->fs.fsid(), directory->id, name);
+
+	LOCK(_lock);
+	auto* entry = find_entry(directory->fs.fsid(), directory->id, name, name_hash);
+
+	//Entries for inodes that were freed or deleted out from under us are stale
+	kstd::Arc<Inode> entry_inode;
+	if(entry && !entry->negative) {
+		entry_inode = entry->inode.lock();
+		if(!entry_inode || !entry_inode->exists()) {
+			remove_entry(entry);
+			entry = nullptr;
+		}
+	}
+
+	if(!entry) {
+		_misses++;
+		return false;
+	}
+
+	if(entry->negative)
+		_negative_hits++;
+	else
+		_hits++;
+	unlink(entry);
+	link_back(entry);
+
+	inode = entry_inode;
+	auto entry_link = entry->link.lock();
+	if(entry_link && entry_link->parent().get() == parent.get())
+		link = entry_link;
+	else
+		link = kstd::Arc<LinkedInode>(nullptr);
+	return true;
+}
+
+size_t DentryCache::generation(Inode& directory) {
+	LOCK(_lock);
+	return generation_of(directory.fs.fsid(), directory.id);
+}
+
+void DentryCache::insert(const kstd::Arc<LinkedInode>& parent, const kstd::string& name, const kstd::Arc<Inode>& inode, const kstd::Arc<LinkedInode>& link, size_t generation) {
+	auto directory = parent->inode();
+	size_t name_hash = hash(directory->fs.fsid(), directory->id, name);
+
+	LOCK(_lock);
+
+	//If the directory changed while the caller was looking the name up, what they found may already be out of date
+	if(generation_of(directory->fs.fsid(), directory->id) != generation)
+		return;
+
+	auto* entry = find_entry(directory->fs.fsid(), directory->id, name, name_hash);
+	if(entry) {
+		if(entry->negative)
+			_num_negative_entries--;
+		unlink(entry);
+	} else {
+		if(_num_entries >= DENTRY_CACHE_MAX_ENTRIES) {
+			remove_entry(_lru_head);
+			_evictions++;
+		}
+		entry = new Entry {directory->fs.fsid(), directory->id, name, name_hash};
+		auto& bucket = _buckets[name_hash & (DENTRY_CACHE_BUCKETS - 1)];
+		entry->bucket_next = bucket;
+		bucket = entry;
+		_num_entries++;
+	}
+
+	entry->negative = !inode;
+	entry->inode = inode;
+	entry->link = link;
+	if(entry->negative)
+		_num_negative_entries++;
+	link_back(entry);
+}
+
+void DentryCache::invalidate(Inode& directory, const kstd::string& name) {
+	LOCK(_lock);
+	generation_of(directory.fs.fsid(), directory.id)++;
+	auto* entry = find_entry(directory.fs.fsid(), directory.id, name, hash(directory.fs.fsid(), directory.id, name));
+	if(entry)
+		remove_entry(entry);
+}
+
+void DentryCache::invalidate_directory(Inode& directory) {
+	LOCK(_lock);
+	generation_of(directory.fs.fsid(), directory.id)++;
+	auto* entry = _lru_head;
+	while(entry) {
+		auto* next = entry->lru_next;
+		if(entry->fsid == directory.fs.fsid() && entry->directory == directory.id)
+			remove_entry(entry);
+		entry = next;
+	}
+}
+
+void DentryCache::clear() {
+	LOCK(_lock);
+	for(auto& generation : _generations)
+		generation++;
+	while(_lru_head)
+		remove_entry(_lru_head);
+}
+
+DentryCache::Stats DentryCache::stats() {
+	LOCK(_lock);
+	return {
+		.hits = _hits,
+		.negative_hits = _negative_hits,
+		.misses = _misses,
+		.evictions = _evictions,
+		.entries = _num_entries,
+		.negative_entries = _num_negative_entries
+	};
+}
+
+size_t DentryCache::directory_hash(uint8_t fsid, ino_t directory) {
+	//FNV-1a over the filesystem and directory
+	size_t hash = 2166136261u;
+	auto mix = [&](uint8_t byte) {
+		hash ^= byte;
+		hash *= 16777619u;
+	};
+	mix(fsid);
+	for(size_t i = 0; i < sizeof(ino_t); i++)
+		mix((directory >> (i * 8)) & 0xFF);
+	return hash;
+}
+
+size_t DentryCache::hash(uint8_t fsid, ino_t directory, const kstd::string& name) {
+	//Continue the directory's hash over the name
+	size_t hash = directory_hash(fsid, directory);
+	for(size_t i = 0; i < name.length(); i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+size_t& DentryCache::generation_of(uint8_t fsid, ino_t directory) {
+	return _generations[directory_hash(fsid, directory) & (DENTRY_CACHE_GENERATIONS - 1)];
+}
+
+DentryCache::Entry* DentryCache::find_entry(uint8_t fsid, ino_t directory, const kstd::string& name, size_t hash) {
+	auto* entry = _buckets[hash & (DENTRY_CACHE_BUCKETS - 1)];
+	while(entry) {
+		if(entry->hash == hash && entry->fsid == fsid && entry->directory == directory && entry->name == name)
+			return entry;
+		entry = entry->bucket_next;
+	}
+	return nullptr;
+}
+
+void DentryCache::remove_entry(Entry* entry) {
+	auto* link = &_buckets[entry->hash & (DENTRY_CACHE_BUCKETS - 1)];
+	while(*link != entry)
+		link = &(*link)->bucket_next;
+	*link = entry->bucket_next;
+	unlink(entry);
+	if(entry->negative)
+		_num_negative_entries--;
+	_num_entries--;
+	delete entry;
+}
+
+void DentryCache::link_back(Entry* entry) {
+	entry->lru_next = nullptr;
+	entry->lru_prev = _lru_tail;
+	if(_lru_tail)
+		_lru_tail->lru_next = entry;
+	else
+		_lru_head = entry;
+	_lru_tail = entry;
+}
+
+void DentryCache::unlink(Entry* entry) {
+	if(entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		_lru_head = entry->lru_next;
+	if(entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		_lru_tail = entry->lru_prev;
+}
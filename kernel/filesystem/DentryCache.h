@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/kstd/Arc.h>
+#include <kernel/kstd/string.h>
+#include <kernel/tasking/SpinLock.h>
+#include "Inode.h"
+#include "LinkedInode.h"
+
+/** The number of hash buckets in the dentry cache. Must be a power of two. **/
+#define DENTRY_CACHE_BUCKETS 512
+/** The maximum number of entries in the dentry cache before the least recently used ones are evicted. **/
+#define DENTRY_CACHE_MAX_ENTRIES 2048
+/** The number of generation counters directories are hashed into. Must be a power of two. **/
+#define DENTRY_CACHE_GENERATIONS 256
+
+/**
+ * Caches the results of looking up names in directories, so that resolving a path doesn't have to go to the filesystem
+ * for every component. Entries are keyed by the directory's inode and the name, and can be negative to remember that
+ * a name doesn't exist. Each entry also remembers the LinkedInode last resolved through it, so that paths resolved from
+ * the same parent reuse the same LinkedInode chain.
+ *
+ * Entries only hold weak references, so the cache never keeps an inode or LinkedInode chain alive by itself. Each
+ * directory also has a generation that's bumped whenever one of its entries is invalidated, so that a lookup that
+ * raced with a change to the directory doesn't cache what it found.
+ */
+class DentryCache {
+public:
+	struct Stats {
+		size_t hits; ///< The number of lookups of names that were cached as existing.
+		size_t negative_hits; ///< The number of lookups of names that were cached as not existing.
+		size_t misses; ///< The number of lookups that had to go to the filesystem.
+		size_t evictions; ///< The number of entries evicted to make room for others.
+		size_t entries; ///< The number of entries in the cache.
+		size_t negative_entries; ///< The number of entries for names that don't exist.
+	};
+
+	DentryCache();
+	~DentryCache();
+	DentryCache(const DentryCache& other) = delete;
+
+	/**
+	 * Looks up a name in a directory.
+	 * @param parent The directory to look the name up in.
+	 * @param inode Set to the inode with the name, or nullptr if the name is cached as not existing.
+	 * @param link Set to the cached LinkedInode for the name if it was resolved through the same parent, or nullptr.
+	 * @return Whether the name was cached.
+	 */
+	bool lookup(const kstd::Arc<LinkedInode>& parent, const kstd::string& name, kstd::Arc<Inode>& inode, kstd::Arc<LinkedInode>& link);
+	/** Returns the current generation of a directory. This must be sampled before looking a name up in the filesystem. **/
+	size_t generation(Inode& directory);
+	/**
+	 * Caches the result of looking up a name in a directory. A null inode means the name doesn't exist.
+	 * @param generation The directory's generation from before the lookup. If it's changed since, nothing is cached.
+	 */
+	void insert(const kstd::Arc<LinkedInode>& parent, const kstd::string& name, const kstd::Arc<Inode>& inode, const kstd::Arc<LinkedInode>& link, size_t generation);
+	/**
+	 * Removes the entry for a name in a directory. Must be called whenever an entry is added to or removed from a
+	 * directory, after the filesystem has been changed.
+	 */
+	void invalidate(Inode& directory, const kstd::string& name);
+	/** Removes all of the entries in a directory. **/
+	void invalidate_directory(Inode& directory);
+	/** Removes all entries. **/
+	void clear();
+
+	Stats stats();
+
+private:
+	struct Entry {
+		uint8_t fsid;
+		ino_t directory;
+		kstd::string name;
+		size_t hash;
+		bool negative; ///< Whether the name doesn't exist.
+		kstd::Weak<Inode> inode;
+		kstd::Weak<LinkedInode> link;
+		Entry* bucket_next = nullptr;
+		Entry* lru_prev = nullptr;
+		Entry* lru_next = nullptr;
+	};
+
+	static size_t directory_hash(uint8_t fsid, ino_t directory);
+	static size_t hash(uint8_t fsid, ino_t directory, const kstd::string& name);
+	size_t& generation_of(uint8_t fsid, ino_t directory);
+	Entry* find_entry(uint8_t fsid, ino_t directory, const kstd::string& name, size_t hash);
+	void remove_entry(Entry* entry);
+	void link_back(Entry* entry);
+	void unlink(Entry* entry);
+
+	Entry* _buckets[DENTRY_CACHE_BUCKETS];
+	size_t _generations[DENTRY_CACHE_GENERATIONS]; ///< Shared by the directories that hash to the same slot.
+	Entry* _lru_head = nullptr; ///< The least recently used entry.
+	Entry* _lru_tail = nullptr; ///< The most recently used entry.
+	size_t _num_entries = 0;
+	size_t _num_negative_entries = 0;
+	size_t _hits = 0;
+	size_t _negative_hits = 0;
+	size_t _misses = 0;
+	size_t _evictions = 0;
+	SpinLock _lock;
+};
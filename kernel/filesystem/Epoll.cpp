@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "Epoll.h"
+#include "FileDescriptor.h"
+#include <kernel/tasking/PollBlocker.h>
+#include <kernel/tasking/TaskManager.h>
+
+Epoll::Epoll() = default;
+Epoll::~Epoll() = default;
+
+Result Epoll::control(int op, int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event) {
+	if(fd->file()->is_epoll())
+		return Result(-EINVAL);
+
+	LOCK(_lock);
+
+	//Find the existing entry for the file descriptor, forgetting about it if it was closed
+	size_t index = _interests.size();
+	for(size_t i = 0; i < _interests.size(); i++) {
+		if(_interests[i].fd_num != fd_num)
+			continue;
+		if(_interests[i].fd.lock() == fd)
+			index = i;
+		else
+			_interests.erase(i);
+		break;
+	}
+	bool exists = index < _interests.size();
+
+	switch(op) {
+		case EPOLL_CTL_ADD:
+			if(exists)
+				return Result(-EEXIST);
+			_interests.push_back({fd_num, fd, event.events, event.data});
+			return Result(SUCCESS);
+
+		case EPOLL_CTL_MOD:
+			if(!exists)
+				return Result(-ENOENT);
+			_interests[index].events = event.events;
+			_interests[index].data = event.data;
+			return Result(SUCCESS);
+
+		case EPOLL_CTL_DEL:
+			if(!exists)
+				return Result(-ENOENT);
+			_interests.erase(index);
+			return Result(SUCCESS);
+
+		default:
+			return Result(-EINVAL);
+	}
+}
+
+ResultRet<kstd::vector<epoll_event>> Epoll::wait(size_t max_events, Time timeout) {
+	//Take a strong reference to each file descriptor we're interested in, since the blocker is checked by the scheduler
+	kstd::vector<PollBlocker::PollFD> polls;
+	kstd::vector<size_t> indices;
+	{
+		LOCK(_lock);
+		polls.reserve(_interests.size());
+		for(size_t i = 0; i < _interests.size(); i++) {
+			auto fd = _interests[i].fd.lock();
+			if(!fd) {
+				_interests.erase(i--);
+				continue;
+			}
+			if(!(_interests[i].events & (EPOLLIN | EPOLLOUT)))
+				continue;
+			polls.push_back({_interests[i].fd_num, fd, (short) (_interests[i].events & (EPOLLIN | EPOLLOUT))});
+			indices.push_back(i);
+		}
+	}
+
+	PollBlocker blocker(polls, timeout);
+	TaskManager::current_thread()->block(blocker);
+	if(blocker.was_interrupted())
+		return Result(-EINTR);
+
+	//Collect every file descriptor that's ready, starting after the last one we reported
+	kstd::vector<epoll_event> events;
+	LOCK(_lock);
+	size_t start = polls.size() ? _next % polls.size() : 0;
+	for(size_t i = 0; i < polls.size() && events.size() < max_events; i++) {
+		size_t poll_index = (start + i) % polls.size();
+		short revents = PollBlocker::ready_events(polls[poll_index]);
+		if(!revents)
+			continue;
+
+		//Make sure the interest didn't change while we were waiting
+		size_t index = indices[poll_index];
+		if(index >= _interests.size() || _interests[index].fd_num != polls[poll_index].fd_num)
+			continue;
+		auto& interest = _interests[index];
+		revents &= interest.events;
+		if(!revents)
+			continue;
+
+		events.push_back({(uint32_t) revents, interest.data});
+		if(interest.events & EPOLLONESHOT)
+			interest.events = 0;
+		_next = poll_index + 1;
+	}
+
+	return events;
+}
+
+bool Epoll::is_epoll() {
+	return true;
+}
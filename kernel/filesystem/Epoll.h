@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/filesystem/File.h>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/time/Time.h>
+#include <kernel/api/epoll.h>
+
+/**
+ * An epoll instance. It keeps a list of the file descriptors a process is interested in, so that they don't have to
+ * be passed in (and checked) every time it waits, and reports all of the ones that are ready each time it does.
+ */
+class Epoll: public File {
+public:
+	Epoll();
+	~Epoll() override;
+
+	/** Adds, modifies, or removes (depending on op) the interest in a file descriptor. **/
+	Result control(int op, int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event);
+	/**
+	 * Waits for any of the file descriptors in the interest list to be ready, or for the timeout to pass.
+	 * @param max_events The most events to return. If more are ready, the rest are returned by the next wait.
+	 * @return The events for each file descriptor that's ready.
+	 */
+	ResultRet<kstd::vector<epoll_event>> wait(size_t max_events, Time timeout);
+
+	//File
+	bool is_epoll() override;
+
+private:
+	struct Interest {
+		int fd_num;
+		kstd::Weak<FileDescriptor> fd; ///< Weak, so that the file descriptor is dropped from the list once it's closed.
+		uint32_t events;
+		epoll_data_t data;
+	};
+
+	kstd::vector<Interest> _interests;
+	size_t _next = 0; ///< Where to start looking for ready file descriptors, so they're all reported fairly.
+	SpinLock _lock;
+};
@@ -52,6 +52,10 @@ bool File::is_fifo() {
 	return false;
 }
 
+bool File::is_epoll() {
+	return false;
+}
+
 ssize_t File::read(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
 	return 0;
 }
@@ -85,3 +89,14 @@ bool File::can_write(const FileDescriptor& fd) {
 	return true;
 }
 
+Result File::sync() {
+	return Result(EINVAL);
+}
+
+Result File::sync_range(size_t offset, size_t count) {
+	return sync();
+}
+
+void File::prefetch(size_t offset, size_t count) {
+
+}
@@ -37,11 +37,21 @@ public:
 	virtual bool is_pty_mux();
 	virtual bool is_pty();
 	virtual bool is_fifo();
+	virtual bool is_epoll();
 	virtual int ioctl(unsigned request, SafePointer<void*> argp);
 	virtual void open(FileDescriptor& fd, int options);
 	virtual void close(FileDescriptor& fd);
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	/** Writes any cached data for the file to its backing storage. Fails with EINVAL if the file doesn't support it. **/
+	virtual Result sync();
+	/** Writes any cached data for count bytes of the file starting at offset to its backing storage. Defaults to sync(). **/
+	virtual Result sync_range(size_t offset, size_t count);
+	/**
+	 * Hints that count bytes starting at offset will be read soon, so they can be cached ahead of time. It's only a
+	 * hint, so the default does nothing, for files that don't have a cache to fill.
+	 */
+	virtual void prefetch(size_t offset, size_t count);
 protected:
 	File();
 };
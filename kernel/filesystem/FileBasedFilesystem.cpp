@@ -74,22 +74,11 @@ Result FileBasedFilesystem::read_block(size_t block, uint8_t *buffer) {
 }
 
 Result FileBasedFilesystem::read_blocks(size_t block, size_t count, uint8_t *buffer) {
-	Result res = Result(SUCCESS);
-	for(size_t i = 0; i < count; i++) {
-		res = read_block(block + i, buffer + block_size() * i);
-		if(res.is_error())
-			return res;
-	}
-	return Result(SUCCESS);
+	return read_data(block, 0, count * block_size(), KernelPointer<uint8_t>(buffer));
 }
 
 Result FileBasedFilesystem::write_blocks(size_t block, size_t count, const uint8_t* buffer) {
-	Result res = Result(SUCCESS);
-	for(size_t i = 0; i < count; i++) {
-		res = write_block(block + i, buffer + i * block_size());
-		if(res.is_error()) return Result(res);
-	}
-	return Result(SUCCESS);
+	return write_data(block, 0, count * block_size(), KernelPointer<uint8_t>((uint8_t*) buffer));
 }
 
 Result FileBasedFilesystem::write_block(size_t block, const uint8_t* buffer) {
@@ -102,6 +91,36 @@ Result FileBasedFilesystem::write_block(size_t block, const uint8_t* buffer) {
 	return Result(SUCCESS);
 }
 
+Result FileBasedFilesystem::read_data(size_t block, size_t offset, size_t length, SafePointer<uint8_t> buffer) {
+	ssize_t nread = _file->file()->read(*_file, block * block_size() + offset, buffer, length);
+	if(nread < 0)
+		return Result(nread);
+	if(nread != length)
+		return Result(-EIO);
+	return Result(SUCCESS);
+}
+
+Result FileBasedFilesystem::write_data(size_t block, size_t offset, size_t length, SafePointer<uint8_t> buffer) {
+	ssize_t nwrote = _file->file()->write(*_file, block * block_size() + offset, buffer, length);
+	if(nwrote < 0)
+		return Result(nwrote);
+	if(nwrote != length)
+		return Result(-EIO);
+	return Result(SUCCESS);
+}
+
+void FileBasedFilesystem::prefetch_data(size_t block, size_t length) {
+	_file->file()->prefetch(block * block_size(), length);
+}
+
+Result FileBasedFilesystem::sync_data(size_t block, size_t length) {
+	return _file->file()->sync_range(block * block_size(), length);
+}
+
+Result FileBasedFilesystem::sync() {
+	return _file->file()->sync();
+}
+
 Result FileBasedFilesystem::zero_block(size_t block) {
 	uint8_t zero_buf[block_size()];
 	memset(zero_buf, 0, block_size());
@@ -43,6 +43,15 @@ public:
 	Result write_block(size_t block, const uint8_t* buffer);
 	Result write_blocks(size_t block, size_t count, const uint8_t* buffer);
 	Result zero_block(size_t block);
+
+	/** Reads length bytes starting offset bytes into the given block straight into the buffer. **/
+	Result read_data(size_t block, size_t offset, size_t length, SafePointer<uint8_t> buffer);
+	/** Writes length bytes from the buffer starting offset bytes into the given block. **/
+	Result write_data(size_t block, size_t offset, size_t length, SafePointer<uint8_t> buffer);
+	/** Asks the underlying device to asynchronously cache length bytes starting at the given block. **/
+	void prefetch_data(size_t block, size_t length);
+	/** Writes back any cached data for length bytes starting at the given block to the underlying device. **/
+	Result sync_data(size_t block, size_t length);
 	Result truncate_block(size_t block, size_t new_size);
 
 	ResultRet<kstd::Arc<Inode>> get_cached_inode(ino_t id);
@@ -51,6 +60,7 @@ public:
 
 	virtual Inode* get_inode_rawptr(ino_t id);
 	virtual ResultRet<kstd::Arc<Inode>> get_inode(ino_t id);
+	Result sync() override;
 
 protected:
 	void set_block_size(size_t block_size);
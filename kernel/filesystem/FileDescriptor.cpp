@@ -28,6 +28,11 @@
 #include <kernel/terminal/PTYDevice.h>
 #include <kernel/terminal/PTYControllerDevice.h>
 #include <kernel/tasking/Process.h>
+#include <kernel/memory/AnonymousVMObject.h>
+#include <kernel/memory/MemoryManager.h>
+
+SpinLock FileDescriptor::s_copy_lock;
+kstd::Arc<VMRegion> FileDescriptor::s_copy_buffer;
 
 FileDescriptor::FileDescriptor(const kstd::Arc<File>& file, Process* owner): _file(file), _owner(owner ? owner->pid() : -1) {
 	if(file->is_inode())
@@ -94,7 +99,9 @@ FileDescriptor::~FileDescriptor() {
 	if(_file->is_pty())
 		((PTYDevice*) _file.get())->ref_dec();
 
-	_file->close(*this);
+	//Descriptors for devices, pipes and the like are never opened, so only close what was
+	if(_opened)
+		_file->close(*this);
 }
 
 
@@ -164,6 +171,8 @@ kstd::Arc<File> FileDescriptor::file() {
 }
 
 void FileDescriptor::open() {
+	ASSERT(!_opened);
+	_opened = true;
 	_file->open(*this, _options);
 }
 
@@ -199,11 +208,38 @@ ssize_t FileDescriptor::read(SafePointer<uint8_t> buffer, size_t count) {
 	if(!_readable) return -EBADF;
 	LOCK(lock);
 	if(_seek + count < 0) return -EOVERFLOW;
-	int ret = _file->read(*this, offset(), buffer, count);
-	if(_can_seek && ret > 0) _seek += ret;
+	off_t start = offset();
+	int ret = _file->read(*this, start, buffer, count);
+	if(_can_seek && ret > 0) {
+		_seek += ret;
+		if(_inode)
+			readahead(start, ret);
+	}
 	return ret;
 }
 
+void FileDescriptor::readahead(off_t start, size_t count) {
+	//Grow the window while reads are sequential, and stop reading ahead as soon as they aren't
+	if(start != _ra_next)
+		_ra_window = 0;
+	else if(!_ra_window)
+		_ra_window = READAHEAD_MIN_WINDOW;
+	else if(_ra_window < READAHEAD_MAX_WINDOW)
+		_ra_window *= 2;
+	_ra_next = start + count;
+	if(!_ra_window)
+		return;
+
+	//Only read ahead once we've read through half of what we last read ahead, so requests aren't tiny
+	if(_ra_end < _ra_next)
+		_ra_end = _ra_next;
+	if(_ra_end - _ra_next > (off_t) _ra_window / 2)
+		return;
+	off_t new_end = _ra_next + _ra_window;
+	_inode->readahead(_ra_end, new_end - _ra_end);
+	_ra_end = new_end;
+}
+
 size_t FileDescriptor::offset() const {
 	return _seek;
 }
@@ -227,6 +263,214 @@ ssize_t FileDescriptor::write(SafePointer<uint8_t> buffer, size_t count) {
 	return ret;
 }
 
+ssize_t FileDescriptor::pread(off_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	if(!_readable) return -EBADF;
+	if(!supports_offsets()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	if((off_t) (offset + count) < offset) return -EOVERFLOW;
+	//Positional reads don't touch the readahead state, so they can't break up the window of sequential read() calls
+	return _file->read(*this, offset, buffer, count);
+}
+
+ssize_t FileDescriptor::pwrite(off_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	if(!_writable) return -EBADF;
+	if(!supports_offsets()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	if((off_t) (offset + count) < offset) return -EOVERFLOW;
+	return _file->write(*this, offset, buffer, count);
+}
+
+ssize_t FileDescriptor::readv(SafePointer<struct iovec> iov, int iovcnt) {
+	if(!_readable) return -EBADF;
+	LOCK(lock);
+	off_t start = offset();
+	ssize_t ret = transfer_vector(start, iov, iovcnt, false);
+	if(_can_seek && ret > 0) {
+		_seek += ret;
+		if(_inode)
+			readahead(start, ret);
+	}
+	return ret;
+}
+
+ssize_t FileDescriptor::writev(SafePointer<struct iovec> iov, int iovcnt) {
+	if(!_writable) return -EBADF;
+	LOCK(lock);
+	if(_append && _can_seek && metadata().exists()) _seek = metadata().size;
+	ssize_t ret = transfer_vector(offset(), iov, iovcnt, true);
+	if(_can_seek && ret > 0) _seek += ret;
+	return ret;
+}
+
+ssize_t FileDescriptor::preadv(off_t offset, SafePointer<struct iovec> iov, int iovcnt) {
+	if(!_readable) return -EBADF;
+	if(!supports_offsets()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	//See pread
+	return transfer_vector(offset, iov, iovcnt, false);
+}
+
+ssize_t FileDescriptor::pwritev(off_t offset, SafePointer<struct iovec> iov, int iovcnt) {
+	if(!_writable) return -EBADF;
+	if(!supports_offsets()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	return transfer_vector(offset, iov, iovcnt, true);
+}
+
+ssize_t FileDescriptor::copy_to(FileDescriptor& out, off_t* in_offset, off_t* out_offset, size_t count) {
+	if(!_readable || !out._writable)
+		return -EBADF;
+	if((in_offset && *in_offset < 0) || (out_offset && *out_offset < 0))
+		return -EINVAL;
+	if(!count)
+		return 0;
+
+	//Copy through a kernel buffer, so the data is only copied once and never goes through userspace. The shared buffer
+	//is used if nobody else is copying through it, since either end may block for a long time while we hold it.
+	kstd::Arc<VMRegion> buffer_region;
+	bool shared_buffer = s_copy_lock.try_acquire();
+	if(shared_buffer) {
+		if(!s_copy_buffer) {
+			auto region_or_err = alloc_copy_buffer(FILE_COPY_CHUNK_SIZE);
+			if(!region_or_err.is_error())
+				s_copy_buffer = region_or_err.value();
+		}
+		if(s_copy_buffer) {
+			buffer_region = s_copy_buffer;
+		} else {
+			s_copy_lock.release();
+			shared_buffer = false;
+		}
+	}
+	if(!buffer_region) {
+		auto region_or_err = alloc_copy_buffer(min(count, (size_t) FILE_COPY_CHUNK_SIZE));
+		if(region_or_err.is_error())
+			return -ENOMEM;
+		buffer_region = region_or_err.value();
+	}
+	size_t buffer_size = min(count, buffer_region->size());
+	auto buffer = KernelPointer<uint8_t>((uint8_t*) buffer_region->start());
+
+	size_t ncopied = 0;
+	ssize_t error = 0;
+	while(ncopied < count) {
+		size_t to_read = min(count - ncopied, buffer_size);
+		ssize_t nread = in_offset ? pread(*in_offset + ncopied, buffer, to_read) : read(buffer, to_read);
+		if(nread <= 0) {
+			error = nread;
+			break;
+		}
+
+		size_t nwritten = 0;
+		while(nwritten < (size_t) nread) {
+			auto chunk = KernelPointer<uint8_t>(buffer.raw() + nwritten);
+			ssize_t ret = out_offset ? out.pwrite(*out_offset + ncopied + nwritten, chunk, nread - nwritten)
+									 : out.write(chunk, nread - nwritten);
+			if(ret <= 0) {
+				error = ret ? ret : -EIO;
+				break;
+			}
+			nwritten += ret;
+		}
+
+		//If we couldn't write everything we read, put back what's left over so it isn't lost
+		if(nwritten < (size_t) nread && !in_offset && _can_seek) {
+			LOCK(lock);
+			_seek -= nread - nwritten;
+		}
+		ncopied += nwritten;
+		if(error || (size_t) nread < to_read)
+			break;
+	}
+
+	if(shared_buffer)
+		s_copy_lock.release();
+
+	if(in_offset)
+		*in_offset += ncopied;
+	if(out_offset)
+		*out_offset += ncopied;
+	return ncopied ? (ssize_t) ncopied : error;
+}
+
+ResultRet<kstd::Arc<VMRegion>> FileDescriptor::alloc_copy_buffer(size_t size) {
+	auto object = AnonymousVMObject::alloc(size, "copy_buffer");
+	if(object.is_error())
+		return Result(-ENOMEM);
+	return MM.kernel_space()->map_object(object.value(), VMProt::RW);
+}
+
+bool FileDescriptor::supports_offsets() {
+	if(!_can_seek || _file->is_fifo())
+		return false;
+	auto meta = metadata();
+	return !meta.exists() || !IS_SOCKET(meta.mode);
+}
+
+ssize_t FileDescriptor::transfer_vector(off_t offset, SafePointer<struct iovec> iov, int iovcnt, bool write) {
+	if(iovcnt < 0 || iovcnt > IOV_MAX)
+		return -EINVAL;
+
+	//Copy the vector in first, since userspace could change it while we're using it
+	kstd::vector<struct iovec> vecs;
+	vecs.resize(iovcnt);
+	iov.read(vecs.storage(), iovcnt);
+	size_t total = 0;
+	for(auto& vec : vecs) {
+		total += vec.iov_len;
+		if(total < vec.iov_len || (ssize_t) total < 0)
+			return -EINVAL;
+	}
+	if((off_t) (offset + total) < offset)
+		return -EOVERFLOW;
+
+	//Anything other than a regular file may treat each read or write as a whole message (like sockets do) or need it
+	//to happen atomically (like pipes do), so those get all of the buffers in one go. The buffer is capped, since
+	//the size comes from userspace: reads just return less, and writes too big for it can't be atomic anyway.
+	auto meta = metadata();
+	if(iovcnt > 1 && !meta.is_simple_file() && (!write || total <= FILE_GATHER_MAX)) {
+		total = min(total, (size_t) FILE_GATHER_MAX);
+		auto* buf = (uint8_t*) kmalloc(total);
+		if(!buf)
+			return -ENOMEM;
+		ssize_t ret;
+		size_t pos = 0;
+		if(write) {
+			for(auto& vec : vecs) {
+				SafePointer<uint8_t>((uint8_t*) vec.iov_base, iov.is_user()).read(buf + pos, vec.iov_len);
+				pos += vec.iov_len;
+			}
+			ret = _file->write(*this, offset, KernelPointer<uint8_t>(buf), total);
+		} else {
+			ret = _file->read(*this, offset, KernelPointer<uint8_t>(buf), total);
+			for(size_t i = 0; i < vecs.size() && ret > 0 && pos < (size_t) ret; i++) {
+				size_t to_copy = min(vecs[i].iov_len, (size_t) ret - pos);
+				SafePointer<uint8_t>((uint8_t*) vecs[i].iov_base, iov.is_user()).write(buf + pos, to_copy);
+				pos += to_copy;
+			}
+		}
+		kfree(buf);
+		return ret;
+	}
+
+	//A message bigger than the gather buffer couldn't be sent in one piece
+	if(iovcnt > 1 && meta.exists() && IS_SOCKET(meta.mode))
+		return -EMSGSIZE;
+
+	size_t ntransferred = 0;
+	for(auto& vec : vecs) {
+		auto buffer = SafePointer<uint8_t>((uint8_t*) vec.iov_base, iov.is_user());
+		ssize_t ret = write ? _file->write(*this, offset + ntransferred, buffer, vec.iov_len)
+							: _file->read(*this, offset + ntransferred, buffer, vec.iov_len);
+		if(ret < 0)
+			return ntransferred ? ntransferred : ret;
+		ntransferred += ret;
+		if((size_t) ret < vec.iov_len)
+			break;
+	}
+	return ntransferred;
+}
+
 int FileDescriptor::ioctl(unsigned request, SafePointer<void*> argp) {
 	return _file->ioctl(request, argp);
 }
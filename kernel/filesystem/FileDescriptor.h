@@ -25,11 +25,22 @@
 #include <kernel/kstd/unix_types.h>
 #include "File.h"
 #include <kernel/memory/SafePointer.h>
+#include <kernel/api/uio.h>
+
+/** The readahead window used when a file descriptor starts reading sequentially. **/
+#define READAHEAD_MIN_WINDOW (4 * PAGE_SIZE)
+/** The readahead window doubles on each sequential read, up to this size. **/
+#define READAHEAD_MAX_WINDOW (32 * PAGE_SIZE)
+/** The most that copy_to() moves at once. Big enough for filesystems to allocate and write the destination in large batches. **/
+#define FILE_COPY_CHUNK_SIZE (64 * PAGE_SIZE)
+/** The most that a vectored read or write gathers into one buffer. Enough for a whole pipe buffer or socket message. **/
+#define FILE_GATHER_MAX (16 * PAGE_SIZE)
 
 class DirectoryEntry;
 class Device;
 class InodeMetadata;
 class Inode;
+class VMRegion;
 class FileDescriptor {
 public:
 	explicit FileDescriptor(const kstd::Arc<File>& file, Process* owner = nullptr);
@@ -58,6 +69,23 @@ public:
 	ssize_t read(SafePointer<uint8_t> buffer, size_t count);
 	ssize_t read_dir_entries(SafePointer<char> buffer, size_t len);
 	ssize_t write(SafePointer<uint8_t> buffer, size_t count);
+	/** Reads from the given offset in the file, without using or changing the file descriptor's offset. **/
+	ssize_t pread(off_t offset, SafePointer<uint8_t> buffer, size_t count);
+	/** Writes at the given offset in the file, without using or changing the file descriptor's offset. **/
+	ssize_t pwrite(off_t offset, SafePointer<uint8_t> buffer, size_t count);
+	/** Reads into each of the buffers in turn, stopping early if the file runs out of data. **/
+	ssize_t readv(SafePointer<struct iovec> iov, int iovcnt);
+	/** Writes the contents of each of the buffers in turn, as if they were one buffer. **/
+	ssize_t writev(SafePointer<struct iovec> iov, int iovcnt);
+	ssize_t preadv(off_t offset, SafePointer<struct iovec> iov, int iovcnt);
+	ssize_t pwritev(off_t offset, SafePointer<struct iovec> iov, int iovcnt);
+	/**
+	 * Copies data from this file descriptor to another one without it passing through userspace.
+	 * @param in_offset Where to read from. If null, this file descriptor's offset is used and advanced instead.
+	 * @param out_offset Where to write to. If null, the other file descriptor's offset is used and advanced instead.
+	 * @return The number of bytes copied, or a negative error code. Non-null offsets are advanced by the same amount.
+	 */
+	ssize_t copy_to(FileDescriptor& out, off_t* in_offset, off_t* out_offset, size_t count);
 	size_t offset() const;
 	int ioctl(unsigned request, SafePointer<void*> argp);
 
@@ -66,6 +94,18 @@ public:
 	bool is_fifo_writer() const;
 
 private:
+	/** Updates the readahead window after a sequential read(), and asks the inode to read ahead if needed. **/
+	void readahead(off_t start, size_t count);
+	/** Whether reads and writes can happen at an offset given by the caller, which isn't true of pipes and sockets. **/
+	bool supports_offsets();
+	/** Reads into or writes from a vector of buffers, starting at the given offset in the file. **/
+	ssize_t transfer_vector(off_t offset, SafePointer<struct iovec> iov, int iovcnt, bool write);
+	/** Maps a kernel buffer of the given size for copy_to to copy through. **/
+	static ResultRet<kstd::Arc<VMRegion>> alloc_copy_buffer(size_t size);
+
+	static SpinLock s_copy_lock; ///< Held while copy_to is using the shared copy buffer.
+	static kstd::Arc<VMRegion> s_copy_buffer; ///< The shared copy buffer, which is mapped the first time it's needed.
+
 	kstd::Arc<File> _file;
 	kstd::Arc<Inode> _inode;
 	pid_t _owner = -1;
@@ -80,6 +120,11 @@ private:
 
 	off_t _seek {0};
 	bool _is_fifo_writer = false;
+	bool _opened = false; ///< Whether the file was opened, and so has to be closed when we're destroyed.
+
+	off_t _ra_next {0}; ///< Where the next read has to start to count as sequential.
+	off_t _ra_end {0}; ///< The end of the range that has already been read ahead.
+	size_t _ra_window {0}; ///< The current readahead window, or zero if reads haven't been sequential.
 
 	SpinLock lock;
 };
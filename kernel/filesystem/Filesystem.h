@@ -32,6 +32,13 @@ public:
 	virtual ResultRet<kstd::Arc<Inode>> get_inode(ino_t id);
 	virtual ino_t root_inode_id();
 	virtual uint8_t fsid();
+	/** Writes any data the filesystem has cached to its backing storage. **/
+	virtual Result sync();
+	/**
+	 * Whether the VFS can cache the results of looking up names in this filesystem's directories. Only filesystems
+	 * whose directories are never changed except through the VFS should allow this.
+	 */
+	virtual bool can_cache_dentries();
 
 protected:
 	uint8_t _fsid;
@@ -78,6 +78,18 @@ bool Inode::can_write(const FileDescriptor& fd) {
 	return true;
 }
 
+void Inode::readahead(size_t start, size_t length) {
+
+}
+
+Result Inode::sync() {
+	return fs.sync();
+}
+
+ResultRet<kstd::Arc<VMObject>> Inode::data_vm_object() {
+	return kstd::Arc<VMObject>(nullptr);
+}
+
 kstd::Arc<InodeVMObject> Inode::shared_vm_object(kstd::string name) {
 	LOCK(m_vmobject_lock);
 
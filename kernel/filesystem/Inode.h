@@ -33,6 +33,7 @@ class Filesystem;
 class LinkedInode;
 class FileDescriptor;
 class InodeVMObject;
+class VMObject;
 
 class Inode: public kstd::ArcSelf<Inode> {
 public :
@@ -60,10 +61,23 @@ public :
 	virtual void close(FileDescriptor& fd) = 0;
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	/**
+	 * Asks the inode to asynchronously bring the given range into the cache, since it's likely to be read soon. It's
+	 * only a hint, so the default does nothing, for inodes whose data isn't read from a disk.
+	 */
+	virtual void readahead(size_t start, size_t length);
+	/** Writes the inode's data and metadata back to the disk. By default, the whole filesystem is written back. **/
+	virtual Result sync();
 
 	virtual InodeMetadata metadata();
 
 	kstd::Arc<InodeVMObject> shared_vm_object(kstd::string name);
+	/**
+	 * The memory that the inode's data is kept in, for inodes that keep their data in memory. Shared mappings of the
+	 * inode map this directly instead of reading the data into pages of their own. Inodes that don't keep their data
+	 * in memory return nullptr.
+	 */
+	virtual ResultRet<kstd::Arc<VMObject>> data_vm_object();
 
 protected:
 	InodeMetadata _metadata;
@@ -19,6 +19,7 @@
 
 #include "InodeFile.h"
 #include "Inode.h"
+#include "Filesystem.h"
 #include "DirectoryEntry.h"
 
 InodeFile::InodeFile(kstd::Arc<Inode> inode): _inode(inode) {
@@ -79,3 +80,7 @@ bool InodeFile::can_write(const FileDescriptor& fd) {
 	return _inode->can_write(fd);
 }
 
+Result InodeFile::sync() {
+	return _inode->sync();
+}
+
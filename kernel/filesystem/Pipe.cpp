@@ -21,66 +21,280 @@
 #include <kernel/tasking/Signal.h>
 #include <kernel/tasking/TaskManager.h>
 #include <kernel/filesystem/FileDescriptor.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/memory/AnonymousVMObject.h>
 
-Pipe::Pipe(): _queue(PIPE_SIZE) {}
+Pipe::Pipe() = default;
 
 Pipe::~Pipe() = default;
 
 void Pipe::add_reader() {
+	LOCK(_lock);
 	_readers++;
 }
 
 void Pipe::add_writer() {
+	LOCK(_lock);
 	_writers++;
 }
 
 void Pipe::remove_reader() {
+	LOCK(_lock);
 	_readers--;
+	if(!_readers)
+		_write_blocker.set_ready(true);
 }
 
 void Pipe::remove_writer() {
+	LOCK(_lock);
 	_writers--;
-	if(!_writers) {
-		_blocker.set_ready(true);
+	if(!_writers)
+		_read_blocker.set_ready(true);
+}
+
+ssize_t Pipe::splice_to(Pipe& other, size_t count, bool nonblock) {
+	if(&other == this)
+		return -EINVAL;
+	if(!count)
+		return 0;
+
+	while(true) {
+		BooleanBlocker* blocker;
+		{
+			//Always take the locks in the same order, so two splices going opposite ways can't deadlock
+			LOCK_N(this < &other ? _lock : other._lock, first_lock);
+			LOCK_N(this < &other ? other._lock : _lock, second_lock);
+
+			if(!other._readers) {
+				TaskManager::current_process()->kill(SIGPIPE);
+				return -EPIPE;
+			}
+
+			size_t to_move = min(count, min(_size, PIPE_SIZE - other._size));
+			if(to_move) {
+				auto res = other.ensure_buffer();
+				if(res.is_error())
+					return res.code();
+
+				//Copy straight from one ring to the other, a contiguous piece of each at a time
+				size_t nmoved = 0;
+				while(nmoved < to_move) {
+					size_t read_pos = (_start + nmoved) % PIPE_SIZE;
+					size_t write_pos = (other._start + other._size) % PIPE_SIZE;
+					size_t chunk = min(to_move - nmoved, min(PIPE_SIZE - read_pos, PIPE_SIZE - write_pos));
+					memcpy(other._buffer + write_pos, _buffer + read_pos, chunk);
+					other._size += chunk;
+					nmoved += chunk;
+				}
+				_start = (_start + to_move) % PIPE_SIZE;
+				_size -= to_move;
+				_write_blocker.set_ready(true);
+				other._read_blocker.set_ready(true);
+				return to_move;
+			}
+
+			if(!_size && !_writers)
+				return 0;
+			if(nonblock)
+				return -EAGAIN;
+			blocker = _size ? &other._write_blocker : &_read_blocker;
+			blocker->set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(*blocker);
+		if(blocker->was_interrupted())
+			return -EINTR;
+	}
+}
+
+ssize_t Pipe::splice_to_file(FileDescriptor& out, off_t* offset, size_t count, bool nonblock) {
+	if(!count)
+		return 0;
+
+	while(true) {
+		{
+			//The lock is held while writing so that nobody else can take out what we're in the middle of writing
+			LOCK(_lock);
+			if(_size) {
+				//The data may wrap around the end of the buffer, so write it in up to two pieces
+				size_t to_move = min(count, _size);
+				size_t nmoved = 0;
+				while(nmoved < to_move) {
+					size_t piece = min(to_move - nmoved, PIPE_SIZE - _start);
+					auto chunk = KernelPointer<uint8_t>(_buffer + _start);
+					ssize_t nwritten = offset ? out.pwrite(*offset, chunk, piece) : out.write(chunk, piece);
+					if(nwritten <= 0) {
+						if(!nmoved)
+							return nwritten;
+						break;
+					}
+					_start = (_start + nwritten) % PIPE_SIZE;
+					_size -= nwritten;
+					nmoved += nwritten;
+					if(offset)
+						*offset += nwritten;
+					if((size_t) nwritten < piece)
+						break;
+				}
+				_write_blocker.set_ready(true);
+				return nmoved;
+			}
+
+			if(!_writers)
+				return 0;
+			if(nonblock)
+				return -EAGAIN;
+			_read_blocker.set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(_read_blocker);
+		if(_read_blocker.was_interrupted())
+			return -EINTR;
+	}
+}
+
+ssize_t Pipe::splice_from_file(FileDescriptor& in, off_t* offset, size_t count, bool nonblock) {
+	if(!count)
+		return 0;
+
+	while(true) {
+		{
+			//The lock is held while reading so that nobody else can write into the space we're reading into
+			LOCK(_lock);
+			if(!_readers) {
+				TaskManager::current_process()->kill(SIGPIPE);
+				return -EPIPE;
+			}
+
+			if(_size < PIPE_SIZE) {
+				auto res = ensure_buffer();
+				if(res.is_error())
+					return res.code();
+
+				//Only read as much as there's contiguous room for, so nothing read ever has to be put back
+				size_t end = (_start + _size) % PIPE_SIZE;
+				size_t to_read = min(count, min(PIPE_SIZE - _size, PIPE_SIZE - end));
+				auto chunk = KernelPointer<uint8_t>(_buffer + end);
+				ssize_t nread = offset ? in.pread(*offset, chunk, to_read) : in.read(chunk, to_read);
+				if(nread <= 0)
+					return nread;
+				_size += nread;
+				if(offset)
+					*offset += nread;
+				_read_blocker.set_ready(true);
+				return nread;
+			}
+
+			if(nonblock)
+				return -EAGAIN;
+			_write_blocker.set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(_write_blocker);
+		if(_write_blocker.was_interrupted())
+			return -EINTR;
 	}
 }
 
 ssize_t Pipe::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	if(!_writers && _queue.empty()) return 0;
-	if(!_blocker.is_ready())
-		TaskManager::current_thread()->block(_blocker);
-	if(_blocker.was_interrupted())
-		return -EINTR;
-	LOCK(_lock);
-	if(count > _queue.size())
-		count = _queue.size();
-	for(size_t i = 0; i < count; i++)
-		buffer.set(i, _queue.pop_front());
-	if(_queue.empty() && _writers)
-		_blocker.set_ready(false);
-	return count;
+	if(!count)
+		return 0;
+
+	while(true) {
+		{
+			LOCK(_lock);
+			if(_size) {
+				count = min(count, _size);
+				take(buffer, count);
+				_write_blocker.set_ready(true);
+				return count;
+			}
+
+			if(!_writers)
+				return 0;
+			if(fd.nonblock())
+				return -EAGAIN;
+			_read_blocker.set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(_read_blocker);
+		if(_read_blocker.was_interrupted())
+			return -EINTR;
+	}
 }
 
 ssize_t Pipe::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	//TODO: Block writes bigger than available space
-	if(_readers == 0) {
+	//Writes that fit in PIPE_BUF have to go in all at once, but bigger ones can go in as space frees up
+	size_t min_write = count <= PIPE_BUF ? count : 1;
+	size_t nwritten = 0;
+
+	while(nwritten < count) {
+		{
+			LOCK(_lock);
+			if(!_readers)
+				break;
+
+			size_t space = PIPE_SIZE - _size;
+			if(space >= min_write) {
+				auto res = ensure_buffer();
+				if(res.is_error())
+					return nwritten ? (ssize_t) nwritten : res.code();
+
+				size_t to_write = min(space, count - nwritten);
+				put(SafePointer<uint8_t>(buffer.raw() + nwritten, buffer.is_user()), to_write);
+				nwritten += to_write;
+				_read_blocker.set_ready(true);
+				continue;
+			}
+
+			if(fd.nonblock())
+				return nwritten ? (ssize_t) nwritten : -EAGAIN;
+			_write_blocker.set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(_write_blocker);
+		if(_write_blocker.was_interrupted())
+			return nwritten ? (ssize_t) nwritten : -EINTR;
+	}
+
+	if(nwritten < count) {
 		TaskManager::current_process()->kill(SIGPIPE);
-		return -EPIPE;
+		return nwritten ? (ssize_t) nwritten : -EPIPE;
 	}
 
-	LOCK(_lock);
+	return nwritten;
+}
 
-	size_t nwrote = 0;
-	bool flag = true;
-	while(nwrote < count && flag) {
-		flag = _queue.push_back(buffer.get(nwrote));
-		nwrote++;
-	}
+Result Pipe::ensure_buffer() {
+	if(_buffer)
+		return Result(SUCCESS);
+	auto object = AnonymousVMObject::alloc(PIPE_SIZE, "pipe");
+	if(object.is_error())
+		return Result(-ENOMEM);
+	auto region = MM.kernel_space()->map_object(object.value(), VMProt::RW);
+	if(region.is_error())
+		return Result(-ENOMEM);
+	_region = region.value();
+	_buffer = (uint8_t*) _region->start();
+	return Result(SUCCESS);
+}
 
-	if(nwrote)
-		_blocker.set_ready(true);
+void Pipe::take(SafePointer<uint8_t> buffer, size_t count) {
+	size_t first = min(count, PIPE_SIZE - _start);
+	buffer.write(_buffer + _start, 0, first);
+	if(first < count)
+		buffer.write(_buffer, first, count - first);
+	_start = (_start + count) % PIPE_SIZE;
+	_size -= count;
+}
 
-	return nwrote;
+void Pipe::put(SafePointer<uint8_t> buffer, size_t count) {
+	size_t end = (_start + _size) % PIPE_SIZE;
+	size_t first = min(count, PIPE_SIZE - end);
+	buffer.read(_buffer + end, 0, first);
+	if(first < count)
+		buffer.read(_buffer, first, count - first);
+	_size += count;
 }
 
 bool Pipe::is_fifo() {
@@ -88,5 +302,9 @@ bool Pipe::is_fifo() {
 }
 
 bool Pipe::can_read(const FileDescriptor& fd) {
-	return !_queue.empty() && !fd.is_fifo_writer();
+	return (_size || !_writers) && !fd.is_fifo_writer();
+}
+
+bool Pipe::can_write(const FileDescriptor& fd) {
+	return fd.is_fifo_writer() && (PIPE_SIZE - _size >= PIPE_BUF || !_readers);
 }
@@ -21,10 +21,13 @@
 
 #include <kernel/memory/MemoryManager.h>
 #include <kernel/filesystem/File.h>
-#include <kernel/kstd/circular_queue.hpp>
 #include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
 
-#define PIPE_SIZE PAGE_SIZE
+/** How many bytes a pipe can hold before writers have to wait for them to be read. **/
+#define PIPE_SIZE (16 * PAGE_SIZE)
+/** Writes to a pipe of up to this many bytes are atomic, so they're never interleaved with other writes. **/
+#define PIPE_BUF PAGE_SIZE
 
 class Pipe: public File {
 public:
@@ -36,19 +39,54 @@ public:
 	void add_writer();
 	void remove_reader();
 	void remove_writer();
+	/**
+	 * Moves up to count bytes out of this pipe and into another one, without them passing through any other buffer.
+	 * Waits for there to be something to read and somewhere to put it unless nonblock is set.
+	 * @return The number of bytes moved, zero if there are no writers left, or a negative error code.
+	 */
+	ssize_t splice_to(Pipe& other, size_t count, bool nonblock);
+	/**
+	 * Writes up to count bytes out of this pipe to a file, straight from the pipe's buffer. Only what the file accepts
+	 * is taken out of the pipe. Waits for there to be something to read unless nonblock is set. The pipe is locked while
+	 * the file is written, so the file must be a regular file.
+	 * @param offset The offset in the file to write at, which is advanced past what was written, or null to use the
+	 *               file descriptor's own offset.
+	 * @return The number of bytes moved, zero if there are no writers left, or a negative error code.
+	 */
+	ssize_t splice_to_file(FileDescriptor& out, off_t* offset, size_t count, bool nonblock);
+	/**
+	 * Reads up to count bytes from a file straight into this pipe's buffer, reading no more than there's room for.
+	 * Waits for there to be room unless nonblock is set. The pipe is locked while the file is read, so the file must be a
+	 * regular file.
+	 * @param offset The offset in the file to read from, which is advanced past what was read, or null to use the
+	 *               file descriptor's own offset.
+	 * @return The number of bytes moved, zero at the end of the file, or a negative error code.
+	 */
+	ssize_t splice_from_file(FileDescriptor& in, off_t* offset, size_t count, bool nonblock);
 
 	//File
 	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	bool is_fifo() override;
 	bool can_read(const FileDescriptor& fd) override;
+	bool can_write(const FileDescriptor& fd) override;
 
 private:
-	kstd::circular_queue<uint8_t> _queue;
+	/** Allocates the buffer if it hasn't been yet. Pipes don't take up any memory for it until they're written to. **/
+	Result ensure_buffer();
+	/** Copies count bytes out of the front of the buffer, in at most two pieces since it may wrap around. **/
+	void take(SafePointer<uint8_t> buffer, size_t count);
+	/** Copies count bytes onto the back of the buffer, in at most two pieces since it may wrap around. **/
+	void put(SafePointer<uint8_t> buffer, size_t count);
+
+	kstd::Arc<VMRegion> _region;
+	uint8_t* _buffer = nullptr;
+	size_t _start = 0; ///< Where the oldest unread byte is in the buffer.
+	size_t _size = 0; ///< How many unread bytes there are.
 	size_t _readers = 0;
 	size_t _writers = 0;
-	BooleanBlocker _blocker;
+	BooleanBlocker _read_blocker; ///< Set when there's something to read, or nothing left to write it.
+	BooleanBlocker _write_blocker; ///< Set when there's space to write, or nothing left to read it.
 	SpinLock _lock;
 };
 
-
@@ -64,67 +64,96 @@ ResultRet<kstd::Arc<LinkedInode>> VFS::resolve_path(kstd::string path, const kst
 	if(path == "/") return _root_ref;
 
 	auto current_inode = path[0] == '/' ? _root_ref : _base;
-	kstd::string part;
-	if(path[0] == '/')
-		path = path.substr(1, path.length() - 1);
+	size_t path_length = path.length();
+	size_t part_start = path[0] == '/' ? 1 : 0;
 
-	while(path[0] != '\0') {
+	while(part_start < path_length) {
 		auto parent = current_inode;
 		if(!parent->inode()->metadata().is_directory()) return Result(-ENOTDIR);
 		if(!parent->inode()->metadata().can_execute(user)) return Result(-EACCES);
 
-		size_t slash_index = path.find('/');
-		if(slash_index != -1) {
-			part = path.substr(0, slash_index);
-			path = path.substr(slash_index + 1, path.length() - slash_index - 1);
-		} else {
-			part = path;
-			path = "";
-		}
+		//Split off the next part of the path
+		size_t part_end = part_start;
+		while(part_end < path_length && path[part_end] != '/')
+			part_end++;
+		auto part = path.substr(part_start, part_end - part_start);
+		bool is_last = part_end + 1 >= path_length;
+		part_start = part_end + 1;
 
 		if(part == "..") {
 			if(current_inode->parent()) {
 				current_inode = kstd::Arc<LinkedInode>(current_inode->parent());
 			}
 			continue;
-		} else if(part == ".") {
+		} else if(part == "." || !part.length()) {
 			continue;
 		}
 
-		auto child_inode_or_err = current_inode->inode()->find(part);
-
-		if(!child_inode_or_err.is_error()) {
-			if(child_inode_or_err.value()->metadata().is_symlink()) {
-				if(!path.length()) {
-					if (options & O_NOFOLLOW)
-						return Result(-ELOOP);
-					if (options & O_INTERNAL_RETLINK) {
-						current_inode = kstd::Arc<LinkedInode>(new LinkedInode(child_inode_or_err.value(), part, parent));
-						break;
-					}
-				}
-
-				auto link_or_err = child_inode_or_err.value()->resolve_link(current_inode, user, parent_storage, options, recursion_level + 1);
-				if(!path.length()) return link_or_err;
-				if(link_or_err.is_error()) return link_or_err;
-				return resolve_path(path, link_or_err.value(), user, parent_storage, options, recursion_level + 1);
+		//Look up the child, only going to the filesystem if it isn't in the dentry cache
+		auto directory = parent->inode();
+		bool cacheable = directory->fs.can_cache_dentries();
+		bool cached = false;
+		size_t generation = 0;
+		kstd::Arc<Inode> child_inode;
+		kstd::Arc<LinkedInode> child_link;
+		if(cacheable) {
+			//Sample the generation before looking anything up, so we don't cache it if the directory changes meanwhile
+			generation = _dentry_cache.generation(*directory);
+			cached = _dentry_cache.lookup(parent, part, child_inode, child_link);
+		}
+		if(!cached) {
+			auto child_inode_or_err = directory->find(part);
+			if(child_inode_or_err.is_error()) {
+				if(cacheable && child_inode_or_err.code() == -ENOENT)
+					_dentry_cache.insert(parent, part, kstd::Arc<Inode>(nullptr), kstd::Arc<LinkedInode>(nullptr), generation);
+				if(parent_storage && is_last)
+					*parent_storage = current_inode;
+				return child_inode_or_err.result();
 			}
+			child_inode = child_inode_or_err.value();
+		} else if(!child_inode) {
+			if(parent_storage && is_last)
+				*parent_storage = current_inode;
+			return Result(-ENOENT);
+		}
 
-			current_inode = kstd::Arc<LinkedInode>(new LinkedInode(child_inode_or_err.value(), part, parent));
+		if(child_inode->metadata().is_symlink()) {
+			if(cacheable && !cached)
+				_dentry_cache.insert(parent, part, child_inode, kstd::Arc<LinkedInode>(nullptr), generation);
 
-			//Check if there's a mount at this inode and follow it if there is
-			auto mount_or_err = get_mount(current_inode);
-			if(!mount_or_err.is_error()) {
-				auto guest_fs = mount_or_err.value().guest_fs();
-				auto guest_inode = TRY(guest_fs->get_inode(guest_fs->root_inode_id()));
-				current_inode = kstd::make_shared<LinkedInode>(guest_inode, part, parent);
-			}
-		} else {
-			if(parent_storage && path.find('/') == -1) {
-				*parent_storage = current_inode;
+			if(is_last) {
+				if (options & O_NOFOLLOW)
+					return Result(-ELOOP);
+				if (options & O_INTERNAL_RETLINK) {
+					current_inode = kstd::Arc<LinkedInode>(new LinkedInode(child_inode, part, parent));
+					break;
+				}
 			}
-			return child_inode_or_err.result();
+
+			auto link_or_err = child_inode->resolve_link(current_inode, user, parent_storage, options, recursion_level + 1);
+			if(is_last) return link_or_err;
+			if(link_or_err.is_error()) return link_or_err;
+			return resolve_path(path.substr(part_start, path_length - part_start), link_or_err.value(), user, parent_storage, options, recursion_level + 1);
 		}
+
+		//If we've been down this path from the same parent before, reuse the LinkedInode from last time
+		if(child_link) {
+			current_inode = child_link;
+			continue;
+		}
+
+		current_inode = kstd::Arc<LinkedInode>(new LinkedInode(child_inode, part, parent));
+
+		//Check if there's a mount at this inode and follow it if there is
+		auto mount_or_err = get_mount(current_inode);
+		if(!mount_or_err.is_error()) {
+			auto guest_fs = mount_or_err.value().guest_fs();
+			auto guest_inode = TRY(guest_fs->get_inode(guest_fs->root_inode_id()));
+			current_inode = kstd::make_shared<LinkedInode>(guest_inode, part, parent);
+		}
+
+		if(cacheable)
+			_dentry_cache.insert(parent, part, child_inode, current_inode, generation);
 	}
 
 	if(parent_storage) *parent_storage = current_inode->parent();
@@ -199,6 +228,7 @@ ResultRet<kstd::Arc<FileDescriptor>> VFS::create(const kstd::string& path, int o
 
 	//Create the entry
 	auto child_or_err = parent->inode()->create_entry(path_base(path), mode, user.euid, user.egid);
+	_dentry_cache.invalidate(*parent->inode(), path_base(path));
 	if(child_or_err.is_error()) return child_or_err.result();
 
 	//Return a file descriptor to the new file
@@ -221,7 +251,9 @@ Result VFS::unlink(const kstd::string &path, const User& user, const kstd::Arc<L
 
 	//Unlink
 	if(resolv.value()->inode()->metadata().is_directory()) return Result(-EISDIR);
-	return parent->inode()->remove_entry(path_base(path));
+	auto res = parent->inode()->remove_entry(path_base(path));
+	_dentry_cache.invalidate(*parent->inode(), path_base(path));
+	return res;
 }
 
 Result VFS::link(const kstd::string& file, const kstd::string& link_name, const User& user, const kstd::Arc<LinkedInode>& base) {
@@ -245,7 +277,9 @@ Result VFS::link(const kstd::string& file, const kstd::string& link_name, const
 	if(old_file->inode()->fs.fsid() != new_file_parent->inode()->fs.fsid()) return Result(-EXDEV);
 
 	//Add the entry and return the result
-	return new_file_parent->inode()->add_entry(path_base(link_name), *old_file->inode());
+	auto res = new_file_parent->inode()->add_entry(path_base(link_name), *old_file->inode());
+	_dentry_cache.invalidate(*new_file_parent->inode(), path_base(link_name));
+	return res;
 }
 
 Result VFS::symlink(const kstd::string& file, const kstd::string& link_name, const User& user, const kstd::Arc<LinkedInode>& base) {
@@ -266,6 +300,7 @@ Result VFS::symlink(const kstd::string& file, const kstd::string& link_name, con
 
 	//Create the symlink file
 	auto symlink_res = new_file_parent->inode()->create_entry(path_base(link_name), MODE_SYMLINK | 0777u, user.euid, user.egid);
+	_dentry_cache.invalidate(*new_file_parent->inode(), path_base(link_name));
 	if(symlink_res.is_error()) return symlink_res.result();
 
 	//Write the symlink data
@@ -311,7 +346,12 @@ Result VFS::rmdir(kstd::string path, const User& user, const kstd::Arc<LinkedIno
 	if(!resolv.value()->inode()->metadata().is_directory()) return Result(-ENOTDIR);
 	if(!resolv.value()->inode()->metadata().can_write(user)) return Result(-EACCES);
 
-	return parent->inode()->remove_entry(path_base(path));
+	//The directory's inode could be reused once it's removed, so forget about everything that was in it too
+	auto res = parent->inode()->remove_entry(path_base(path));
+	_dentry_cache.invalidate(*parent->inode(), path_base(path));
+	if(!res.is_error())
+		_dentry_cache.invalidate_directory(*resolv.value()->inode());
+	return res;
 }
 
 Result VFS::mkdir(kstd::string path, mode_t mode, const User& user, const kstd::Arc<LinkedInode> &base) {
@@ -332,6 +372,7 @@ Result VFS::mkdir(kstd::string path, mode_t mode, const User& user, const kstd::
 	//Make the directory
 	mode |= (unsigned) MODE_DIRECTORY;
 	auto res = parent->inode()->create_entry(path_base(path), mode, user.euid, user.egid);
+	_dentry_cache.invalidate(*parent->inode(), path_base(path));
 	if(res.is_error()) return res.result();
 
 	return Result(SUCCESS);
@@ -384,6 +425,10 @@ kstd::Arc<LinkedInode> VFS::root_ref() {
 	return _root_ref;
 }
 
+DentryCache& VFS::dentry_cache() {
+	return _dentry_cache;
+}
+
 kstd::string VFS::path_base(const kstd::string& path) {
 	size_t slash_index = path.find_last_of('/');
 	if(slash_index == -1) return path;
@@ -409,6 +454,9 @@ Result VFS::mount(Filesystem* fs, const kstd::Arc<LinkedInode>& mountpoint) {
 	}
 
 	mounts.push_back(Mount(fs, mountpoint));
+
+	//Cached lookups of the mountpoint lead to what used to be there, so start over
+	_dentry_cache.clear();
 	return Result(SUCCESS);
 }
 
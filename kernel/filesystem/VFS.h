@@ -28,6 +28,7 @@
 #include "FileDescriptor.h"
 #include "LinkedInode.h"
 #include "Inode.h"
+#include "DentryCache.h"
 
 #define O_INTERNAL_RETLINK 0x1000000
 #define VFS_RECURSION_LIMIT 5
@@ -69,6 +70,7 @@ public:
 	bool mount_root(Filesystem* fs);
 	kstd::Arc<LinkedInode> root_ref();
 	ResultRet<Mount> get_mount(const kstd::Arc<LinkedInode>& inode);
+	DentryCache& dentry_cache();
 
 	static kstd::string path_base(const kstd::string& path);
 	static kstd::string path_minus_base(const kstd::string& path);
@@ -77,6 +79,7 @@ private:
 	kstd::Arc<Inode> _root_inode;
 	kstd::Arc<LinkedInode> _root_ref;
 	kstd::vector<Mount> mounts;
+	DentryCache _dentry_cache;
 	static VFS* instance;
 };
 
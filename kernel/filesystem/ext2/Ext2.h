@@ -41,8 +41,26 @@
 #define EXT2_IMMUTABLE 0x10
 #define EXT2_APPEND_ONLY 0x20
 #define EXT2_DUMP_EXCLUDE 0x40
+#define EXT2_INDEX 0x1000 //Directory is indexed with an htree
 #define EXT2_JOURNAL_FILE 0x40000
 
+//optional features
+#define EXT2_FEATURE_COMPAT_DIR_INDEX 0x20
+
+//superblock flags
+#define EXT2_FLAGS_UNSIGNED_HASH 0x2
+
+//htree directory index hash versions
+#define EXT2_HASH_LEGACY 0
+#define EXT2_HASH_HALF_MD4 1
+#define EXT2_HASH_TEA 2
+#define EXT2_HASH_LEGACY_UNSIGNED 3
+#define EXT2_HASH_HALF_MD4_UNSIGNED 4
+#define EXT2_HASH_TEA_UNSIGNED 5
+
+//The longest name a directory entry can have
+#define EXT2_NAME_MAXLEN 255
+
 #define EXT2_FT_UNKNOWN	0
 #define EXT2_FT_REG_FILE 1
 #define EXT2_FT_DIR	2
@@ -97,7 +115,11 @@ typedef struct __attribute__((packed)) ext2_superblock {
 	uint32_t journal_inode;
 	uint32_t journal_device;
 	uint32_t orphan_inode_head;
-	uint8_t extra[276];
+	uint32_t hash_seed[4];
+	uint8_t default_hash_version;
+	uint8_t unused2[99];
+	uint32_t flags;
+	uint8_t extra[156];
 } ext2_superblock;
 
 typedef struct __attribute__((packed)) ext2_block_group_descriptor {
@@ -116,3 +138,27 @@ typedef struct __attribute__((packed)) ext2_directory {
 	uint8_t name_length;
 	uint8_t type;
 } ext2_directory;
+
+//htree index entries only use the low 28 bits of the block number
+#define EXT2_DX_BLOCK_MASK 0x0FFFFFFF
+//The most indirect levels an htree can have below its root
+#define EXT2_DX_MAX_INDIRECT_LEVELS 2
+
+typedef struct __attribute__((packed)) ext2_dx_root_info {
+	uint32_t reserved_zero;
+	uint8_t hash_version;
+	uint8_t info_length;
+	uint8_t indirect_levels;
+	uint8_t unused_flags;
+} ext2_dx_root_info;
+
+//The first entry of each htree index node has its hash replaced with the node's limit and count
+typedef struct __attribute__((packed)) ext2_dx_countlimit {
+	uint16_t limit;
+	uint16_t count;
+} ext2_dx_countlimit;
+
+typedef struct __attribute__((packed)) ext2_dx_entry {
+	uint32_t hash;
+	uint32_t block;
+} ext2_dx_entry;
@@ -20,6 +20,7 @@
 #include "Ext2BlockGroup.h"
 #include "Ext2.h"
 #include "Ext2Filesystem.h"
+#include <kernel/kstd/KLog.h>
 
 Ext2BlockGroup::Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num): fs(fs), num(num) {
 	ext2_block_group_descriptor buf;
@@ -32,8 +33,15 @@ Ext2BlockGroup::Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num): fs(fs), num(nu
 	num_directories = buf.num_directories;
 }
 
+Ext2BlockGroup::~Ext2BlockGroup() {
+	flush();
+	delete[] _block_bitmap;
+}
+
 void Ext2BlockGroup::write() {
+	//Read the descriptor first so that the fields we don't know about are left alone
 	ext2_block_group_descriptor buf;
+	fs->read_block_group_raw(num, &buf);
 	buf.block_usage_bitmap = block_bitmap_block;
 	buf.inode_usage_bitmap = inode_bitmap_block;
 	buf.inode_table = inode_table_block;
@@ -41,8 +49,94 @@ void Ext2BlockGroup::write() {
 	buf.free_inodes = free_inodes;
 	buf.num_directories = num_directories;
 	fs->write_block_group_raw(num, &buf);
+	dirty = false;
 }
 
 uint32_t Ext2BlockGroup::first_block() {
 	return num * fs->superblock.blocks_per_group + (fs->block_size() == 1024 ? 1 : 0);
 }
+
+uint32_t Ext2BlockGroup::num_blocks() {
+	//The last group may be cut short
+	return min(fs->superblock.blocks_per_group, fs->superblock.total_blocks - first_block());
+}
+
+Result Ext2BlockGroup::load_block_bitmap() {
+	if(_block_bitmap)
+		return Result(SUCCESS);
+	auto* bitmap = new uint32_t[fs->block_size() / sizeof(uint32_t)];
+	auto res = fs->read_block(block_bitmap_block, (uint8_t*) bitmap);
+	if(res.is_error()) {
+		KLog::err("ext2", "Error %d reading block bitmap for group %d", res.code(), num);
+		delete[] bitmap;
+		return res;
+	}
+	_block_bitmap = bitmap;
+	return Result(SUCCESS);
+}
+
+bool Ext2BlockGroup::find_free_blocks(uint32_t start, uint32_t max_length, uint32_t& run_start, uint32_t& run_length) {
+	uint32_t total = num_blocks();
+
+	//Find the first free block, skipping over whole words of used blocks at a time
+	uint32_t index = start;
+	while(index < total) {
+		uint32_t free = ~_block_bitmap[index / 32] & (~0u << (index % 32));
+		if(free) {
+			index = (index & ~31u) + __builtin_ctz(free);
+			break;
+		}
+		index = (index & ~31u) + 32;
+	}
+	if(index >= total)
+		return false;
+
+	//Then find where the run of free blocks ends, the same way
+	uint32_t end = index;
+	while(end < total && end - index < max_length) {
+		uint32_t used = _block_bitmap[end / 32] & (~0u << (end % 32));
+		if(used) {
+			end = (end & ~31u) + __builtin_ctz(used);
+			break;
+		}
+		end = (end & ~31u) + 32;
+	}
+
+	run_start = index;
+	run_length = min(min(end, total) - index, max_length);
+	return true;
+}
+
+uint32_t Ext2BlockGroup::set_blocks_used(uint32_t start, uint32_t count, bool used) {
+	auto* bitmap = (uint8_t*) _block_bitmap;
+	uint32_t changed = 0;
+	for(uint32_t i = start; i < start + count; i++) {
+		if(Ext2Filesystem::get_bitmap_bit(bitmap, i) == used) {
+			KLog::warn("ext2", "Block %d in group %d was already %s!", i, num, used ? "used" : "free");
+			continue;
+		}
+		Ext2Filesystem::set_bitmap_bit(bitmap, i, used);
+		changed++;
+		if(used)
+			free_blocks--;
+		else
+			free_blocks++;
+	}
+	_block_bitmap_dirty = true;
+	dirty = true;
+	return changed;
+}
+
+Result Ext2BlockGroup::flush() {
+	if(_block_bitmap_dirty) {
+		auto res = fs->write_block(block_bitmap_block, (uint8_t*) _block_bitmap);
+		if(res.is_error()) {
+			KLog::err("ext2", "Error %d writing block bitmap for group %d", res.code(), num);
+			return res;
+		}
+		_block_bitmap_dirty = false;
+	}
+	if(dirty)
+		write();
+	return Result(SUCCESS);
+}
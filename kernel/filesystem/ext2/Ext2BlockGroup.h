@@ -20,13 +20,32 @@
 #pragma once
 
 #include <kernel/kstd/unix_types.h>
+#include <kernel/Result.hpp>
 
 class Ext2Filesystem;
 class Ext2BlockGroup {
 public:
 	Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num);
+	~Ext2BlockGroup();
 	void write();
 	uint32_t first_block();
+	uint32_t num_blocks();
+
+	/** Reads the block bitmap into memory if it isn't already. It stays cached until the group is destroyed. **/
+	Result load_block_bitmap();
+	/**
+	 * Finds the first run of free blocks starting at or after the given index in the group. Must have the bitmap loaded.
+	 * @param max_length The longest the run can be.
+	 * @return Whether there were any free blocks.
+	 */
+	bool find_free_blocks(uint32_t start, uint32_t max_length, uint32_t& run_start, uint32_t& run_length);
+	/**
+	 * Marks blocks in the group as used or free in the bitmap and updates the free block count.
+	 * @return The number of blocks that actually changed state.
+	 */
+	uint32_t set_blocks_used(uint32_t start, uint32_t count, bool used);
+	/** Writes the block bitmap and group descriptor to disk if they were changed. **/
+	Result flush();
 
 	Ext2Filesystem* fs;
 	uint32_t num;
@@ -36,6 +55,9 @@ public:
 	uint16_t free_blocks;
 	uint16_t free_inodes;
 	uint16_t num_directories;
-};
-
+	bool dirty = false; ///< Whether the descriptor needs to be written by flush().
 
+private:
+	uint32_t* _block_bitmap = nullptr;
+	bool _block_bitmap_dirty = false;
+};
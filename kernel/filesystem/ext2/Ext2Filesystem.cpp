@@ -76,11 +76,13 @@ Inode* Ext2Filesystem::get_inode_rawptr(ino_t id) {
 ResultRet<kstd::Arc<Ext2Inode>> Ext2Filesystem::allocate_inode(mode_t mode, uid_t uid, gid_t gid, size_t size, ino_t parent) {
 	ext2lock.acquire();
 
-	//Find a block group to house the inode
+	//Find a block group to house the inode, preferring the parent's so that the inode and its blocks end up nearby
 	uint32_t bg = -1;
+	uint32_t parent_bg = parent ? (parent - 1) / superblock.inodes_per_group : 0;
 	for(size_t i = 0; i < num_block_groups; i++) {
-		if(get_block_group(i)->free_inodes > 0) {
-			bg = i;
+		uint32_t group_index = (parent_bg + i) % num_block_groups;
+		if(get_block_group(group_index)->free_inodes > 0) {
+			bg = group_index;
 			break;
 		}
 	}
@@ -132,7 +134,7 @@ ResultRet<kstd::Arc<Ext2Inode>> Ext2Filesystem::allocate_inode(mode_t mode, uid_
 	uint32_t num_blocks = (size + block_size() - 1) / block_size();
 	kstd::vector<uint32_t> blocks(0);
 	if(num_blocks) {
-		auto blocks_or_err = allocate_blocks(num_blocks);
+		auto blocks_or_err = allocate_blocks(num_blocks, true, get_block_group(bg)->first_block());
 		if (blocks_or_err.is_error()) return blocks_or_err.result();
 		blocks = blocks_or_err.value();
 	}
@@ -209,6 +211,10 @@ char *Ext2Filesystem::name() {
 	return "EXT2";
 }
 
+bool Ext2Filesystem::can_cache_dentries() {
+	return true;
+}
+
 ino_t Ext2Filesystem::root_inode_id() {
 	return 2;
 }
@@ -236,108 +242,85 @@ Result Ext2Filesystem::write_block_group_raw(uint32_t block_group, const ext2_bl
 	return write_successful;
 }
 
-ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out) {
-	if(group->free_blocks < num_blocks) return Result(-ENOSPC);
-	if(num_blocks == 0) return kstd::vector<uint32_t>(0);
-
+ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_blocks, bool zero_out, uint32_t goal) {
 	LOCK(ext2lock);
-	uint8_t block_buf[block_size()];
-
-	Result res = read_block(group->block_bitmap_block, block_buf);
-	if(res.is_error()) {
-		KLog::err("ext2", "Error %d reading block bitmap for group %d", res.code(), group->num);
-		return res;
+	if(num_blocks == 0) {
+		KLog::warn("ext2", "Tried to allocate zero ext2 blocks!");
+		return Result(-EINVAL);
 	}
+	if(superblock.free_blocks < num_blocks)
+		return Result(-ENOSPC);
 
+	//Start looking at the goal block, and then move on to the groups after it
+	uint32_t goal_group = 0, goal_index = 0;
+	if(goal >= superblock.superblock_block && goal < superblock.total_blocks) {
+		goal_group = (goal - superblock.superblock_block) / superblock.blocks_per_group;
+		goal_index = (goal - superblock.superblock_block) % superblock.blocks_per_group;
+	}
 
-	uint32_t num_allocated = 0;
 	kstd::vector<uint32_t> ret;
 	ret.reserve(num_blocks);
-
-	for(size_t bi = 0; bi < superblock.blocks_per_group; bi++) {
-		if(!get_bitmap_bit(block_buf, bi)) {
-			set_bitmap_bit(block_buf, bi, true);
-			ret.push_back(bi + group->first_block());
-			if(zero_out) zero_block(bi + group->first_block());
-			group->free_blocks--;
-			superblock.free_blocks--;
-			if(++num_allocated == num_blocks) break;
-		}
+	for(uint32_t i = 0; i <= num_block_groups && ret.size() < num_blocks; i++) {
+		//The goal's group is looked at again last, in case there's room before the goal
+		Ext2BlockGroup* group = get_block_group((goal_group + i) % num_block_groups);
+		if(!group || !group->free_blocks)
+			continue;
+		if(group->load_block_bitmap().is_error())
+			continue;
+		allocate_blocks_in_group(group, i ? 0 : goal_index, num_blocks - ret.size(), ret);
 	}
 
-	if(num_allocated != num_blocks) {
-		KLog::warn("ext2", "Free block count in block group %d was incorrect!", group->num);
-		group->free_blocks = 0;
+	if(ret.size() < num_blocks) {
+		KLog::warn("ext2", "Free block count was incorrect, couldn't allocate %d blocks!", num_blocks);
+		for(size_t i = 0; i < ret.size(); i++)
+			release_block(ret[i]);
+		write_metadata();
+		return Result(-ENOSPC);
 	}
 
-	write_superblock();
-	group->write();
-	res = write_block(group->block_bitmap_block, block_buf);
-	if(res.is_error()) {
-		KLog::err("ext2", "Error writing block bitmap for block group %d!", group->num);
-		return res;
+	if(zero_out) {
+		for(size_t i = 0; i < ret.size(); i++)
+			zero_block(ret[i]);
 	}
 
+	auto res = write_metadata();
+	if(res.is_error())
+		return res;
 	return kstd::move(ret);
 }
 
-ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_blocks, bool zero_out) {
-	LOCK(ext2lock);
-	if(num_blocks == 0) {
-		KLog::warn("ext2", "Tried to allocate zero ext2 blocks!");
-		return Result(-EINVAL);
-	}
-
-	//First, find a block group that can fit all the blocks, or at least the most spacious block group
-	Ext2BlockGroup* target_bg = nullptr;
-	Ext2BlockGroup* most_spacious_bg = nullptr;
-
-	for(uint32_t bgi = 0; bgi < num_block_groups; bgi++) {
-		Ext2BlockGroup *bg = get_block_group(bgi);
-		if (!bg) {
-			KLog::err("ext2", "Error getting block group %d!", bgi);
-			break;
-		}
-		if (bg->free_blocks >= num_blocks) {
-			target_bg = bg;
-			break;
+void Ext2Filesystem::allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t start, uint32_t num_blocks, kstd::vector<uint32_t>& blocks) {
+	uint32_t run_start, run_length;
+	uint32_t first_block = group->first_block();
+	auto take_run = [&] () {
+		superblock.free_blocks -= group->set_blocks_used(run_start, run_length, true);
+		for(uint32_t i = 0; i < run_length; i++)
+			blocks.push_back(first_block + run_start + i);
+		num_blocks -= run_length;
+	};
+
+	//If the goal is free, keep going from it so that the blocks end up right after what came before
+	if(!start || !group->find_free_blocks(start, num_blocks, run_start, run_length) || run_start != start) {
+		//Otherwise, look for a run that fits all of the blocks
+		uint32_t index = start;
+		while(group->find_free_blocks(index, num_blocks, run_start, run_length)) {
+			if(run_length == num_blocks) {
+				take_run();
+				return;
+			}
+			index = run_start + run_length;
 		}
-		if (!most_spacious_bg || bg->free_blocks > most_spacious_bg->free_blocks) most_spacious_bg = bg;
 	}
 
-	if(target_bg) {
-		//We found a block group that will house all of the blocks we need to allocate
-		return kstd::move(allocate_blocks_in_group(target_bg, num_blocks, zero_out));
-	} else {
-		//If we couldn't find one bg to fit all the blocks, allocate the blocks in multiple groups
-		kstd::vector<uint32_t> ret;
-		ret.reserve(num_blocks);
-		while(num_blocks) {
-			//Find the most spacious bg
-			most_spacious_bg = nullptr;
-			for(uint32_t bgi = 0; bgi < num_block_groups; bgi++) {
-				Ext2BlockGroup *bg = get_block_group(bgi);
-				if(!bg) continue; //This error would have been printed out above presumably
-				if (!most_spacious_bg || bg->free_blocks > most_spacious_bg->free_blocks) most_spacious_bg = bg;
-			}
-
-			//If the most spacious bg has no free blocks, return ENOSPC
-			if(most_spacious_bg->free_blocks == 0) return Result(-ENOSPC);
-
-			//Allocate the needed amount of blocks in that group
-			auto res = allocate_blocks_in_group(most_spacious_bg, min(most_spacious_bg->free_blocks, num_blocks), zero_out);
-			if(res.is_error()) return res.result();
-
-			//Push the blocks allocated into the return vector
-			num_blocks -= res.value().size();
-			for(size_t i = 0; i < res.value().size(); i++) ret.push_back(res.value()[i]);
-		}
-		return kstd::move(ret);
+	//Failing that, take whatever runs there are
+	while(num_blocks && group->find_free_blocks(start, num_blocks, run_start, run_length)) {
+		take_run();
+		start = run_start + run_length;
 	}
 }
 
-uint32_t Ext2Filesystem::allocate_block(bool zero_out) {
-	auto ret_or_err = allocate_blocks(1, zero_out);
+uint32_t Ext2Filesystem::allocate_block(bool zero_out, uint32_t goal) {
+	auto ret_or_err = allocate_blocks(1, zero_out, goal);
 	if(ret_or_err.is_error()) return 0;
 	if(ret_or_err.value().empty()) return 0;
 	return ret_or_err.value().at(0);
@@ -345,36 +328,49 @@ uint32_t Ext2Filesystem::allocate_block(bool zero_out) {
 
 void Ext2Filesystem::free_block(uint32_t block) {
 	LOCK(ext2lock);
+	release_block(block);
+	write_metadata();
+}
 
-	if(block == 0) {
-		KLog::warn("ext2", "Tried to free ext2 block 0!");
+void Ext2Filesystem::free_blocks(kstd::vector<uint32_t>& blocks) {
+	LOCK(ext2lock);
+	for(size_t i = 0; i < blocks.size(); i++)
+		release_block(blocks[i]);
+	write_metadata();
+}
+
+void Ext2Filesystem::release_block(uint32_t block) {
+	if(block < superblock.superblock_block || block == 0 || block >= superblock.total_blocks) {
+		KLog::warn("ext2", "Tried to free invalid ext2 block %d!", block);
 		return;
 	}
 
-	uint32_t group_index = (block - 1) / superblock.blocks_per_group;
+	uint32_t group_index = (block - superblock.superblock_block) / superblock.blocks_per_group;
 	Ext2BlockGroup* bg = get_block_group(group_index);
 	if(!bg) {
 		KLog::err("ext2", "Error getting block group %d!", group_index);
 		return;
 	}
+	if(bg->load_block_bitmap().is_error())
+		return;
 
-	//Update blockgroup
-	uint8_t block_buf[block_size()];
-	read_block(bg->block_bitmap_block, block_buf);
-	set_bitmap_bit(block_buf, block - bg->first_block(), false);
-	write_block(bg->block_bitmap_block, block_buf);
-	bg->free_blocks++;
-
-	//Update superblock
-	superblock.free_blocks++;
+	superblock.free_blocks += bg->set_blocks_used(block - bg->first_block(), 1, false);
 }
 
-void Ext2Filesystem::free_blocks(kstd::vector<uint32_t>& blocks) {
-	for(size_t i = 0; i < blocks.size(); i++) free_block(blocks[i]);
+Result Ext2Filesystem::write_metadata() {
+	for(uint32_t i = 0; i < num_block_groups; i++) {
+		if(block_groups[i]) {
+			auto res = block_groups[i]->flush();
+			if(res.is_error())
+				return res;
+		}
+	}
+	write_superblock();
+	return Result(SUCCESS);
 }
 
 Ext2BlockGroup *Ext2Filesystem::get_block_group(uint32_t block_group) {
-	if(!block_groups || block_group > num_block_groups) return nullptr;
+	if(!block_groups || block_group >= num_block_groups) return nullptr;
 	if(!block_groups[block_group]) {
 		block_groups[block_group] = new Ext2BlockGroup(this, block_group);
 	}
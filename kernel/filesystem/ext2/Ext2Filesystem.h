@@ -37,6 +37,7 @@ public:
 	//FileBasedFilesystem
 	ino_t root_inode_id() override;
 	char* name() override;
+	bool can_cache_dentries() override;
 	Inode * get_inode_rawptr(ino_t id) override;
 
 	//Reading/writing
@@ -46,9 +47,12 @@ public:
 	void write_superblock();
 
 	//Block stuff
-	ResultRet<kstd::vector<uint32_t>> allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out);
-	ResultRet<kstd::vector<uint32_t>> allocate_blocks(uint32_t num_blocks, bool zero_out = true);
-	uint32_t allocate_block(bool zero_out = true);
+	/**
+	 * Allocates blocks, trying to keep them contiguous and close to a goal block.
+	 * @param goal The block to try and allocate at. To keep files contiguous, this should be the block after the file's last one.
+	 */
+	ResultRet<kstd::vector<uint32_t>> allocate_blocks(uint32_t num_blocks, bool zero_out = true, uint32_t goal = 0);
+	uint32_t allocate_block(bool zero_out = true, uint32_t goal = 0);
 
 	void free_block(uint32_t block);
 	void free_blocks(kstd::vector<uint32_t>& blocks);
@@ -81,6 +85,13 @@ public:
 	size_t block_pointers_per_block;
 
 private:
+	/** Allocates up to num_blocks blocks in a group, starting at the given index, and pushes them onto blocks. **/
+	void allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t start, uint32_t num_blocks, kstd::vector<uint32_t>& blocks);
+	/** Marks a block as free without writing the metadata to disk. **/
+	void release_block(uint32_t block);
+	/** Writes the superblock and any block groups that were changed to disk. **/
+	Result write_metadata();
+
 	SpinLock ext2lock;
 
 	//Block stuff
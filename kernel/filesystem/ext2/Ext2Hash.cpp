@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "Ext2Hash.h"
+#include "Ext2.h"
+
+#define HTREE_EOF 0x7FFFFFFFu
+
+static inline uint32_t rotl(uint32_t val, unsigned shift) {
+	return (val << shift) | (val >> (32 - shift));
+}
+
+/** Reads a name character the way the hash version says to, since the original implementations used plain chars. **/
+static inline uint32_t name_char(const char* name, size_t index, bool is_unsigned) {
+	if(is_unsigned)
+		return (uint32_t) (uint8_t) name[index];
+	return (uint32_t) (int32_t) (int8_t) name[index];
+}
+
+static uint32_t legacy_hash(const char* name, size_t length, bool is_unsigned) {
+	uint32_t hash0 = 0x12A3FE2D;
+	uint32_t hash1 = 0x37ABE8F9;
+	for(size_t i = 0; i < length; i++) {
+		uint32_t hash = hash1 + (hash0 ^ (name_char(name, i, is_unsigned) * 7152373));
+		if(hash & 0x80000000)
+			hash -= 0x7FFFFFFF;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+	return hash0 << 1;
+}
+
+/** Packs up to num * 4 characters of a name into words to be fed into a hash transform, padded with the length. **/
+static void pack_name(const char* name, size_t length, uint32_t* out, int num, bool is_unsigned) {
+	uint32_t pad = (uint32_t) length | ((uint32_t) length << 8);
+	pad |= pad << 16;
+
+	uint32_t val = pad;
+	if(length > (size_t) num * 4)
+		length = num * 4;
+	for(size_t i = 0; i < length; i++) {
+		val = name_char(name, i, is_unsigned) + (val << 8);
+		if(i % 4 == 3) {
+			*out++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if(--num >= 0)
+		*out++ = val;
+	while(--num >= 0)
+		*out++ = pad;
+}
+
+static void tea_transform(uint32_t buf[4], const uint32_t in[4]) {
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0], b1 = buf[1];
+	uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+	for(int n = 0; n < 16; n++) {
+		sum += 0x9E3779B9;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	}
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+#define MD4_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD4_G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define MD4_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD4_ROUND(f, a, b, c, d, x, s) ((a) += f((b), (c), (d)) + (x), (a) = rotl((a), (s)))
+#define MD4_K2 0x5A827999u
+#define MD4_K3 0x6ED9EBA1u
+
+static void half_md4_transform(uint32_t buf[4], const uint32_t in[8]) {
+	uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	MD4_ROUND(MD4_F, a, b, c, d, in[0], 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[1], 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[2], 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[3], 19);
+	MD4_ROUND(MD4_F, a, b, c, d, in[4], 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[5], 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[6], 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[7], 19);
+
+	MD4_ROUND(MD4_G, a, b, c, d, in[1] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[3] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[5] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[7] + MD4_K2, 13);
+	MD4_ROUND(MD4_G, a, b, c, d, in[0] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[2] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[4] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[6] + MD4_K2, 13);
+
+	MD4_ROUND(MD4_H, a, b, c, d, in[3] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[7] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[2] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[6] + MD4_K3, 15);
+	MD4_ROUND(MD4_H, a, b, c, d, in[1] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[5] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[0] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[4] + MD4_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+uint32_t Ext2Hash::hash(const char* name, size_t length, uint8_t version, const uint32_t* seed) {
+	uint32_t buf[4] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476};
+	if(seed && (seed[0] || seed[1] || seed[2] || seed[3])) {
+		for(int i = 0; i < 4; i++)
+			buf[i] = seed[i];
+	}
+
+	bool is_unsigned = version >= EXT2_HASH_LEGACY_UNSIGNED;
+	uint32_t hash;
+	switch(version) {
+		case EXT2_HASH_HALF_MD4:
+		case EXT2_HASH_HALF_MD4_UNSIGNED: {
+			uint32_t in[8];
+			for(size_t offset = 0; offset < length; offset += 32) {
+				pack_name(name + offset, length - offset, in, 8, is_unsigned);
+				half_md4_transform(buf, in);
+			}
+			hash = buf[1];
+			break;
+		}
+
+		case EXT2_HASH_TEA:
+		case EXT2_HASH_TEA_UNSIGNED: {
+			uint32_t in[4];
+			for(size_t offset = 0; offset < length; offset += 16) {
+				pack_name(name + offset, length - offset, in, 4, is_unsigned);
+				tea_transform(buf, in);
+			}
+			hash = buf[0];
+			break;
+		}
+
+		default:
+			hash = legacy_hash(name, length, is_unsigned);
+			break;
+	}
+
+	hash &= ~1u;
+	if(hash == (HTREE_EOF << 1))
+		hash = (HTREE_EOF - 1) << 1;
+	return hash;
+}
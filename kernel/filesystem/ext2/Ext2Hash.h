@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/kstd/types.h>
+
+namespace Ext2Hash {
+	/**
+	 * Hashes a directory entry name the same way ext2 htree directory indexes do.
+	 * @param version The EXT2_HASH_* hash version to use.
+	 * @param seed The filesystem's hash seed, or nullptr / all zeroes to use the default one.
+	 * @return The name's hash, with the lowest bit cleared since htrees use it to mark hash collisions.
+	 */
+	uint32_t hash(const char* name, size_t length, uint8_t version, const uint32_t* seed);
+}
@@ -21,9 +21,50 @@
 #include <kernel/kstd/cstring.h>
 #include "Ext2BlockGroup.h"
 #include "Ext2Filesystem.h"
+#include "Ext2Hash.h"
 #include <kernel/filesystem/DirectoryEntry.h>
+#include <kernel/filesystem/FileDescriptor.h>
 #include <kernel/kstd/KLog.h>
 
+//Directories with at least this many blocks get an in-memory index if they don't have an htree
+#define DIR_INDEX_MIN_BLOCKS 2
+#define DIR_INDEX_HASH EXT2_HASH_TEA_UNSIGNED
+#define DIR_INDEX_END 0xFFFFFFFF
+//How many blocks to reserve after the end of a file being appended to, if the superblock doesn't say
+#define EXT2_DEFAULT_PREALLOC_BLOCKS 8
+
+/** The space an entry with a name of the given length takes up, including padding to four bytes. **/
+static inline size_t entry_size(size_t name_length) {
+	return (sizeof(ext2_directory) + name_length + 3) & ~3u;
+}
+
+static inline bool entry_has_name(ext2_directory* entry, const kstd::string& name) {
+	return entry->inode && entry->name_length == name.length() && !memcmp(&entry->type + 1, name.c_str(), name.length());
+}
+
+/**
+ * Whether the entry at the given offset in a directory block fits in the block along with its name, so that reading it
+ * or skipping past it stays in bounds. A corrupt entry means the rest of the block can't be trusted.
+ */
+static inline bool entry_is_valid(ext2_directory* entry, size_t offset, size_t block_size) {
+	return entry->size >= sizeof(ext2_directory) && !(entry->size % 4) && offset + entry->size <= block_size
+		&& sizeof(ext2_directory) + entry->name_length <= entry->size;
+}
+
+/** Searches a directory block for an entry with the given name, comparing names in place. **/
+static ext2_directory* find_in_block(uint8_t* block, size_t block_size, const kstd::string& name) {
+	size_t offset = 0;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* entry = (ext2_directory*) (block + offset);
+		if(!entry_is_valid(entry, offset, block_size))
+			break;
+		if(entry_has_name(entry, name))
+			return entry;
+		offset += entry->size;
+	}
+	return nullptr;
+}
+
 Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t id): Inode(filesystem, id) {
 	//Get the block group
 	Ext2BlockGroup* bg = ext2fs().get_block_group(block_group());
@@ -38,14 +79,14 @@ Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t id): Inode(filesystem, id
 	memcpy(&raw, inodeRaw, sizeof(Ext2Inode::Raw));
 
 	create_metadata();
-
-	//Read block pointers
-	if(!_metadata.is_device())
-		read_block_pointers();
 }
 
-Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t i, const Raw &raw, kstd::vector<uint32_t>& block_pointers, ino_t parent): Inode(filesystem, i), block_pointers(block_pointers), raw(raw) {
+Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t i, const Raw &raw, kstd::vector<uint32_t>& block_pointers, ino_t parent): Inode(filesystem, i), raw(raw) {
 	create_metadata();
+	//Any pointer blocks needed to map the blocks are counted as they're allocated
+	this->raw.logical_blocks = block_pointers.size() * (ext2fs().block_size() / 512);
+	for(size_t block_index = 0; block_index < block_pointers.size(); block_index++)
+		set_block_pointer(block_index, block_pointers[block_index]);
 	if(IS_DIR(raw.mode)) {
 		kstd::vector<DirectoryEntry> entries;
 		entries.reserve(2);
@@ -59,8 +100,14 @@ Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t i, const Raw &raw, kstd::
 }
 
 Ext2Inode::~Ext2Inode() {
-	if(_dirty && exists())
-		write_to_disk();
+	if(exists()) {
+		discard_preallocation();
+		if(_dirty)
+			write_to_disk();
+		else
+			flush_indirect_blocks();
+	}
+	release_indirect_blocks();
 }
 
 uint32_t Ext2Inode::block_group(){
@@ -84,36 +131,300 @@ size_t Ext2Inode::num_blocks() {
 	return (_metadata.size + ext2fs().block_size() - 1) / ext2fs().block_size();
 }
 
+bool Ext2Inode::has_block_map() {
+	//Device numbers and short symlinks are stored where the block pointers would go
+	return !_metadata.is_device() && !(_metadata.is_symlink() && _metadata.size < 60);
+}
+
+unsigned Ext2Inode::block_path(uint32_t block_index, uint32_t offsets[3]) {
+	uint32_t per_block = ext2fs().block_pointers_per_block;
+	if(block_index < 12) {
+		offsets[0] = block_index;
+		return 0;
+	}
+
+	block_index -= 12;
+	if(block_index < per_block) {
+		offsets[0] = block_index;
+		return 1;
+	}
+
+	block_index -= per_block;
+	if(block_index < per_block * per_block) {
+		offsets[0] = block_index / per_block;
+		offsets[1] = block_index % per_block;
+		return 2;
+	}
+
+	block_index -= per_block * per_block;
+	offsets[0] = block_index / (per_block * per_block);
+	offsets[1] = (block_index / per_block) % per_block;
+	offsets[2] = block_index % per_block;
+	return 3;
+}
+
+uint32_t* Ext2Inode::indirect_root(unsigned depth) {
+	if(depth == 1)
+		return &raw.s_pointer;
+	if(depth == 2)
+		return &raw.d_pointer;
+	return &raw.t_pointer;
+}
+
 uint32_t Ext2Inode::get_block_pointer(uint32_t block_index) {
-	if(block_index >= block_pointers.size()) return 0;
-	return block_pointers[block_index];
+	if(!has_block_map()) return 0;
+	LOCK(lock);
+
+	//Most lookups are for blocks right after the last one that was looked up
+	if(block_index - _run_start < _run_length)
+		return _run_block + (block_index - _run_start);
+
+	uint32_t offsets[3];
+	unsigned depth = block_path(block_index, offsets);
+	uint32_t* pointers = raw.block_pointers;
+	size_t num_pointers = 12;
+	if(depth) {
+		uint32_t block = *indirect_root(depth);
+		for(unsigned level = 0; level < depth - 1 && block; level++) {
+			auto* indirect = indirect_block(block);
+			if(!indirect)
+				return 0;
+			block = indirect->pointers[offsets[level]];
+		}
+		if(!block)
+			return 0;
+		auto* indirect = indirect_block(block);
+		if(!indirect)
+			return 0;
+		pointers = indirect->pointers;
+		num_pointers = ext2fs().block_pointers_per_block;
+	}
+
+	//Remember how far the run of physically contiguous blocks from this one goes within the same pointer block
+	uint32_t offset = offsets[depth ? depth - 1 : 0];
+	uint32_t block = pointers[offset];
+	if(block) {
+		size_t run_length = 1;
+		while(offset + run_length < num_pointers && pointers[offset + run_length] == block + run_length)
+			run_length++;
+		_run_start = block_index;
+		_run_block = block;
+		_run_length = run_length;
+	}
+	return block;
 }
 
-bool Ext2Inode::set_block_pointer(uint32_t block_index, uint32_t block) {
+Result Ext2Inode::set_block_pointer(uint32_t block_index, uint32_t block) {
 	LOCK(lock);
+	if(block_index - _run_start <= _run_length)
+		_run_length = 0;
+
+	uint32_t offsets[3];
+	unsigned depth = block_path(block_index, offsets);
+
+	//Walk down to the pointer, allocating any missing pointer blocks along the way near the block itself
+	IndirectBlock* indirect = nullptr;
+	for(unsigned level = 0; level <= depth; level++) {
+		uint32_t* pointer = pointer_to(depth, offsets, level, indirect);
+		if(!pointer)
+			return Result(-EIO);
+
+		if(level == depth) {
+			*pointer = block;
+		} else if(!*pointer) {
+			if(!block)
+				return Result(SUCCESS); //Nothing to clear
+			uint32_t pointer_block = ext2fs().allocate_block(true, block);
+			if(!pointer_block)
+				return Result(-ENOSPC);
+			raw.logical_blocks += ext2fs().block_size() / 512;
+			*pointer = pointer_block;
+		} else {
+			continue;
+		}
 
-	if(block_index == 0 && block_pointers.empty()) {
-		block_pointers.push_back(block);
-		_dirty = true;
-		return true;
-	} else if(block_index < block_pointers.size()) {
-		block_pointers[block_index] = block;
-		_dirty = true;
-		return true;
-	} else if(block_index == block_pointers.size()) {
-		block_pointers.push_back(block);
-		_dirty = true;
-		return true;
-	} else return false;
+		if(indirect)
+			indirect->dirty = true;
+		else
+			_dirty = true;
+	}
+
+	return Result(SUCCESS);
 }
 
-kstd::vector<uint32_t>& Ext2Inode::get_block_pointers() {
-	return block_pointers;
+uint32_t* Ext2Inode::pointer_to(unsigned depth, const uint32_t offsets[3], unsigned level, IndirectBlock*& indirect) {
+	indirect = nullptr;
+	if(!depth)
+		return &raw.block_pointers[offsets[0]];
+
+	uint32_t* pointer = indirect_root(depth);
+	for(unsigned i = 0; i < level; i++) {
+		indirect = indirect_block(*pointer);
+		if(!indirect)
+			return nullptr;
+		pointer = &indirect->pointers[offsets[i]];
+	}
+	return pointer;
+}
+
+Ext2Inode::IndirectBlock* Ext2Inode::indirect_block(uint32_t block) {
+	IndirectBlock* victim = nullptr;
+	for(auto& entry : _indirect_blocks) {
+		if(entry.pointers && entry.block == block) {
+			entry.last_used = ++_indirect_clock;
+			return &entry;
+		}
+		if(!victim || (victim->pointers && (!entry.pointers || entry.last_used < victim->last_used)))
+			victim = &entry;
+	}
+
+	//Replace the least recently used pointer block, writing it back first if it was changed
+	if(!victim->pointers) {
+		victim->pointers = (uint32_t*) kmalloc(ext2fs().block_size());
+	} else if(victim->dirty) {
+		ext2fs().write_block(victim->block, (uint8_t*) victim->pointers);
+	}
+	victim->dirty = false;
+	victim->block = 0;
+	auto res = ext2fs().read_block(block, (uint8_t*) victim->pointers);
+	if(res.is_error()) {
+		KLog::err("ext2", "Error %d reading pointer block %d of inode %d", res.code(), block, id);
+		return nullptr;
+	}
+	victim->block = block;
+	victim->last_used = ++_indirect_clock;
+	return victim;
+}
+
+void Ext2Inode::flush_indirect_blocks() {
+	for(auto& entry : _indirect_blocks) {
+		if(entry.pointers && entry.dirty) {
+			ext2fs().write_block(entry.block, (uint8_t*) entry.pointers);
+			entry.dirty = false;
+		}
+	}
+}
+
+Result Ext2Inode::sync_pointer_blocks(uint32_t block, unsigned depth) {
+	auto res = ext2fs().sync_data(block, ext2fs().block_size());
+	if(res.is_error() || depth == 1)
+		return res;
+
+	//Copy the pointers out, since syncing the blocks under this one may evict it from the cache
+	auto* indirect = indirect_block(block);
+	if(!indirect)
+		return Result(-EIO);
+	uint32_t pointers[ext2fs().block_pointers_per_block];
+	memcpy(pointers, indirect->pointers, sizeof(pointers));
+	for(auto pointer : pointers) {
+		if(!pointer)
+			continue;
+		res = sync_pointer_blocks(pointer, depth - 1);
+		if(res.is_error())
+			return res;
+	}
+	return Result(SUCCESS);
+}
+
+void Ext2Inode::release_indirect_blocks() {
+	for(auto& entry : _indirect_blocks) {
+		kfree(entry.pointers);
+		entry = IndirectBlock();
+	}
+	_run_length = 0;
+}
+
+void Ext2Inode::free_mapped_blocks(kstd::vector<uint32_t>& freed, uint32_t first_kept) {
+	if(!has_block_map())
+		return;
+
+	size_t num_already_freed = freed.size();
+	for(uint32_t i = first_kept; i < 12; i++) {
+		if(raw.block_pointers[i])
+			freed.push_back(raw.block_pointers[i]);
+		raw.block_pointers[i] = 0;
+	}
+
+	uint32_t per_block = ext2fs().block_pointers_per_block;
+	uint32_t first_index = 12;
+	for(unsigned depth = 1; depth <= 3; depth++) {
+		uint32_t root = *indirect_root(depth);
+		free_mapped_blocks(root, depth, first_index, first_kept, freed);
+		*indirect_root(depth) = root;
+		first_index += depth == 1 ? per_block : per_block * per_block;
+	}
+
+	uint32_t freed_sectors = (freed.size() - num_already_freed) * (ext2fs().block_size() / 512);
+	raw.logical_blocks -= min(raw.logical_blocks, freed_sectors);
+	_run_length = 0;
+	_dirty = true;
+}
+
+void Ext2Inode::free_mapped_blocks(uint32_t& pointer, unsigned depth, uint32_t first_index, uint32_t first_kept, kstd::vector<uint32_t>& freed) {
+	if(!pointer)
+		return;
+
+	//Each pointer in the block maps this many blocks
+	uint32_t per_block = ext2fs().block_pointers_per_block;
+	uint32_t span = 1;
+	for(unsigned i = 1; i < depth; i++)
+		span *= per_block;
+
+	for(uint32_t i = 0; i < per_block; i++) {
+		uint32_t slot_first = first_index + i * span;
+		if(slot_first + span <= first_kept)
+			continue;
+
+		//Look the pointer block up each time, since freeing the blocks under it may have pushed it out of the cache
+		auto* indirect = indirect_block(pointer);
+		if(!indirect)
+			return;
+		uint32_t child = indirect->pointers[i];
+		if(!child)
+			continue;
+
+		if(depth == 1) {
+			freed.push_back(child);
+			child = 0;
+		} else {
+			free_mapped_blocks(child, depth - 1, slot_first, first_kept, freed);
+			indirect = indirect_block(pointer);
+			if(!indirect)
+				return;
+		}
+		if(indirect->pointers[i] != child) {
+			indirect->pointers[i] = child;
+			indirect->dirty = true;
+		}
+	}
+
+	//If nothing this block maps is being kept, free the block itself too
+	if(first_index >= first_kept) {
+		for(auto& entry : _indirect_blocks) {
+			if(entry.pointers && entry.block == pointer) {
+				entry.dirty = false;
+				entry.block = 0;
+			}
+		}
+		freed.push_back(pointer);
+		pointer = 0;
+	}
+}
+
+size_t Ext2Inode::contiguous_blocks(uint32_t block_index, size_t max_bytes) {
+	uint32_t block = get_block_pointer(block_index);
+	size_t max_blocks = (max_bytes + ext2fs().block_size() - 1) / ext2fs().block_size();
+	size_t num_blocks = 1;
+	while(num_blocks < max_blocks && get_block_pointer(block_index + num_blocks) == block + num_blocks)
+		num_blocks++;
+	return num_blocks;
 }
 
 void Ext2Inode::free_all_blocks() {
-	ext2fs().free_blocks(block_pointers);
-	ext2fs().free_blocks(pointer_blocks);
+	discard_preallocation();
+	kstd::vector<uint32_t> freed;
+	free_mapped_blocks(freed, 0);
+	ext2fs().free_blocks(freed);
 }
 
 ssize_t Ext2Inode::read(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) {
@@ -135,33 +446,28 @@ ssize_t Ext2Inode::read(size_t start, size_t length, SafePointer<uint8_t> buffer
 
 	if(start + length > _metadata.size) length = _metadata.size - start;
 
-	//TODO: symlinks
-	size_t first_block = start / ext2fs().block_size();
-	size_t first_block_start = start % ext2fs().block_size();
-	size_t bytes_left = length;
-	size_t block_index = first_block;
+	size_t nread = 0;
+	while(nread < length) {
+		size_t block_index = (start + nread) / ext2fs().block_size();
+		size_t block_offset = (start + nread) % ext2fs().block_size();
+		auto out = SafePointer<uint8_t>(buffer.raw() + nread, buffer.is_user());
 
-	uint8_t block_buf[ext2fs().block_size()];
-	while(bytes_left) {
-		ext2fs().read_block(get_block_pointer(block_index), block_buf);
-		if(block_index == first_block) {
-			if(length < ext2fs().block_size() - first_block_start) {
-				buffer.write(block_buf + first_block_start, length);
-				bytes_left = 0;
-			} else {
-				buffer.write(block_buf + first_block_start, ext2fs().block_size() - first_block_start);
-				bytes_left -= ext2fs().block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < ext2fs().block_size()) {
-				buffer.write(block_buf, length - bytes_left, bytes_left);
-				bytes_left = 0;
-			} else {
-				buffer.write( block_buf, length - bytes_left, ext2fs().block_size());
-				bytes_left -= ext2fs().block_size();
-			}
+		//Unallocated blocks read as zeroes
+		uint32_t block = get_block_pointer(block_index);
+		if(!block) {
+			size_t to_zero = min(ext2fs().block_size() - block_offset, length - nread);
+			out.memset(0, 0, to_zero);
+			nread += to_zero;
+			continue;
 		}
-		block_index++;
+
+		//Read the whole run of physically contiguous blocks in one go
+		size_t run_length = contiguous_blocks(block_index, block_offset + length - nread) * ext2fs().block_size() - block_offset;
+		run_length = min(run_length, length - nread);
+		auto res = ext2fs().read_data(block, block_offset, run_length, out);
+		if(res.is_error())
+			return res.code();
+		nread += run_length;
 	}
 	return length;
 }
@@ -181,52 +487,106 @@ ssize_t Ext2Inode::write(size_t start, size_t length, SafePointer<uint8_t> buf,
 		return length;
 	}
 
-	size_t first_block = start / ext2fs().block_size();
-	size_t first_block_start = start % ext2fs().block_size();
-	size_t bytes_left = length;
-	size_t block_index = first_block;
-
-	//If this write is going to expand the file, resize it
+	//If this write is going to expand the file, resize it (this doesn't allocate any blocks)
 	if(start + length > _metadata.size) {
 		auto res = truncate((off_t)start + (off_t)length);
 		if(res.is_error()) return res.code();
 	}
 
-	uint8_t block_buf[ext2fs().block_size()];
-	while(bytes_left) {
+	size_t nwritten = 0;
+	while(nwritten < length) {
+		size_t block_index = (start + nwritten) / ext2fs().block_size();
+		size_t block_offset = (start + nwritten) % ext2fs().block_size();
+
+		//If the block is in a hole, allocate blocks for the whole part of the hole that this write covers at once
 		uint32_t block = get_block_pointer(block_index);
+		if(!block) {
+			uint32_t last_index = (start + length - 1) / ext2fs().block_size();
+			uint32_t hole_length = 1;
+			while(block_index + hole_length <= last_index && !get_block_pointer(block_index + hole_length))
+				hole_length++;
+			auto res = fill_hole(block_index, hole_length, start, start + length);
+			if(res.is_error())
+				return res.code();
+			block = get_block_pointer(block_index);
+		}
+
+		//Write the whole run of physically contiguous blocks in one go
+		size_t run_length = contiguous_blocks(block_index, block_offset + length - nwritten) * ext2fs().block_size() - block_offset;
+		run_length = min(run_length, length - nwritten);
+		auto res = ext2fs().write_data(block, block_offset, run_length, SafePointer<uint8_t>(buf.raw() + nwritten, buf.is_user()));
+		if(res.is_error())
+			return res.code();
+		nwritten += run_length;
+	}
 
-		//The block isn't allocated, no space
-		if(!block) return -ENOSPC;
+	return length;
+}
 
-		//Read the block into a buffer
-		ext2fs().read_block(block, block_buf);
+void Ext2Inode::readahead(size_t start, size_t length) {
+	if(!_metadata.is_simple_file() || !exists())
+		return;
 
-		//Copy the appropriate portion of the buffer into the appropriate portion of the block buffer
-		if(block_index == first_block) {
-			if(length < ext2fs().block_size() - first_block_start) {
-				buf.read(block_buf + first_block_start, length);
-				bytes_left = 0;
-			} else {
-				buf.read(block_buf + first_block_start, ext2fs().block_size() - first_block_start);
-				bytes_left -= ext2fs().block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < ext2fs().block_size()) {
-				buf.read(block_buf, length - bytes_left, bytes_left);
-				bytes_left = 0;
-			} else {
-				buf.read(block_buf, length - bytes_left, ext2fs().block_size());
-				bytes_left -= ext2fs().block_size();
-			}
+	LOCK(lock);
+	if(start >= _metadata.size)
+		return;
+	if(start + length > _metadata.size)
+		length = _metadata.size - start;
+
+	size_t nqueued = 0;
+	while(nqueued < length) {
+		size_t block_index = (start + nqueued) / ext2fs().block_size();
+		size_t block_offset = (start + nqueued) % ext2fs().block_size();
+		size_t run_length = ext2fs().block_size() - block_offset;
+		uint32_t block = get_block_pointer(block_index);
+		if(block) {
+			run_length = contiguous_blocks(block_index, block_offset + length - nqueued) * ext2fs().block_size() - block_offset;
+			ext2fs().prefetch_data(block, block_offset + min(run_length, length - nqueued));
 		}
+		nqueued += min(run_length, length - nqueued);
+	}
+}
+
+Result Ext2Inode::sync() {
+	if(!exists())
+		return Result(SUCCESS);
 
-		//Write the block to disk/cache
-		ext2fs().write_block(block, block_buf);
-		block_index++;
+	LOCK(lock);
+	auto res = write_to_disk();
+	if(res.is_error())
+		return res;
+
+	//The block of the inode table with our entry in it
+	Ext2BlockGroup* bg = ext2fs().get_block_group(block_group());
+	res = ext2fs().sync_data(bg->inode_table_block + block(), ext2fs().block_size());
+	if(res.is_error() || !has_block_map())
+		return res;
+
+	//Our data, a run of contiguous blocks at a time
+	size_t file_blocks = num_blocks();
+	for(size_t block_index = 0; block_index < file_blocks;) {
+		uint32_t data_block = get_block_pointer(block_index);
+		if(!data_block) {
+			block_index++;
+			continue;
+		}
+		size_t run_blocks = contiguous_blocks(block_index, (file_blocks - block_index) * ext2fs().block_size());
+		res = ext2fs().sync_data(data_block, run_blocks * ext2fs().block_size());
+		if(res.is_error())
+			return res;
+		block_index += run_blocks;
 	}
 
-	return length;
+	//And the pointer blocks that map it
+	for(unsigned depth = 1; depth <= 3; depth++) {
+		uint32_t pointer_block = *indirect_root(depth);
+		if(!pointer_block)
+			continue;
+		res = sync_pointer_blocks(pointer_block, depth);
+		if(res.is_error())
+			return res;
+	}
+	return Result(SUCCESS);
 }
 
 void Ext2Inode::iterate_entries(kstd::IterationFunc<const DirectoryEntry&> callback) {
@@ -237,6 +597,14 @@ void Ext2Inode::iterate_entries(kstd::IterationFunc<const DirectoryEntry&> callb
 		size_t i = 0;
 		while((i < ext2fs().block_size()) && (block * ext2fs().block_size() + i < _metadata.size)) {
 			auto* dir = (ext2_directory*)(buf + i);
+			if(i + sizeof(ext2_directory) > ext2fs().block_size() || !entry_is_valid(dir, i, ext2fs().block_size()))
+				break;
+
+			//Unused entries (and htree index blocks) have an inode of zero
+			if(!dir->inode) {
+				i += dir->size;
+				continue;
+			}
 
 			size_t name_length = dir->name_length;
 			if(name_length > NAME_MAXLEN - 1)
@@ -257,49 +625,283 @@ void Ext2Inode::iterate_entries(kstd::IterationFunc<const DirectoryEntry&> callb
 
 ino_t Ext2Inode::find_id(const kstd::string& find_name) {
 	if(!metadata().is_directory()) return 0;
+	if(!find_name.length() || find_name.length() > EXT2_NAME_MAXLEN) return 0;
 	LOCK(lock);
+
 	ino_t ret = 0;
-	auto* buf = static_cast<uint8_t *>(kmalloc(ext2fs().block_size()));
+	auto* buf = static_cast<uint8_t *>(kmalloc(ext2fs().block_size() * 2));
+	EntryLocation location;
+	if(locate_entry(find_name, buf, location))
+		ret = ((ext2_directory*) (location.block + location.offset))->inode;
+	kfree(buf);
+	return ret;
+}
+
+bool Ext2Inode::is_htree() {
+	return (raw.flags & EXT2_INDEX) && (ext2fs().superblock.optional_features & EXT2_FEATURE_COMPAT_DIR_INDEX);
+}
+
+bool Ext2Inode::locate_entry(const kstd::string& name, uint8_t* buf, EntryLocation& location, size_t* htree_leaf) {
+	if(htree_leaf)
+		*htree_leaf = -1;
+
+	if(is_htree()) {
+		bool usable = false;
+		bool found = locate_entry_htree(name, buf, usable, location, htree_leaf);
+		if(usable)
+			return found;
+		KLog::warn("ext2", "Couldn't use htree index of directory inode %d, searching it linearly", id);
+	}
+
+	if(num_blocks() >= DIR_INDEX_MIN_BLOCKS)
+		return locate_entry_indexed(name, buf, location);
+
+	for(size_t i = 0; i < num_blocks(); i++) {
+		uint32_t block = get_block_pointer(i);
+		if(!block)
+			continue;
+		ext2fs().read_block(block, buf);
+		if(auto* entry = find_in_block(buf, ext2fs().block_size(), name)) {
+			location = {i, (size_t) ((uint8_t*) entry - buf), buf};
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Ext2Inode::locate_entry_htree(const kstd::string& name, uint8_t* buf, bool& usable, EntryLocation& location, size_t* htree_leaf) {
+	usable = false;
+	size_t block_size = ext2fs().block_size();
+	uint8_t* leaf_buf = buf + block_size;
+	if(!num_blocks() || !get_block_pointer(0))
+		return false;
+
+	//The root's info is hidden after the "." and ".." entries at the start of the directory
+	ext2fs().read_block(get_block_pointer(0), buf);
+	auto* dot = (ext2_directory*) buf;
+	auto* dotdot = (ext2_directory*) (buf + 12);
+	auto* info = (ext2_dx_root_info*) (buf + 24);
+	if(dot->size != 12 || dotdot->size != block_size - 12)
+		return false;
+	if(info->reserved_zero || info->info_length != sizeof(ext2_dx_root_info) || info->hash_version > EXT2_HASH_TEA)
+		return false;
+	if(info->indirect_levels > EXT2_DX_MAX_INDIRECT_LEVELS)
+		return false;
+
+	uint8_t hash_version = info->hash_version;
+	if(ext2fs().superblock.flags & EXT2_FLAGS_UNSIGNED_HASH)
+		hash_version += EXT2_HASH_LEGACY_UNSIGNED;
+	uint32_t hash = Ext2Hash::hash(name.c_str(), name.length(), hash_version, ext2fs().superblock.hash_seed);
+
+	unsigned levels = info->indirect_levels;
+	auto* entries = (ext2_dx_entry*) ((uint8_t*) info + info->info_length);
+	for(unsigned level = 0;; level++) {
+		auto* countlimit = (ext2_dx_countlimit*) entries;
+		size_t count = countlimit->count;
+		if(!count || count > countlimit->limit || (uint8_t*) (entries + countlimit->limit) > buf + block_size)
+			return false;
+
+		//Find the last entry with a hash no greater than ours. The first entry covers everything below the second.
+		size_t lo = 1, hi = count;
+		while(lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if(entries[mid].hash > hash)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		size_t index = lo - 1;
+
+		if(level < levels) {
+			uint32_t node = entries[index].block & EXT2_DX_BLOCK_MASK;
+			if(node >= num_blocks() || !get_block_pointer(node))
+				return false;
+			//Index nodes start with an empty entry covering the whole block, so they look empty when read linearly
+			ext2fs().read_block(get_block_pointer(node), buf);
+			entries = (ext2_dx_entry*) (buf + sizeof(ext2_directory));
+			continue;
+		}
+
+		//Search the leaf, along with any following leaves that names with the same hash spilled over into
+		size_t first_leaf = entries[index].block & EXT2_DX_BLOCK_MASK;
+		while(true) {
+			uint32_t leaf = entries[index].block & EXT2_DX_BLOCK_MASK;
+			if(leaf >= num_blocks() || !get_block_pointer(leaf))
+				return false;
+			ext2fs().read_block(get_block_pointer(leaf), leaf_buf);
+			if(auto* entry = find_in_block(leaf_buf, block_size, name)) {
+				usable = true;
+				location = {leaf, (size_t) ((uint8_t*) entry - leaf_buf), leaf_buf};
+				return true;
+			}
+
+			//If the spill-over continues into the next index node, we can't follow it from here
+			if(++index >= count)
+				usable = !levels;
+			else if((entries[index].hash & ~1u) != hash)
+				usable = true;
+			else
+				continue;
+
+			if(usable && htree_leaf)
+				*htree_leaf = first_leaf;
+			return false;
+		}
+	}
+}
+
+bool Ext2Inode::locate_entry_indexed(const kstd::string& name, uint8_t* buf, EntryLocation& location) {
+	if(_dir_index_buckets.empty())
+		build_directory_index(buf);
+
+	size_t block_size = ext2fs().block_size();
+	uint32_t hash = Ext2Hash::hash(name.c_str(), name.length(), DIR_INDEX_HASH, nullptr);
+	size_t loaded_block = -1;
+	uint32_t index = _dir_index_buckets[(hash >> 1) & (_dir_index_buckets.size() - 1)];
+	for(; index != DIR_INDEX_END; index = _dir_index[index].next) {
+		auto& index_entry = _dir_index[index];
+		if(index_entry.hash != hash)
+			continue;
+
+		//Check the name on disk, since different names can have the same hash
+		size_t block_index = index_entry.position / block_size;
+		if(block_index != loaded_block) {
+			ext2fs().read_block(get_block_pointer(block_index), buf);
+			loaded_block = block_index;
+		}
+		auto* entry = (ext2_directory*) (buf + index_entry.position % block_size);
+		if(entry_has_name(entry, name)) {
+			location = {block_index, index_entry.position % block_size, buf};
+			return true;
+		}
+	}
+	return false;
+}
+
+void Ext2Inode::build_directory_index(uint8_t* buf) {
+	size_t block_size = ext2fs().block_size();
+	_dir_index = kstd::vector<DirectoryIndexEntry>();
 	for(size_t i = 0; i < num_blocks(); i++) {
 		uint32_t block = get_block_pointer(i);
+		if(!block)
+			continue;
 		ext2fs().read_block(block, buf);
-		auto* dir = reinterpret_cast<ext2_directory*>(buf);
-		uint32_t add = 0;
-		char name_buf[257];
-		while(dir->inode != 0 && add < ext2fs().block_size()) {
-			memcpy(name_buf, &dir->type+1, dir->name_length);
-			name_buf[dir->name_length] = '\0';
-			if(find_name == name_buf){
-				ret = dir->inode;
+		size_t offset = 0;
+		while(offset + sizeof(ext2_directory) <= block_size) {
+			auto* entry = (ext2_directory*) (buf + offset);
+			if(!entry_is_valid(entry, offset, block_size))
 				break;
+			if(entry->inode && entry->name_length) {
+				uint32_t hash = Ext2Hash::hash((char*) (&entry->type + 1), entry->name_length, DIR_INDEX_HASH, nullptr);
+				_dir_index.push_back({hash, (uint32_t) (i * block_size + offset), DIR_INDEX_END});
 			}
-			add += dir->size;
-			dir = (ext2_directory*)((size_t)dir + dir->size);
+			offset += entry->size;
 		}
 	}
-	kfree(buf);
-	return ret;
+
+	//Chain the entries into a power-of-two number of buckets, about one entry per bucket. The lowest bit of the hash is always clear.
+	size_t num_buckets = 1;
+	while(num_buckets < _dir_index.size())
+		num_buckets <<= 1;
+	_dir_index_buckets = kstd::vector<uint32_t>();
+	_dir_index_buckets.resize(num_buckets);
+	for(size_t i = 0; i < num_buckets; i++)
+		_dir_index_buckets[i] = DIR_INDEX_END;
+	for(size_t i = 0; i < _dir_index.size(); i++) {
+		uint32_t& head = _dir_index_buckets[(_dir_index[i].hash >> 1) & (num_buckets - 1)];
+		_dir_index[i].next = head;
+		head = i;
+	}
 }
 
-Result Ext2Inode::add_entry(const kstd::string &name, Inode &inode) {
-	ASSERT(inode.fs.fsid() == ext2fs().fsid());
-	if(!metadata().is_directory()) return Result(-ENOTDIR);
-	if(!name.length() || name.length() > NAME_MAXLEN) return Result(-ENAMETOOLONG);
+void Ext2Inode::add_to_directory_index(const kstd::string& name, size_t position) {
+	if(_dir_index_buckets.empty())
+		return;
 
-	LOCK(lock);
+	//Once the chains get too long (or too many removed entries pile up), rebuild the index next time it's needed
+	if(_dir_index.size() >= _dir_index_buckets.size() * 2) {
+		invalidate_directory_index();
+		return;
+	}
 
-	//Read entries into a vector
-	kstd::vector<DirectoryEntry> entries;
-	bool exist = false;
-	iterate_entries([&] (const DirectoryEntry& dirent) -> kstd::IterationAction {
-		entries.push_back(dirent);
-		if(name == dirent.name) {
-			exist = true;
-			return kstd::IterationAction::Break;
+	uint32_t hash = Ext2Hash::hash(name.c_str(), name.length(), DIR_INDEX_HASH, nullptr);
+	uint32_t& head = _dir_index_buckets[(hash >> 1) & (_dir_index_buckets.size() - 1)];
+	_dir_index.push_back({hash, (uint32_t) position, head});
+	head = _dir_index.size() - 1;
+}
+
+void Ext2Inode::remove_from_directory_index(const kstd::string& name, size_t position) {
+	if(_dir_index_buckets.empty())
+		return;
+
+	uint32_t hash = Ext2Hash::hash(name.c_str(), name.length(), DIR_INDEX_HASH, nullptr);
+	uint32_t* link = &_dir_index_buckets[(hash >> 1) & (_dir_index_buckets.size() - 1)];
+	while(*link != DIR_INDEX_END) {
+		if(_dir_index[*link].position == position) {
+			*link = _dir_index[*link].next;
+			return;
 		}
-		return kstd::IterationAction::Continue;
-	});
-	if (exist)
+		link = &_dir_index[*link].next;
+	}
+}
+
+void Ext2Inode::invalidate_directory_index() {
+	_dir_index_buckets = kstd::vector<uint32_t>();
+	_dir_index = kstd::vector<DirectoryIndexEntry>();
+}
+
+void Ext2Inode::drop_htree() {
+	if(!(raw.flags & EXT2_INDEX))
+		return;
+	raw.flags &= ~EXT2_INDEX;
+	write_inode_entry();
+}
+
+bool Ext2Inode::insert_in_block(size_t block_index, const kstd::string& name, ino_t inode, uint8_t type, uint8_t* buf) {
+	uint32_t block = get_block_pointer(block_index);
+	if(!block)
+		return false;
+
+	size_t block_size = ext2fs().block_size();
+	size_t needed = entry_size(name.length());
+	ext2fs().read_block(block, buf);
+
+	//Look for an entry with enough slack after its name to fit the new one, or an unused one that's big enough
+	size_t offset = 0;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* entry = (ext2_directory*) (buf + offset);
+		if(!entry_is_valid(entry, offset, block_size))
+			return false;
+
+		size_t used = entry->inode ? entry_size(entry->name_length) : 0;
+		if(entry->size - used < needed) {
+			offset += entry->size;
+			continue;
+		}
+
+		auto* new_entry = entry;
+		if(used) {
+			new_entry = (ext2_directory*) (buf + offset + used);
+			new_entry->size = entry->size - used;
+			entry->size = used;
+		}
+		new_entry->inode = inode;
+		new_entry->name_length = name.length();
+		new_entry->type = type;
+		memcpy(&new_entry->type + 1, name.c_str(), name.length());
+
+		ext2fs().write_block(block, buf);
+		add_to_directory_index(name, block_index * block_size + offset + used);
+		return true;
+	}
+
+	return false;
+}
+
+Result Ext2Inode::insert_entry(const kstd::string& name, Inode& inode, uint8_t* buf) {
+	EntryLocation location;
+	size_t htree_leaf;
+	if(locate_entry(name, buf, location, &htree_leaf))
 		return Result(-EEXIST);
 
 	//Determine filetype
@@ -310,13 +912,55 @@ Result Ext2Inode::add_entry(const kstd::string &name, Inode &inode) {
 	else if(inode.metadata().is_block_device()) type = EXT2_FT_BLKDEV;
 	else if(inode.metadata().is_character_device()) type = EXT2_FT_CHRDEV;
 
-	//Increase hardlink count of new inode
+	//An htree directory's entry has to go in the leaf for its hash. If it doesn't fit there, stop using the htree.
+	bool inserted = false;
+	if(is_htree()) {
+		if(htree_leaf != (size_t) -1)
+			inserted = insert_in_block(htree_leaf, name, inode.id, type, buf);
+		if(!inserted)
+			drop_htree();
+	}
+
+	//Otherwise, put it in the first block with room for it
+	for(size_t i = 0; i < num_blocks() && !inserted; i++)
+		inserted = insert_in_block(i, name, inode.id, type, buf);
+
+	if(!inserted) {
+		//There's no room anywhere, so add a block to the directory with just the new entry in it
+		size_t block_size = ext2fs().block_size();
+		size_t block_index = num_blocks();
+		auto res = truncate((off_t) ((block_index + 1) * block_size));
+		if(res.is_error())
+			return res;
+		memset(buf, 0, block_size);
+		auto* entry = (ext2_directory*) buf;
+		entry->inode = inode.id;
+		entry->size = block_size;
+		entry->name_length = name.length();
+		entry->type = type;
+		memcpy(&entry->type + 1, name.c_str(), name.length());
+		ext2fs().write_block(get_block_pointer(block_index), buf);
+		add_to_directory_index(name, block_index * block_size);
+	}
+
+	//Only count the new link once the entry is actually there
 	((Ext2Inode&) inode).increase_hardlink_count();
+	return Result(SUCCESS);
+}
+
+Result Ext2Inode::add_entry(const kstd::string &name, Inode &inode) {
+	ASSERT(inode.fs.fsid() == ext2fs().fsid());
+	if(!metadata().is_directory()) return Result(-ENOTDIR);
+	if(!name.length() || name.length() > EXT2_NAME_MAXLEN) return Result(-ENAMETOOLONG);
+
+	LOCK(lock);
+
+	auto* buf = static_cast<uint8_t *>(kmalloc(ext2fs().block_size() * 2));
+	auto res = insert_entry(name, inode, buf);
+	kfree(buf);
+	if(res.is_error())
+		return res;
 
-	//Push new entry into vector and write to disk
-	entries.push_back({inode.id, type, name});
-	auto res = write_directory_entries(entries);
-	if(res.is_error()) return res;
 	if(_dirty) { //We changed the amount of blocks
 		res = write_to_disk();
 		if(res.is_error()) return res;
@@ -335,12 +979,6 @@ ResultRet<kstd::Arc<Inode>> Ext2Inode::create_entry(const kstd::string& name, mo
 	if(inode_or_err.is_error())
 		return inode_or_err.result();
 
-	if(IS_DIR(mode)) {
-		//Increase hardlink count to account for .. if the new entry is a directory
-		raw.hard_links++;
-		write_inode_entry();
-	}
-
 	//Add entry
 	auto entry_result = add_entry(name, *inode_or_err.value());
 	if(entry_result.is_error()) {
@@ -351,33 +989,34 @@ ResultRet<kstd::Arc<Inode>> Ext2Inode::create_entry(const kstd::string& name, mo
 		return entry_result;
 	}
 
+	if(IS_DIR(mode)) {
+		//Increase hardlink count to account for .. if the new entry is a directory
+		raw.hard_links++;
+		write_inode_entry();
+	}
+
 	return static_cast<kstd::Arc<Inode>>(inode_or_err.value());
 }
 
 Result Ext2Inode::remove_entry(const kstd::string &name) {
 	if(!metadata().is_directory()) return Result(-ENOTDIR);
-	if(!name.length() || name.length() > NAME_MAXLEN) return Result(-ENAMETOOLONG);
+	if(!name.length() || name.length() > EXT2_NAME_MAXLEN) return Result(-ENAMETOOLONG);
 
 	LOCK(lock);
 
-	//Read entries into vector and find the child we need
-	kstd::vector<DirectoryEntry> entries;
-	int entry_index = 0;
-	bool found = false;
-	int i = 0;
-	iterate_entries([&] (const DirectoryEntry& dirent) -> kstd::IterationAction {
-		entries.push_back(dirent);
-		if (name == dirent.name) {
-			entry_index = i;
-			found = true;
-		}
-		i++;
-		return kstd::IterationAction::Continue;
-	});
+	auto* buf = static_cast<uint8_t *>(kmalloc(ext2fs().block_size() * 2));
+	auto res = erase_entry(name, buf);
+	kfree(buf);
+	return res;
+}
 
-	//If we didn't find it or the inode doesn't exist for some reason, return with an error
-	if(!found) return Result(-ENOENT);
-	auto child_or_err = ext2fs().get_inode(entries[entry_index].id);
+Result Ext2Inode::erase_entry(const kstd::string& name, uint8_t* buf) {
+	//Find the entry. If it doesn't exist or its inode doesn't exist for some reason, return with an error
+	EntryLocation location;
+	if(!locate_entry(name, buf, location))
+		return Result(-ENOENT);
+	auto* entry = (ext2_directory*) (location.block + location.offset);
+	auto child_or_err = ext2fs().get_inode(entry->inode);
 	if(child_or_err.is_error()){
 		KLog::warn("ext2", "Orphaned directory entry in inode %d", id);
 		return child_or_err.result();
@@ -393,66 +1032,177 @@ Result Ext2Inode::remove_entry(const kstd::string &name) {
 		ext2ino->reduce_hardlink_count();
 	}
 
-	//Erase the entry and write the entries to disk
-	entries.erase(entry_index);
-	auto res = write_directory_entries(entries);
-	if(res.is_error()) return res;
-	if(_dirty) { //We changed the amount of blocks
-		res = write_to_disk();
-		if(res.is_error()) return res;
+	//Merge the entry into the one before it, or just mark it as unused if it's the first in its block
+	ext2_directory* prev = nullptr;
+	size_t offset = 0;
+	while(offset < location.offset) {
+		prev = (ext2_directory*) (location.block + offset);
+		if(!entry_is_valid(prev, offset, ext2fs().block_size()))
+			break;
+		offset += prev->size;
 	}
+	if(prev && offset == location.offset)
+		prev->size += entry->size;
+	else
+		entry->inode = 0;
+
+	ext2fs().write_block(get_block_pointer(location.block_index), location.block);
+	remove_from_directory_index(name, location.block_index * ext2fs().block_size() + location.offset);
 	return Result(SUCCESS);
 }
 
+uint32_t Ext2Inode::block_goal(uint32_t block_index) {
+	//New blocks should go right after the block before them in the file, or at the start of its block group if that's a hole
+	if(block_index) {
+		uint32_t prev_block = get_block_pointer(block_index - 1);
+		if(prev_block)
+			return prev_block + 1;
+	}
+	auto* group = ext2fs().get_block_group(block_group());
+	return group ? group->first_block() : 0;
+}
+
+ResultRet<kstd::vector<uint32_t>> Ext2Inode::allocate_data_blocks(uint32_t block_index, uint32_t num_blocks) {
+	LOCK(lock);
+	uint32_t goal = block_goal(block_index);
+
+	//The preallocated blocks are only any use if they carry on from the block before
+	if(_prealloc_count && _prealloc_start != goal)
+		discard_preallocation();
+
+	kstd::vector<uint32_t> ret;
+	ret.reserve(num_blocks);
+	while(ret.size() < num_blocks && _prealloc_count) {
+		ret.push_back(_prealloc_start++);
+		_prealloc_count--;
+	}
+
+	if(ret.size() < num_blocks) {
+		//Reserve some extra blocks for regular files, so they stay contiguous if they keep being appended to
+		uint32_t needed = num_blocks - ret.size();
+		uint32_t extra = 0;
+		if(_metadata.is_simple_file())
+			extra = ext2fs().superblock.file_prealloc_blocks ? ext2fs().superblock.file_prealloc_blocks : EXT2_DEFAULT_PREALLOC_BLOCKS;
+
+		auto blocks_or_err = ext2fs().allocate_blocks(needed + extra, false, goal);
+		if(blocks_or_err.is_error() && extra) {
+			extra = 0;
+			blocks_or_err = ext2fs().allocate_blocks(needed, false, goal);
+		}
+		if(blocks_or_err.is_error()) {
+			ext2fs().free_blocks(ret);
+			return blocks_or_err.result();
+		}
+
+		auto& blocks = blocks_or_err.value();
+		for(size_t i = 0; i < needed; i++)
+			ret.push_back(blocks[i]);
+
+		//Keep the extra blocks that follow on from the new ones, and give back the rest
+		kstd::vector<uint32_t> unused;
+		_prealloc_start = ret[ret.size() - 1] + 1;
+		_prealloc_count = 0;
+		for(size_t i = needed; i < blocks.size(); i++) {
+			if(unused.empty() && blocks[i] == _prealloc_start + _prealloc_count)
+				_prealloc_count++;
+			else
+				unused.push_back(blocks[i]);
+		}
+		if(!unused.empty())
+			ext2fs().free_blocks(unused);
+	}
+
+	return kstd::move(ret);
+}
+
+Result Ext2Inode::fill_hole(uint32_t block_index, uint32_t num_blocks, size_t start, size_t end) {
+	LOCK(lock);
+	auto blocks_res = allocate_data_blocks(block_index, num_blocks);
+	if(blocks_res.is_error())
+		return blocks_res.result();
+	auto& blocks = blocks_res.value();
+
+	size_t block_size = ext2fs().block_size();
+	for(size_t i = 0; i < blocks.size(); i++) {
+		//Only blocks that aren't about to be completely overwritten need zeroing, since holes read as zeroes
+		size_t block_start = (block_index + i) * block_size;
+		if(block_start < start || block_start + block_size > end)
+			ext2fs().zero_block(blocks[i]);
+
+		auto res = set_block_pointer(block_index + i, blocks[i]);
+		if(res.is_error()) {
+			//Put the hole back the way it was
+			for(size_t j = 0; j < i; j++) {
+				set_block_pointer(block_index + j, 0);
+				raw.logical_blocks -= block_size / 512;
+			}
+			ext2fs().free_blocks(blocks);
+			return res;
+		}
+		raw.logical_blocks += block_size / 512;
+	}
+
+	return Result(SUCCESS);
+}
+
+void Ext2Inode::discard_preallocation() {
+	if(!_prealloc_count)
+		return;
+	kstd::vector<uint32_t> blocks;
+	blocks.reserve(_prealloc_count);
+	for(uint32_t i = 0; i < _prealloc_count; i++)
+		blocks.push_back(_prealloc_start + i);
+	_prealloc_count = 0;
+	ext2fs().free_blocks(blocks);
+}
+
 Result Ext2Inode::truncate(off_t length) {
 	if(length < 0) return Result(-EINVAL);
 	if((size_t)length == _metadata.size) return Result(SUCCESS);
 	LOCK(lock);
 
 	uint32_t new_num_blocks = (length + ext2fs().block_size() - 1) / ext2fs().block_size();
+	size_t old_num_blocks = num_blocks();
+
+	if((size_t) length > _metadata.size) {
+		//A symlink target that won't fit in the inode anymore has to be moved out of where the block pointers go
+		if(_metadata.is_symlink() && _metadata.size < 60 && length >= 60) {
+			uint8_t target[60];
+			size_t target_length = _metadata.size;
+			memcpy(target, raw.block_pointers, target_length);
+			memset(raw.block_pointers, 0, 60);
+			_metadata.size = length;
+			ssize_t res = target_length ? write(0, target_length, KernelPointer<uint8_t>(target), nullptr) : 0;
+			if(res < 0)
+				return Result(res);
+		}
 
-	if(new_num_blocks > num_blocks()) {
-		//We're expanding the file, allocate new blocks
-		auto new_blocks_res = ext2fs().allocate_blocks(new_num_blocks - num_blocks(), true);
-		if(new_blocks_res.is_error())
-			return new_blocks_res.result();
-
-		//If we didn't get the amount of blocks we wanted, return ENOSPC
-		auto new_blocks = new_blocks_res.value();
-		if(new_blocks.size() != new_num_blocks - num_blocks()) return Result(-ENOSPC);
-
-		//Add the new blocks to the block pointers
-		for(size_t i = 0; i < new_blocks.size(); i++)
-			block_pointers.push_back(new_blocks[i]);
-
-		//Write inode entry and block pointers to disk
-		_metadata.size = (size_t) length;
-		write_to_disk();
-	} else if(new_num_blocks < num_blocks()) {
-		//We're shrinking the file, free old blocks
-		for(size_t i = num_blocks(); i > new_num_blocks; i--)
-			ext2fs().free_block(get_block_pointer(i - 1));
-		block_pointers.resize(new_num_blocks);
-
-		//Free old pointer blocks as well
-		size_t new_num_pointer_blocks = calculate_num_ptr_blocks(new_num_blocks);
-		for(size_t i = pointer_blocks.size(); i > new_num_pointer_blocks; i--)
-			ext2fs().free_block(pointer_blocks[i - 1]);
-		pointer_blocks.resize(new_num_pointer_blocks);
-
-		//Zero out the unused portion of the last block
-		if(length % ext2fs().block_size())
-			ext2fs().truncate_block(get_block_pointer(new_num_blocks - 1), length % ext2fs().block_size());
-
-		//Write inode entry and block pointers to disk
-		_metadata.size = (size_t) length;
-		write_to_disk();
+		//Growing a file just leaves a hole that blocks get allocated for when it's written to, except for directories,
+		//which can't have holes. Whoever is growing a directory fills in the new blocks, so they don't need zeroing.
+		if(_metadata.is_directory() && new_num_blocks > old_num_blocks) {
+			auto res = fill_hole(old_num_blocks, new_num_blocks - old_num_blocks, old_num_blocks * ext2fs().block_size(), new_num_blocks * ext2fs().block_size());
+			if(res.is_error())
+				return res;
+		}
 	} else {
-		//Not changing the amount of blocks, so just write the inode entry to disk
-		_metadata.size = (size_t) length;
-		write_inode_entry();
+		//We're shrinking the file, free old blocks and pointer blocks all at once
+		discard_preallocation();
+		if(new_num_blocks < old_num_blocks) {
+			kstd::vector<uint32_t> freed_blocks;
+			free_mapped_blocks(freed_blocks, new_num_blocks);
+			ext2fs().free_blocks(freed_blocks);
+		}
+
+		//Zero out the unused portion of the last block, so it reads as zeroes if the file grows again
+		uint32_t last_block = new_num_blocks ? get_block_pointer(new_num_blocks - 1) : 0;
+		if(last_block && length % ext2fs().block_size())
+			ext2fs().truncate_block(last_block, length % ext2fs().block_size());
 	}
 
+	//Write inode entry and block pointers to disk
+	_metadata.size = (size_t) length;
+	write_to_disk();
+
 	return Result(SUCCESS);
 }
 
@@ -471,157 +1221,17 @@ Result Ext2Inode::chown(uid_t uid, gid_t gid) {
 	return Result(SUCCESS);
 }
 
-void Ext2Inode::read_singly_indirect(uint32_t singly_indirect_block, uint32_t& block_index) {
-	if(block_index >= num_blocks()) return;
-	uint8_t block_buf[ext2fs().block_size()];
-	ext2fs().read_block(singly_indirect_block, block_buf);
-	pointer_blocks.push_back(singly_indirect_block);
-	for(uint32_t i = 0; i < ext2fs().block_pointers_per_block && block_index < num_blocks(); i++) {
-		block_pointers.push_back(((uint32_t*)block_buf)[i]);
-		block_index++;
-	}
-}
-
-void Ext2Inode::read_doubly_indirect(uint32_t doubly_indirect_block, uint32_t& block_index) {
-	if(block_index >= num_blocks()) return;
-	uint8_t block_buf[ext2fs().block_size()];
-	ext2fs().read_block(doubly_indirect_block, block_buf);
-	pointer_blocks.push_back(doubly_indirect_block);
-	for(uint32_t i = 0; i < ext2fs().block_pointers_per_block && block_index < num_blocks(); i++)
-		read_singly_indirect(((uint32_t*)block_buf)[i], block_index);
-}
-
-void Ext2Inode::read_triply_indirect(uint32_t triply_indirect_block, uint32_t& block_index) {
-	if(block_index >= num_blocks()) return;
-	uint8_t block_buf[ext2fs().block_size()];
-	ext2fs().read_block(triply_indirect_block, block_buf);
-	pointer_blocks.push_back(triply_indirect_block);
-	for(uint32_t i = 0; i < ext2fs().block_pointers_per_block && block_index < num_blocks(); i++) {
-		read_doubly_indirect(((uint32_t*)block_buf)[i], block_index);
-	}
-}
-
-void Ext2Inode::read_block_pointers() {
-	LOCK(lock);
-
-	if(_metadata.is_symlink() && _metadata.size < 60) {
-		pointer_blocks = kstd::vector<uint32_t>();
-		block_pointers = kstd::vector<uint32_t>();
-		return;
-	}
-
-	uint8_t buf[ext2fs().block_size()];
-	block_pointers = kstd::vector<uint32_t>();
-	block_pointers.reserve(num_blocks());
-	pointer_blocks = kstd::vector<uint32_t>();
-
-	uint32_t block_index = 0;
-	while(block_index < 12 && block_index < num_blocks()) {
-		block_pointers.push_back(raw.block_pointers[block_index]);
-		block_index++;
-	}
-
-	read_singly_indirect(raw.s_pointer, block_index);
-	read_doubly_indirect(raw.d_pointer, block_index);
-	read_triply_indirect(raw.t_pointer, block_index);
-}
-
 Result Ext2Inode::write_to_disk() {
 	LOCK(lock);
 
-	Result res = write_block_pointers();
-	if(res.is_error())
-		return res;
-
-
-	res = write_inode_entry();
+	flush_indirect_blocks();
+	Result res = write_inode_entry();
 	if(res.is_error())
 		return res;
 
 	return Result(SUCCESS);
 }
 
-Result Ext2Inode::write_block_pointers() {
-	LOCK(lock);
-	if(_metadata.is_symlink() && _metadata.size < 60) return Result(SUCCESS);
-
-	pointer_blocks = kstd::vector<uint32_t>(0);
-	pointer_blocks.reserve(calculate_num_ptr_blocks(num_blocks()));
-
-	if(_metadata.is_device()) {
-		//TODO: Update device inode
-	} else {
-		for(uint32_t block_index = 0; block_index < 12; block_index++) {
-			raw.block_pointers[block_index] = get_block_pointer(block_index);
-		}
-	}
-
-	uint8_t block_buf[ext2fs().block_size()];
-
-	if(num_blocks() > 12) {
-		if (!raw.s_pointer) {
-			raw.s_pointer = ext2fs().allocate_block();
-			if (!raw.s_pointer) return Result(-ENOSPC); //Block allocation failed
-		}
-		pointer_blocks.push_back(raw.s_pointer);
-
-		//Write singly indirect block to disk
-		ext2fs().read_block(raw.s_pointer, block_buf);
-		for (uint32_t block_index = 12; block_index < 12 + ext2fs().block_pointers_per_block; block_index++) {
-			((uint32_t *) block_buf)[block_index - 12] = get_block_pointer(block_index);
-		}
-		ext2fs().write_block(raw.s_pointer, block_buf);
-	} else raw.s_pointer = 0;
-
-	if(num_blocks() > 12 + ext2fs().block_pointers_per_block) {
-		//Allocate doubly indirect block if needed and read
-		if(!raw.d_pointer) {
-			raw.d_pointer = ext2fs().allocate_block();
-			if(!raw.d_pointer) return Result(-ENOSPC); //Block allocation failed
-			ext2fs().read_block(raw.d_pointer, block_buf);
-			memset(block_buf, 0, ext2fs().block_size());
-		} else ext2fs().read_block(raw.d_pointer, block_buf);
-		pointer_blocks.push_back(raw.d_pointer);
-
-		uint8_t dblock_buf[ext2fs().block_size()];
-
-		uint32_t cur_block = 12 + ext2fs().block_pointers_per_block;
-		//For each block pointed to in the doubly indirect block,
-		for(uint32_t dindex = 0; dindex < ext2fs().block_pointers_per_block; dindex++) {
-			if(!get_block_pointer(cur_block)) break;
-
-			uint32_t dblock = ((uint32_t*)block_buf)[dindex];
-			//If the block isn't allocated, allocate it
-			if(!dblock) {
-				dblock = ext2fs().allocate_block();
-				((uint32_t*)block_buf)[dindex] = dblock;
-				if(!dblock) return Result(-ENOSPC); //Allocation failed
-			}
-			pointer_blocks.push_back(dblock);
-
-			//Update entries in the block and write to disk
-			ext2fs().read_block(dblock, dblock_buf);
-			for(uint32_t dblock_index = 0; dblock_index < ext2fs().block_size() / sizeof(uint32_t); dblock_index++) {
-				((uint32_t *) dblock_buf)[dblock_index] = get_block_pointer(cur_block);
-				cur_block++;
-			}
-			ext2fs().write_block(dblock, dblock_buf);
-		}
-
-		//Write doubly-indirect block to disk
-		ext2fs().write_block(raw.d_pointer, block_buf);
-	} else raw.d_pointer = 0;
-
-	if(num_blocks() > 12 + ext2fs().block_pointers_per_block * ext2fs().block_pointers_per_block) {
-		KLog::err("ext2", "Writing triply-indirect blocks to disk isn't supported yet!");
-		//TODO: Triply indirect blocks
-	} else raw.t_pointer = 0;
-
-	raw.logical_blocks = (block_pointers.size() + pointer_blocks.size()) * (ext2fs().block_size() / 512);
-	_dirty = true;
-	return Result(SUCCESS);
-}
-
 Result Ext2Inode::write_inode_entry() {
 	LOCK(lock);
 	uint8_t block_buf[ext2fs().block_size()];
@@ -650,6 +1260,11 @@ Result Ext2Inode::write_inode_entry() {
 Result Ext2Inode::write_directory_entries(kstd::vector<DirectoryEntry> &entries) {
 	LOCK(lock);
 
+	//The entries are about to move, and they're laid out linearly so any htree index won't be valid anymore either.
+	//Clearing the index flag leaves a valid but unindexed directory, which fsck can reindex if it's grown large.
+	invalidate_directory_index();
+	drop_htree();
+
 	//First, determine the new file size
 	size_t new_filesize = 0;
 	for(size_t i = 0; i < entries.size(); i++) {
@@ -781,34 +1396,26 @@ Result Ext2Inode::try_remove_dir() {
 	return Result(SUCCESS);
 }
 
-uint32_t Ext2Inode::calculate_num_ptr_blocks(uint32_t num_blocks) {
-	if(num_blocks <= 12) return 0;
-
-	uint32_t ret = 0;
-	uint32_t blocks_left = num_blocks - 12;
-
-	//Singly indirect blocks
-	blocks_left -= min(blocks_left, ext2fs().block_pointers_per_block);
-	ret += 1;
-	if(blocks_left == 0) return ret;
-
-	//Doubly indirect blocks
-	uint32_t dind_blocks = min(blocks_left, ext2fs().block_pointers_per_block * ext2fs().block_pointers_per_block);
-	blocks_left -= dind_blocks;
-	ret += 1 + (dind_blocks + ext2fs().block_pointers_per_block - 1) / ext2fs().block_pointers_per_block;
-	if(blocks_left == 0) return ret;
-
-	//TODO: Calculate triply indirect blocks
-	PANIC("EXT2_TIND", "We don't know how to calculate triply indirect blocks yet!");
-	return ret;
-}
-
 void Ext2Inode::open(FileDescriptor& fd, int options) {
-
+	if(!fd.writable())
+		return;
+	LOCK(lock);
+	_num_writers++;
 }
 
 void Ext2Inode::close(FileDescriptor& fd) {
+	if(!fd.writable())
+		return;
 
+	//Once the last writer is gone, the file is probably done being appended to, so give back the blocks we were holding
+	//on to for it.
+	LOCK(lock);
+	ASSERT(_num_writers);
+	if(--_num_writers)
+		return;
+	discard_preallocation();
+	flush_indirect_blocks();
+	release_indirect_blocks();
 }
 
 
@@ -22,6 +22,9 @@
 #include <kernel/filesystem/Inode.h>
 #include <kernel/kstd/vector.hpp>
 
+/** How many pointer blocks each inode caches. Enough to hold the whole path to a triply indirect block. **/
+#define EXT2_INDIRECT_CACHE_SIZE 3
+
 class Ext2Filesystem;
 class Ext2Inode: public Inode {
 public:
@@ -59,9 +62,12 @@ public:
 	size_t num_blocks();
 	Ext2Filesystem& ext2fs();
 
+	/** Looks up the block that holds the data at block_index in the file, or 0 if there isn't one. **/
 	uint32_t get_block_pointer(uint32_t block_index);
-	bool set_block_pointer(uint32_t block_index, uint32_t block);
-	kstd::vector<uint32_t>& get_block_pointers();
+	/** Maps block_index in the file to the given block, allocating any pointer blocks needed to do so. **/
+	Result set_block_pointer(uint32_t block_index, uint32_t block);
+	/** Returns the number of blocks starting at block_index that are contiguous on disk, looking at most max_bytes ahead. **/
+	size_t contiguous_blocks(uint32_t block_index, size_t max_bytes);
 	void free_all_blocks();
 
 	ssize_t read(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) override;
@@ -76,26 +82,110 @@ public:
 	Result chown(uid_t uid, gid_t gid) override;
 	void open(FileDescriptor& fd, int options) override;
 	void close(FileDescriptor& fd) override;
+	void readahead(size_t start, size_t length) override;
+	/** Writes back the inode's entry, its data and its pointer blocks, without touching the rest of the filesystem. **/
+	Result sync() override;
 
 private:
-	void read_singly_indirect(uint32_t singly_indirect_block, uint32_t& block_index);
-	void read_doubly_indirect(uint32_t doubly_indirect_block, uint32_t& block_index);
-	void read_triply_indirect(uint32_t triply_indirect_block, uint32_t& block_index);
-	void read_block_pointers();
+	/** A cached block of pointers from the block map. **/
+	struct IndirectBlock {
+		uint32_t block = 0;
+		uint32_t* pointers = nullptr;
+		bool dirty = false;
+		uint32_t last_used = 0;
+	};
+
+	//Block map
+	bool has_block_map();
+	/** Works out the indices into each level of pointer blocks that lead to a block, and returns how many levels there are. **/
+	unsigned block_path(uint32_t block_index, uint32_t offsets[3]);
+	/** The pointer in the inode to the top pointer block for blocks that are depth levels deep. **/
+	uint32_t* indirect_root(unsigned depth);
+	/** Returns the pointer at the given level of the path to a block, setting indirect to the pointer block it's in (if any). **/
+	uint32_t* pointer_to(unsigned depth, const uint32_t offsets[3], unsigned level, IndirectBlock*& indirect);
+	/** Gets a pointer block through the cache, evicting the least recently used one if needed. **/
+	IndirectBlock* indirect_block(uint32_t block);
+	void flush_indirect_blocks();
+	/** Writes back a pointer block that's depth levels above the data, along with the pointer blocks under it. **/
+	Result sync_pointer_blocks(uint32_t block, unsigned depth);
+	void release_indirect_blocks();
+	/** Unmaps every block from first_kept onwards and collects them (and any pointer blocks no longer needed) into freed. **/
+	void free_mapped_blocks(kstd::vector<uint32_t>& freed, uint32_t first_kept);
+	void free_mapped_blocks(uint32_t& pointer, unsigned depth, uint32_t first_index, uint32_t first_kept, kstd::vector<uint32_t>& freed);
+
 	Result write_to_disk();
-	Result write_block_pointers();
 	Result write_inode_entry();
+	/**
+	 * Rewrites the directory so it holds exactly the given entries, laid out linearly. This clears the directory's htree
+	 * flag, since the index would no longer match. An unindexed directory is still valid ext2, but it stays unindexed
+	 * until something like `e2fsck -D` rebuilds the index, since we never build htrees ourselves.
+	 */
 	Result write_directory_entries(kstd::vector<DirectoryEntry>& entries);
 	void create_metadata();
 	void reduce_hardlink_count();
 	void increase_hardlink_count();
 	Result try_remove_dir();
-	uint32_t calculate_num_ptr_blocks(uint32_t num_blocks);
 
-	kstd::vector<uint32_t> block_pointers;
-	kstd::vector<uint32_t> pointer_blocks;
+	//Block allocation
+	/** The block that a new block at block_index in the file should be allocated near. **/
+	uint32_t block_goal(uint32_t block_index);
+	/** Allocates blocks to go at block_index in the file, using up the preallocated blocks first. **/
+	ResultRet<kstd::vector<uint32_t>> allocate_data_blocks(uint32_t block_index, uint32_t num_blocks);
+	/** Allocates and maps blocks for part of a hole, zeroing the ones that the bytes from start to end don't fully cover. **/
+	Result fill_hole(uint32_t block_index, uint32_t num_blocks, size_t start, size_t end);
+	/** Frees the blocks preallocated for the file. **/
+	void discard_preallocation();
+
+	//Directory entries
+	/** Where a directory entry is. `block` points to a buffer holding the contents of the block it's in. **/
+	struct EntryLocation {
+		size_t block_index;
+		size_t offset;
+		uint8_t* block;
+	};
+
+	bool is_htree();
+	/**
+	 * Finds the entry with the given name in the directory.
+	 * @param buf A buffer big enough to hold two blocks.
+	 * @param htree_leaf If not null, set to the leaf the name belongs in if the directory's htree was used, or -1.
+	 */
+	bool locate_entry(const kstd::string& name, uint8_t* buf, EntryLocation& location, size_t* htree_leaf = nullptr);
+	/** Finds an entry using the directory's htree. If usable is set to false, the directory should be searched another way. **/
+	bool locate_entry_htree(const kstd::string& name, uint8_t* buf, bool& usable, EntryLocation& location, size_t* htree_leaf);
+	/** Finds an entry using the in-memory index of the directory, building it first if needed. **/
+	bool locate_entry_indexed(const kstd::string& name, uint8_t* buf, EntryLocation& location);
+	void build_directory_index(uint8_t* buf);
+	void add_to_directory_index(const kstd::string& name, size_t position);
+	void remove_from_directory_index(const kstd::string& name, size_t position);
+	void invalidate_directory_index();
+	/** Stops using the directory's htree once it can't be kept up to date, by clearing its index flag on disk. **/
+	void drop_htree();
+	/** Tries to fit a new entry into a block of the directory, splitting the slack off of an existing entry. **/
+	bool insert_in_block(size_t block_index, const kstd::string& name, ino_t inode, uint8_t type, uint8_t* buf);
+	Result insert_entry(const kstd::string& name, Inode& inode, uint8_t* buf);
+	Result erase_entry(const kstd::string& name, uint8_t* buf);
+
+	/** An entry in the in-memory index kept for large directories that don't have an htree. **/
+	struct DirectoryIndexEntry {
+		uint32_t hash;
+		uint32_t position; ///< The offset of the entry in the directory.
+		uint32_t next; ///< The next entry in the same bucket.
+	};
+
+	IndirectBlock _indirect_blocks[EXT2_INDIRECT_CACHE_SIZE];
+	uint32_t _indirect_clock = 0;
+	//The last run of physically contiguous blocks that was looked up
+	uint32_t _run_start = 0;
+	uint32_t _run_block = 0;
+	uint32_t _run_length = 0;
+	kstd::vector<uint32_t> _dir_index_buckets; ///< Empty if the in-memory directory index hasn't been built.
+	kstd::vector<DirectoryIndexEntry> _dir_index;
 
 	Raw raw;
 	bool _dirty = false;
+	uint32_t _prealloc_start = 0; ///< The first of the blocks reserved to be added to the end of the file.
+	uint32_t _prealloc_count = 0;
+	size_t _num_writers = 0; ///< The number of writable file descriptors open for the inode.
 };
 
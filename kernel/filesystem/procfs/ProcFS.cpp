@@ -40,16 +40,19 @@ ProcFS::ProcFS() {
 	entries.push_back(ProcFSEntry(RootMemInfo, 0));
 	entries.push_back(ProcFSEntry(RootUptime, 0));
 	entries.push_back(ProcFSEntry(RootCpuInfo, 0));
+	entries.push_back(ProcFSEntry(RootDiskStats, 0));
+	entries.push_back(ProcFSEntry(RootDentryStats, 0));
+	entries.push_back(ProcFSEntry(RootSocketStats, 0));
 
 	root_inode = kstd::make_shared<ProcFSInode>(*this, entries[0]);
 }
 
 ino_t ProcFS::id_for_entry(pid_t pid, ProcFSInodeType type) {
-	return (type & 0xFu) | ((unsigned)pid << 8u);
+	return (type & 0xFFu) | ((unsigned)pid << 8u);
 }
 
 ProcFSInodeType ProcFS::type_for_id(ino_t id) {
-	return static_cast<ProcFSInodeType>(id & 0xFu);
+	return static_cast<ProcFSInodeType>(id & 0xFFu);
 }
 
 pid_t ProcFS::pid_for_id(ino_t id) {
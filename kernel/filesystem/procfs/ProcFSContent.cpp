@@ -8,6 +8,8 @@
 #include <kernel/KernelMapper.h>
 #include <kernel/time/TimeManager.h>
 #include <kernel/device/DiskDevice.h>
+#include <kernel/filesystem/VFS.h>
+#include <kernel/filesystem/socketfs/SocketFSInode.h>
 
 ResultRet<kstd::string> ProcFSContent::mem_info() {
 	char numbuf[12];
@@ -40,6 +42,10 @@ ResultRet<kstd::string> ProcFSContent::mem_info() {
 	str += "\nkcache = ";
 	itoa((int) DiskDevice::used_cache_memory(), numbuf, 10);
 	str += numbuf;
+
+	str += "\nkdirty = ";
+	itoa((int) DiskDevice::dirty_cache_memory(), numbuf, 10);
+	str += numbuf;
 	str += "\n";
 
 	return str;
@@ -77,6 +83,141 @@ ResultRet<kstd::string> ProcFSContent::cpu_info() {
 	return str;
 }
 
+ResultRet<kstd::string> ProcFSContent::disk_stats() {
+	char numbuf[12];
+	kstd::string str;
+	DiskDevice::iterate_devices([&] (DiskDevice* device) -> kstd::IterationAction {
+		auto stats = device->stats();
+
+		str += "[";
+		itoa(device->major(), numbuf, 10);
+		str += numbuf;
+		str += ",";
+		itoa(device->minor(), numbuf, 10);
+		str += numbuf;
+
+		str += "]\nhits = ";
+		itoa((int) stats.hits, numbuf, 10);
+		str += numbuf;
+
+		str += "\nmisses = ";
+		itoa((int) stats.misses, numbuf, 10);
+		str += numbuf;
+
+		str += "\nevictions = ";
+		itoa((int) stats.evictions, numbuf, 10);
+		str += numbuf;
+
+		str += "\ncached = ";
+		itoa((int) (stats.cached_pages * PAGE_SIZE), numbuf, 10);
+		str += numbuf;
+
+		str += "\ndirty = ";
+		itoa((int) (stats.dirty_pages * PAGE_SIZE), numbuf, 10);
+		str += numbuf;
+
+		str += "\nreads = ";
+		itoa((int) stats.reads, numbuf, 10);
+		str += numbuf;
+
+		str += "\nwrites = ";
+		itoa((int) stats.writes, numbuf, 10);
+		str += numbuf;
+
+		str += "\nmerges = ";
+		itoa((int) stats.merges, numbuf, 10);
+		str += numbuf;
+
+		str += "\nqueue_depth = ";
+		itoa((int) stats.queue_depth, numbuf, 10);
+		str += numbuf;
+
+		str += "\nservice_ms = ";
+		itoa((int) (stats.service_time / 1000), numbuf, 10);
+		str += numbuf;
+		str += "\n";
+
+		return kstd::IterationAction::Continue;
+	});
+	return str;
+}
+
+ResultRet<kstd::string> ProcFSContent::dentry_stats() {
+	char numbuf[12];
+	kstd::string str;
+	auto stats = VFS::inst().dentry_cache().stats();
+
+	str += "[dentries]\nhits = ";
+	itoa((int) stats.hits, numbuf, 10);
+	str += numbuf;
+
+	str += "\nnegative_hits = ";
+	itoa((int) stats.negative_hits, numbuf, 10);
+	str += numbuf;
+
+	str += "\nmisses = ";
+	itoa((int) stats.misses, numbuf, 10);
+	str += numbuf;
+
+	str += "\nevictions = ";
+	itoa((int) stats.evictions, numbuf, 10);
+	str += numbuf;
+
+	str += "\nentries = ";
+	itoa((int) stats.entries, numbuf, 10);
+	str += numbuf;
+
+	str += "\nnegative_entries = ";
+	itoa((int) stats.negative_entries, numbuf, 10);
+	str += numbuf;
+	str += "\n";
+
+	return str;
+}
+
+ResultRet<kstd::string> ProcFSContent::socket_stats() {
+	char numbuf[12];
+	kstd::string str;
+	SocketFS::iterate_sockets([&] (SocketFSInode& socket) -> kstd::IterationAction {
+		auto stats = socket.stats();
+
+		str += "[";
+		str += socket.name;
+
+		str += "]\nclients = ";
+		itoa((int) stats.clients, numbuf, 10);
+		str += numbuf;
+
+		str += "\nqueued_packets = ";
+		itoa((int) stats.queued_packets, numbuf, 10);
+		str += numbuf;
+
+		str += "\nqueued_bytes = ";
+		itoa((int) stats.queued_bytes, numbuf, 10);
+		str += numbuf;
+
+		str += "\npackets_sent = ";
+		itoa((int) stats.packets_sent, numbuf, 10);
+		str += numbuf;
+
+		str += "\nbytes_sent = ";
+		itoa((int) stats.bytes_sent, numbuf, 10);
+		str += numbuf;
+
+		str += "\nbytes_read = ";
+		itoa((int) stats.bytes_read, numbuf, 10);
+		str += numbuf;
+
+		str += "\npackets_dropped = ";
+		itoa((int) stats.packets_dropped, numbuf, 10);
+		str += numbuf;
+		str += "\n";
+
+		return kstd::IterationAction::Continue;
+	});
+	return str;
+}
+
 ResultRet<kstd::string> ProcFSContent::status(pid_t pid) {
 	const char* PROC_STATE_NAMES[] = {"Running", "Zombie", "Dead", "Sleeping", "Stopped"};
 
@@ -122,6 +263,19 @@ ResultRet<kstd::string> ProcFSContent::status(pid_t pid) {
 	str += "\nshmem = ";
 	itoa(proc->used_shmem(), numbuf, 10);
 	str += numbuf;
+
+	auto resident = proc->resident_stats();
+	str += "\nrss = ";
+	itoa(resident.resident, numbuf, 10);
+	str += numbuf;
+
+	str += "\npss = ";
+	itoa(resident.proportional, numbuf, 10);
+	str += numbuf;
+
+	str += "\nrss_shared = ";
+	itoa(resident.shared, numbuf, 10);
+	str += numbuf;
 	str += "\n";
 
 	return str;
@@ -182,6 +336,15 @@ ResultRet<kstd::string> ProcFSContent::vmspace(pid_t pid) {
 		itoa(region->object_start(), numbuf, 16);
 		string += numbuf;
 
+		auto resident = region->object()->resident_stats(region->object_start() / PAGE_SIZE, region->size() / PAGE_SIZE);
+		string += "\t0x";
+		itoa(resident.resident, numbuf, 16);
+		string += numbuf;
+
+		string += "\t0x";
+		itoa(resident.proportional, numbuf, 16);
+		string += numbuf;
+
 		string += "\t";
 		auto prot = region->prot();
 		string += prot.read ? "r" : "-";
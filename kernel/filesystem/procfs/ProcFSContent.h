@@ -11,6 +11,9 @@ namespace ProcFSContent {
 	ResultRet<kstd::string> mem_info();
 	ResultRet<kstd::string> uptime();
 	ResultRet<kstd::string> cpu_info();
+	ResultRet<kstd::string> disk_stats();
+	ResultRet<kstd::string> dentry_stats();
+	ResultRet<kstd::string> socket_stats();
 	ResultRet<kstd::string> status(pid_t pid);
 	ResultRet<kstd::string> stacks(pid_t pid);
 	ResultRet<kstd::string> vmspace(pid_t pid);
@@ -75,6 +75,12 @@ ResultRet<kstd::string> ProcFSInode::get_string_contents() {
 			return ProcFSContent::uptime();
 		case RootCpuInfo:
 			return ProcFSContent::cpu_info();
+		case RootDiskStats:
+			return ProcFSContent::disk_stats();
+		case RootDentryStats:
+			return ProcFSContent::dentry_stats();
+		case RootSocketStats:
+			return ProcFSContent::socket_stats();
 		case ProcStatus:
 			return ProcFSContent::status(pid);
 		case ProcStacks:
@@ -31,6 +31,9 @@ enum ProcFSInodeType {
 	RootCmdLine,
 	RootUptime,
 	RootCpuInfo,
+	RootDiskStats,
+	RootDentryStats,
+	RootSocketStats,
 
 	//Process entries
 	ProcExe,
@@ -22,7 +22,10 @@
 #include "SocketFSInode.h"
 #include <kernel/tasking/Process.h>
 
+SocketFS* SocketFS::s_instance = nullptr;
+
 SocketFS::SocketFS() {
+	s_instance = this;
 	root_entry = kstd::make_shared<SocketFSInode>(*this, 1, "", 0777u | MODE_DIRECTORY, 0, 0);
 }
 
@@ -46,6 +49,14 @@ unsigned int SocketFS::client_hash(const void* fd_pointer) {
 	return hash;
 }
 
+void SocketFS::iterate_sockets(kstd::IterationFunc<SocketFSInode&> callback) {
+	if(!s_instance)
+		return;
+	LOCK(s_instance->lock);
+	for(auto& socket : s_instance->sockets)
+		ITER_BREAK(callback(*socket));
+}
+
 char* SocketFS::name() {
 	return "socketfs";
 }
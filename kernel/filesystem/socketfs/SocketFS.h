@@ -54,6 +54,8 @@ public:
 	static pid_t get_pid(ino_t inode);
 	static uint16_t get_fileno(ino_t inode);
 	static sockid_t client_hash(const void* fd_pointer);
+	/** Calls the callback for each socket in the mounted SocketFS, if there is one. **/
+	static void iterate_sockets(kstd::IterationFunc<SocketFSInode&> callback);
 
 	//Filesystem
 	char* name() override;
@@ -67,6 +69,9 @@ protected:
 	kstd::Arc<SocketFSInode> root_entry;
 	SpinLock lock;
 
+private:
+	static SocketFS* s_instance;
+
 };
 
 
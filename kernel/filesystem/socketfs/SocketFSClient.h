@@ -23,15 +23,37 @@
 #include <kernel/kstd/queue.hpp>
 #include <kernel/kstd/unix_types.h>
 #include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
+#include <kernel/memory/kliballoc.h>
+
+/**
+ * A packet waiting to be read from a socket, with its header and data in one contiguous buffer. It's refcounted so
+ * that a broadcast can queue the same buffer for every client instead of copying it for each of them.
+ */
+class SocketFSBuffer {
+public:
+	SocketFSBuffer(uint8_t* data, size_t size): _data(data), _size(size) {}
+	SocketFSBuffer(const SocketFSBuffer& other) = delete;
+	~SocketFSBuffer() { kfree(_data); }
+
+	const uint8_t* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	uint8_t* _data;
+	size_t _size;
+};
 
 class Process;
 class SocketFSClient {
 public:
-	explicit SocketFSClient(sockid_t id, pid_t pid): id(id), pid(pid), data_queue() {}
+	explicit SocketFSClient(sockid_t id, pid_t pid): id(id), pid(pid), packets() {}
 
 	sockid_t id;
 	pid_t pid;
-	kstd::queue<uint8_t> data_queue;
+	kstd::queue<kstd::Arc<SocketFSBuffer>> packets;
+	size_t read_offset = 0; ///< How much of the packet at the front of the queue has already been read.
+	size_t queued_bytes = 0; ///< How many bytes in the queue haven't been read yet.
 	SpinLock data_lock;
 	BooleanBlocker blocker;
 };
@@ -81,19 +81,25 @@ ssize_t SocketFSInode::read(size_t start, size_t length, SafePointer<uint8_t> bu
 
 	LOCK(reader->data_lock);
 
-	if(length > reader->data_queue.size())
-		length = reader->data_queue.size();
-
-	//Read into the buffer from the queue
-	auto& queue = reader->data_queue;
-	for(size_t i = 0; i < length; i++) {
-		buffer.set(i, queue.front());
-		queue.pop_front();
+	//Copy as much as we can out of each packet in the queue, picking up where the last read left off
+	size_t nread = 0;
+	while(nread < length && !reader->packets.empty()) {
+		auto& packet = reader->packets.front();
+		size_t to_copy = min(length - nread, packet->size() - reader->read_offset);
+		buffer.write(packet->data() + reader->read_offset, nread, to_copy);
+		nread += to_copy;
+		reader->read_offset += to_copy;
+		if(reader->read_offset == packet->size()) {
+			reader->packets.pop_front();
+			reader->read_offset = 0;
+		}
 	}
 
+	reader->queued_bytes -= nread;
+	m_bytes_read.add(nread);
 	reader->blocker.set_ready(true);
 
-	return length;
+	return nread;
 }
 
 ResultRet<kstd::Arc<LinkedInode>> SocketFSInode::resolve_link(const kstd::Arc<LinkedInode>& base, const User& user, kstd::Arc<LinkedInode>* parent_storage, int options, int recursion_level) {
@@ -118,9 +124,13 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 	if(!fd)
 		return -EINVAL;
 
+	if(length < sizeof(SocketFSPacket))
+		return -EINVAL;
 	auto packet = SafePointer<SocketFSPacket>(buf).get();
 	auto packet_data = SafePointer<uint8_t>(buf.raw() + sizeof(SocketFSPacket), buf.is_user());
 	bool is_broadcast = packet.type == SOCKETFS_TYPE_BROADCAST;
+	if(packet.length > length - sizeof(SocketFSPacket) || sizeof(SocketFSPacket) + packet.length > SOCKETFS_MAX_BUFFER_SIZE)
+		return -EINVAL;
 
 	//Find the client that the packet is coming from
 	auto sender = get_client(fd);
@@ -132,14 +142,17 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 	}
 
 	if(is_broadcast && sender == host) {
-		//If it's a broadcast, send it to all clients
+		//If it's a broadcast, send the same copy of it to all clients
+		auto buffer = make_packet(SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data);
+		if(buffer.is_error())
+			return buffer.code();
 		LOCK(m_clients_lock);
 		for(auto& client : m_clients) {
 			//Share shm with client if we need to
 			if(packet.shm_id)
 				TaskManager::current_process()->sys_shmallow(packet.shm_id, client->pid, packet.shm_perms);
 			//We don't care about errors here, we should just continue sending it to the rest of the clients
-			write_packet(client, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, fd->nonblock());
+			queue_packet(client, buffer.value(), fd->nonblock());
 		}
 		return SUCCESS;
 	} else if(sender == host) {
@@ -170,8 +183,10 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 	}
 
 	//Finally, write the packet to the correct queue
-	auto res = write_packet(recipient, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, fd->nonblock());
-	return res.code();
+	auto buffer = make_packet(SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data);
+	if(buffer.is_error())
+		return buffer.code();
+	return queue_packet(recipient, buffer.value(), fd->nonblock()).code();
 }
 
 Result SocketFSInode::add_entry(const kstd::string& add_name, Inode& inode) {
@@ -240,7 +255,9 @@ void SocketFSInode::open(FileDescriptor& fd, int options) {
 	//Add the client and send the connect message to the host
 	LOCK(m_clients_lock);
 	m_clients.push_back(kstd::Arc<SocketFSClient>::make(client_hash, fd.owner()));
-	write_packet(host, SOCKETFS_TYPE_MSG_CONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr), true);
+	auto packet = make_packet(SOCKETFS_TYPE_MSG_CONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr));
+	if(!packet.is_error())
+		queue_packet(host, packet.value(), true);
 }
 
 void SocketFSInode::close(FileDescriptor& fd) {
@@ -263,7 +280,9 @@ void SocketFSInode::close(FileDescriptor& fd) {
 	LOCK(m_clients_lock);
 	for(size_t i = 0; i < m_clients.size(); i++) {
 		if(client_hash == m_clients[i]->id) {
-			write_packet(host, SOCKETFS_TYPE_MSG_DISCONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr), true);
+			auto packet = make_packet(SOCKETFS_TYPE_MSG_DISCONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr));
+			if(!packet.is_error())
+				queue_packet(host, packet.value(), true);
 			m_clients.erase(i);
 			break;
 		}
@@ -273,40 +292,74 @@ void SocketFSInode::close(FileDescriptor& fd) {
 bool SocketFSInode::can_read(const FileDescriptor& fd) {
 	auto id = SocketFS::client_hash(&fd);
 	if(id == host->id)
-		return !host->data_queue.empty();
+		return !host->packets.empty();
 	for(auto& client : m_clients)
 		if(client->id == id)
-			return !client->data_queue.empty();
+			return !client->packets.empty();
 	return false;
 }
 
-Result SocketFSInode::write_packet(const kstd::Arc<SocketFSClient>& client, int type, sockid_t sender, size_t length, int shm_id, int shm_perms, SafePointer<uint8_t> buffer, bool nonblock) {
-	//If there's room in the buffer, block (if O_NONBLOCK isn't set)
-	while(sizeof(SocketFSPacket) + length + client->data_queue.size() > SOCKETFS_MAX_BUFFER_SIZE) {
-		if(!nonblock) {
-			client->blocker.set_ready(false);
-			TaskManager::current_thread()->block(client->blocker);
-			if(client->blocker.was_interrupted())
-				return Result(EINTR);
-		} else {
-			return Result(-ENOSPC);
-		}
-	}
+SocketFSInode::Stats SocketFSInode::stats() {
+	Stats ret = {
+		.clients = 0,
+		.queued_packets = 0,
+		.queued_bytes = 0,
+		.packets_sent = m_packets_sent.load(),
+		.bytes_sent = m_bytes_sent.load(),
+		.bytes_read = m_bytes_read.load(),
+		.packets_dropped = m_packets_dropped.load()
+	};
+
+	auto count_queue = [&](const kstd::Arc<SocketFSClient>& client) {
+		LOCK(client->data_lock);
+		ret.queued_packets += client->packets.size();
+		ret.queued_bytes += client->queued_bytes;
+	};
+
+	count_queue(host);
+	LOCK(m_clients_lock);
+	ret.clients = m_clients.size();
+	for(auto& client : m_clients)
+		count_queue(client);
+	return ret;
+}
 
-	//Acquire the lock
-	LOCK(client->data_lock);
+ResultRet<kstd::Arc<SocketFSBuffer>> SocketFSInode::make_packet(int type, sockid_t sender, size_t length, int shm_id, int shm_perms, SafePointer<uint8_t> data) {
+	auto* storage = (uint8_t*) kmalloc(sizeof(SocketFSPacket) + length);
+	if(!storage)
+		return Result(-ENOMEM);
 
-	//Write the packet header
-	SocketFSPacket packet_header = {type, sender, TaskManager::current_process()->pid(), length, shm_id, shm_perms};
-	auto* data = (const uint8_t*) &packet_header;
-	for(size_t i = 0; i < sizeof(SocketFSPacket); i++)
-		client->data_queue.push_back(*data++);
+	SocketFSPacket header = {type, sender, TaskManager::current_process()->pid(), length, shm_id, shm_perms};
+	memcpy(storage, &header, sizeof(SocketFSPacket));
+	if(length)
+		data.read(storage + sizeof(SocketFSPacket), length);
+	return kstd::Arc<SocketFSBuffer>::make(storage, sizeof(SocketFSPacket) + length);
+}
 
-	//Write the packet body
-	for(size_t i = 0; i < length; i++)
-		client->data_queue.push_back(buffer.get(i));
+Result SocketFSInode::queue_packet(const kstd::Arc<SocketFSClient>& client, const kstd::Arc<SocketFSBuffer>& packet, bool nonblock) {
+	while(true) {
+		{
+			LOCK(client->data_lock);
+			if(client->queued_bytes + packet->size() <= SOCKETFS_MAX_BUFFER_SIZE) {
+				client->packets.push_back(packet);
+				client->queued_bytes += packet->size();
+				m_packets_sent.add(1);
+				m_bytes_sent.add(packet->size());
+				return Result(SUCCESS);
+			}
 
-	return Result(SUCCESS);
+			//If there isn't room in the queue, wait for the client to read some of it (if O_NONBLOCK isn't set)
+			if(nonblock) {
+				m_packets_dropped.add(1);
+				return Result(-ENOSPC);
+			}
+			client->blocker.set_ready(false);
+		}
+
+		TaskManager::current_thread()->block(client->blocker);
+		if(client->blocker.was_interrupted())
+			return Result(-EINTR);
+	}
 }
 
 kstd::Arc<SocketFSClient> SocketFSInode::get_client(const FileDescriptor* fd) const {
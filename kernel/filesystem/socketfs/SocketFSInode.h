@@ -24,6 +24,7 @@
 #include <kernel/filesystem/Inode.h>
 #include <kernel/kstd/string.h>
 #include <kernel/filesystem/DirectoryEntry.h>
+#include <kernel/Atomic.h>
 
 #define SOCKETFS_CDIR_ENTRY_SIZE (sizeof(DirectoryEntry::id) + sizeof(DirectoryEntry::type) + sizeof(DirectoryEntry::name_length) + sizeof(char))
 #define SOCKETFS_PDIR_ENTRY_SIZE (sizeof(DirectoryEntry::id) + sizeof(DirectoryEntry::type) + sizeof(DirectoryEntry::name_length) + sizeof(char) * 2)
@@ -34,6 +35,16 @@ class LinkedInode;
 class InodeMetadata;
 class SocketFSInode: public Inode {
 public:
+	struct Stats {
+		size_t clients; ///< The number of clients connected to the socket.
+		size_t queued_packets; ///< The number of packets waiting to be read, across the host and all clients.
+		size_t queued_bytes; ///< The number of bytes waiting to be read, across the host and all clients.
+		size_t packets_sent; ///< The number of packets queued to be read. A broadcast counts once per recipient.
+		size_t bytes_sent; ///< The number of bytes queued to be read.
+		size_t bytes_read; ///< The number of bytes read out of the socket.
+		size_t packets_dropped; ///< The number of packets that couldn't be sent because the recipient's queue was full.
+	};
+
 	//SocketFSInode
 	SocketFSInode(SocketFS& fs, ino_t id, const kstd::string& name, mode_t mode, uid_t uid, gid_t gid);
 	~SocketFSInode();
@@ -55,12 +66,17 @@ public:
 	void close(FileDescriptor& fd) override;
 	bool can_read(const FileDescriptor& fd) override;
 
+	Stats stats();
+
 	SocketFS& fs;
 	ino_t id;
 	kstd::string name;
 
 private:
-	Result write_packet(const kstd::Arc<SocketFSClient>& recipient, int type, sockid_t sender, size_t size, int shm_id, int shm_perms, SafePointer<uint8_t> buffer, bool nonblock);
+	/** Makes a buffer holding a packet's header and its data, copying the data in with one memcpy. **/
+	static ResultRet<kstd::Arc<SocketFSBuffer>> make_packet(int type, sockid_t sender, size_t length, int shm_id, int shm_perms, SafePointer<uint8_t> data);
+	/** Queues a packet for a client, waiting for there to be room in its queue unless nonblock is set. **/
+	Result queue_packet(const kstd::Arc<SocketFSClient>& recipient, const kstd::Arc<SocketFSBuffer>& packet, bool nonblock);
 
 	[[nodiscard]] kstd::Arc<SocketFSClient> get_client(const FileDescriptor* fd) const;
 
@@ -70,6 +86,11 @@ private:
 	kstd::Arc<SocketFSClient> host;
 	DirectoryEntry dir_entry;
 	bool is_open = true;
+
+	Atomic<size_t, MemoryOrder::SeqCst> m_packets_sent = 0;
+	Atomic<size_t, MemoryOrder::SeqCst> m_bytes_sent = 0;
+	Atomic<size_t, MemoryOrder::SeqCst> m_bytes_read = 0;
+	Atomic<size_t, MemoryOrder::SeqCst> m_packets_dropped = 0;
 };
 
 
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "TmpFS.h"
+#include "TmpFSInode.h"
+#include <kernel/filesystem/InodeMetadata.h>
+#include <kernel/memory/Memory.h>
+
+TmpFS::TmpFS(size_t max_size): _max_pages(max_size / PAGE_SIZE) {
+	auto root = kstd::make_shared<TmpFSInode>(*this, 1, MODE_DIRECTORY | 01777u, 0, 0);
+	_inodes.insert({1, root});
+}
+
+kstd::Arc<TmpFSInode> TmpFS::create_inode(mode_t mode, uid_t uid, gid_t gid) {
+	LOCK(_lock);
+	auto inode = kstd::make_shared<TmpFSInode>(*this, _next_id++, mode, uid, gid);
+	_inodes.insert({inode->id, inode});
+	return inode;
+}
+
+void TmpFS::remove_inode(ino_t id) {
+	LOCK(_lock);
+	_inodes.erase(id);
+}
+
+Result TmpFS::reserve_pages(size_t num_pages) {
+	LOCK(_lock);
+	if(num_pages > _max_pages - _used_pages)
+		return Result(-ENOSPC);
+	_used_pages += num_pages;
+	return Result(SUCCESS);
+}
+
+void TmpFS::release_pages(size_t num_pages) {
+	LOCK(_lock);
+	_used_pages -= min(num_pages, _used_pages);
+}
+
+char* TmpFS::name() {
+	return "tmpfs";
+}
+
+ResultRet<kstd::Arc<Inode>> TmpFS::get_inode(ino_t id) {
+	LOCK(_lock);
+	auto node = _inodes.find_node(id);
+	if(!node)
+		return Result(-ENOENT);
+	return static_cast<kstd::Arc<Inode>>(node->data.second);
+}
+
+ino_t TmpFS::root_inode_id() {
+	return 1;
+}
+
+uint8_t TmpFS::fsid() {
+	return TMPFS_FSID;
+}
+
+bool TmpFS::can_cache_dentries() {
+	return true;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/filesystem/Filesystem.h>
+#include <kernel/kstd/map.hpp>
+#include <kernel/tasking/SpinLock.h>
+
+#define TMPFS_FSID 5
+
+class TmpFSInode;
+
+/**
+ * A filesystem that keeps everything in memory. The data of each file lives in the pages of an anonymous VMObject,
+ * which shared mappings of the file map directly.
+ */
+class TmpFS: public Filesystem {
+public:
+	/** @param max_size The most memory, in bytes, that the files in the filesystem can take up. **/
+	explicit TmpFS(size_t max_size);
+
+	/** Creates an inode that isn't linked into any directory yet. **/
+	kstd::Arc<TmpFSInode> create_inode(mode_t mode, uid_t uid, gid_t gid);
+	/** Forgets about an inode once it isn't linked anywhere. It stays around until nothing has it open anymore. **/
+	void remove_inode(ino_t id);
+
+	/** Reserves room for the given number of pages of file data, failing with ENOSPC if that would go over the limit. **/
+	Result reserve_pages(size_t num_pages);
+	void release_pages(size_t num_pages);
+
+	//Filesystem
+	char* name() override;
+	ResultRet<kstd::Arc<Inode>> get_inode(ino_t id) override;
+	ino_t root_inode_id() override;
+	uint8_t fsid() override;
+	bool can_cache_dentries() override;
+
+private:
+	kstd::map<ino_t, kstd::Arc<TmpFSInode>> _inodes;
+	ino_t _next_id = 2;
+	size_t _max_pages;
+	size_t _used_pages = 0;
+	SpinLock _lock;
+};
@@ -0,0 +1,359 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "TmpFSInode.h"
+#include "TmpFS.h"
+#include <kernel/filesystem/DirectoryEntry.h>
+#include <kernel/memory/AnonymousVMObject.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/kstd/utility.h>
+
+static uint8_t entry_type(mode_t mode) {
+	switch(mode & 0xF000u) {
+		case MODE_FILE:
+			return TYPE_FILE;
+		case MODE_DIRECTORY:
+			return TYPE_DIR;
+		case MODE_CHAR_DEVICE:
+			return TYPE_CHARACTER_DEVICE;
+		case MODE_BLOCK_DEVICE:
+			return TYPE_BLOCK_DEVICE;
+		case MODE_FIFO:
+			return TYPE_FIFO;
+		case MODE_SOCKET:
+			return TYPE_SOCKET;
+		case MODE_SYMLINK:
+			return TYPE_SYMLINK;
+		default:
+			return TYPE_UNKNOWN;
+	}
+}
+
+TmpFSInode::TmpFSInode(TmpFS& fs, ino_t id, mode_t mode, uid_t uid, gid_t gid): Inode(fs, id), _parent(id) {
+	_metadata.mode = mode;
+	_metadata.uid = uid;
+	_metadata.gid = gid;
+	_metadata.size = 0;
+	_metadata.inode_id = id;
+	_metadata.dev_major = 0;
+	_metadata.dev_minor = 0;
+}
+
+TmpFSInode::~TmpFSInode() {
+	tmpfs().release_pages(_charged_pages);
+}
+
+TmpFS& TmpFSInode::tmpfs() {
+	return (TmpFS&) fs;
+}
+
+ino_t TmpFSInode::find_id(const kstd::string& name) {
+	if(!_metadata.is_directory())
+		return 0;
+	if(name == ".")
+		return id;
+	if(name == "..")
+		return _parent;
+
+	LOCK(lock);
+	int index = find_entry(name);
+	return index < 0 ? 0 : _entries[index].id;
+}
+
+ssize_t TmpFSInode::read(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) {
+	if(_metadata.is_directory())
+		return -EISDIR;
+
+	LOCK(lock);
+	if(start >= _metadata.size)
+		return 0;
+	if(start + length > _metadata.size)
+		length = _metadata.size - start;
+
+	size_t nread = 0;
+	while(nread < length) {
+		size_t page_offset = (start + nread) % PAGE_SIZE;
+		size_t to_copy = min(PAGE_SIZE - page_offset, length - nread);
+		copy_page((start + nread) / PAGE_SIZE, page_offset, to_copy, SafePointer<uint8_t>(buffer.raw() + nread, buffer.is_user()), false);
+		nread += to_copy;
+	}
+
+	return nread;
+}
+
+ssize_t TmpFSInode::write(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) {
+	if(_metadata.is_directory())
+		return -EISDIR;
+	if(length == 0)
+		return 0;
+
+	LOCK(lock);
+	if(start + length > _metadata.size) {
+		auto res = truncate((off_t) (start + length));
+		if(res.is_error())
+			return res.code();
+	}
+
+	size_t nwritten = 0;
+	while(nwritten < length) {
+		size_t page = (start + nwritten) / PAGE_SIZE;
+		size_t page_offset = (start + nwritten) % PAGE_SIZE;
+		size_t to_copy = min(PAGE_SIZE - page_offset, length - nwritten);
+		if(!_data->physical_page_index(page)) {
+			//Pages are charged against the limit as they're allocated, unless a mapping of the file already paid for them
+			if(_data->resident_pages() >= _charged_pages) {
+				if(tmpfs().reserve_pages(1).is_error())
+					return nwritten ? nwritten : -ENOSPC;
+				_charged_pages++;
+			}
+			if(_data->alloc_page_if_needed(page).is_error())
+				return nwritten ? nwritten : -ENOMEM;
+		}
+		copy_page(page, page_offset, to_copy, SafePointer<uint8_t>(buffer.raw() + nwritten, buffer.is_user()), true);
+		nwritten += to_copy;
+	}
+
+	return nwritten;
+}
+
+void TmpFSInode::iterate_entries(kstd::IterationFunc<const DirectoryEntry&> callback) {
+	if(!_metadata.is_directory())
+		return;
+
+	LOCK(lock);
+	ITER_RET(callback(DirectoryEntry(id, TYPE_DIR, ".")));
+	ITER_RET(callback(DirectoryEntry(_parent, TYPE_DIR, "..")));
+	for(auto& entry : _entries)
+		ITER_BREAK(callback(DirectoryEntry(entry.id, entry.type, entry.name)));
+}
+
+Result TmpFSInode::add_entry(const kstd::string& name, Inode& inode) {
+	if(!_metadata.is_directory()) return Result(-ENOTDIR);
+	if(&inode.fs != &fs) return Result(-EXDEV);
+	if(!name.length() || name.length() >= NAME_MAXLEN) return Result(-ENAMETOOLONG);
+
+	LOCK(lock);
+	if(name == "." || name == ".." || find_entry(name) >= 0)
+		return Result(-EEXIST);
+
+	auto& tmp_inode = (TmpFSInode&) inode;
+	_entries.push_back({name, inode.id, entry_type(inode.metadata().mode)});
+	tmp_inode._links++;
+	if(inode.metadata().is_directory())
+		tmp_inode._parent = id;
+
+	return Result(SUCCESS);
+}
+
+ResultRet<kstd::Arc<Inode>> TmpFSInode::create_entry(const kstd::string& name, mode_t mode, uid_t uid, gid_t gid) {
+	if(!_metadata.is_directory()) return Result(-ENOTDIR);
+
+	LOCK(lock);
+	auto inode = tmpfs().create_inode(mode, uid, gid);
+	auto res = add_entry(name, *inode);
+	if(res.is_error()) {
+		tmpfs().remove_inode(inode->id);
+		return res;
+	}
+
+	return static_cast<kstd::Arc<Inode>>(inode);
+}
+
+Result TmpFSInode::remove_entry(const kstd::string& name) {
+	if(!_metadata.is_directory()) return Result(-ENOTDIR);
+
+	LOCK(lock);
+	int index = find_entry(name);
+	if(index < 0)
+		return Result(-ENOENT);
+
+	auto inode_or_err = tmpfs().get_inode(_entries[index].id);
+	if(inode_or_err.is_error())
+		return inode_or_err.result();
+	auto inode = kstd::static_pointer_cast<TmpFSInode>(inode_or_err.value());
+
+	LOCK_N(inode->lock, inode_locker);
+	if(inode->_metadata.is_directory() && !inode->_entries.empty())
+		return Result(-ENOTEMPTY);
+
+	_entries.erase(index);
+	if(!--inode->_links)
+		tmpfs().remove_inode(inode->id);
+
+	return Result(SUCCESS);
+}
+
+Result TmpFSInode::truncate(off_t length) {
+	if(length < 0) return Result(-EINVAL);
+	if(_metadata.is_directory()) return Result(-EISDIR);
+
+	LOCK(lock);
+	size_t old_pages = kstd::ceil_div(_metadata.size, PAGE_SIZE);
+	size_t new_pages = kstd::ceil_div((size_t) length, PAGE_SIZE);
+
+	if(new_pages > old_pages) {
+		auto res = ensure_data();
+		if(res.is_error())
+			return res;
+
+		//Mappings can fault in any page of the object without going through write(), so they're paid for up front
+		if(_data->map_count()) {
+			res = charge_pages(max(new_pages, _data->size() / PAGE_SIZE));
+			if(res.is_error())
+				return res;
+		}
+
+		//New pages are only allocated once they're written to. The object may already be big enough if it was
+		//shrunk while it was mapped.
+		if(_data->size() < new_pages * PAGE_SIZE)
+			_data->resize(new_pages * PAGE_SIZE);
+	} else if((size_t) length < _metadata.size) {
+		//Pages past the end can only be freed if nothing has them mapped. Otherwise (and for the rest of the last
+		//page), what's cut off gets zeroed so that it reads as zeroes if the file grows again.
+		if(_data && !_data->map_count() && new_pages * PAGE_SIZE < _data->size()) {
+			//The object is always at least a page long, so emptying the file just drops its pages
+			if(new_pages)
+				_data->resize(new_pages * PAGE_SIZE);
+			else
+				_data->discard_pages(0, _data->size() / PAGE_SIZE);
+		}
+		zero_range(length, _metadata.size);
+		uncharge_unused_pages();
+	}
+
+	_metadata.size = length;
+	return Result(SUCCESS);
+}
+
+Result TmpFSInode::chmod(mode_t mode) {
+	LOCK(lock);
+	_metadata.mode = mode;
+	return Result(SUCCESS);
+}
+
+Result TmpFSInode::chown(uid_t uid, gid_t gid) {
+	LOCK(lock);
+	_metadata.uid = uid;
+	_metadata.gid = gid;
+	return Result(SUCCESS);
+}
+
+void TmpFSInode::open(FileDescriptor& fd, int options) {
+
+}
+
+void TmpFSInode::close(FileDescriptor& fd) {
+
+}
+
+ResultRet<kstd::Arc<VMObject>> TmpFSInode::data_vm_object() {
+	if(!_metadata.is_simple_file())
+		return kstd::Arc<VMObject>(nullptr);
+
+	//Every shared mapping has to use the same object as read() and write(), even if the file is still empty
+	LOCK(lock);
+	auto res = ensure_data();
+	if(res.is_error())
+		return res;
+
+	//The mapping can fault in any page of the object without going through write(), so pay for them up front
+	res = charge_pages(_data->size() / PAGE_SIZE);
+	if(res.is_error())
+		return res;
+	return kstd::static_pointer_cast<VMObject>(_data);
+}
+
+Result TmpFSInode::ensure_data() {
+	if(_data)
+		return Result(SUCCESS);
+
+	auto data_or_err = AnonymousVMObject::alloc(PAGE_SIZE, "tmpfs");
+	if(data_or_err.is_error())
+		return Result(-ENOMEM);
+	_data = data_or_err.value();
+	_data->set_fork_action(VMObject::ForkAction::Share);
+
+	//Pages are only allocated once they're written to, including the one the object starts out with
+	_data->discard_pages(0, 1);
+	size_t num_pages = kstd::ceil_div(_metadata.size, PAGE_SIZE);
+	if(num_pages > 1)
+		_data->resize(num_pages * PAGE_SIZE);
+	return Result(SUCCESS);
+}
+
+Result TmpFSInode::charge_pages(size_t num_pages) {
+	if(num_pages <= _charged_pages)
+		return Result(SUCCESS);
+	auto res = tmpfs().reserve_pages(num_pages - _charged_pages);
+	if(res.is_error())
+		return res;
+	_charged_pages = num_pages;
+	return Result(SUCCESS);
+}
+
+void TmpFSInode::uncharge_unused_pages() {
+	if(_data && _data->map_count())
+		return;
+	size_t allocated = _data ? _data->resident_pages() : 0;
+	if(_charged_pages > allocated) {
+		tmpfs().release_pages(_charged_pages - allocated);
+		_charged_pages = allocated;
+	}
+}
+
+int TmpFSInode::find_entry(const kstd::string& name) {
+	for(size_t i = 0; i < _entries.size(); i++) {
+		if(_entries[i].name == name)
+			return (int) i;
+	}
+	return -1;
+}
+
+void TmpFSInode::copy_page(size_t page, size_t offset, size_t length, SafePointer<uint8_t> buffer, bool to_page) {
+	PageIndex page_index = _data ? _data->physical_page_index(page) : 0;
+	if(!page_index) {
+		ASSERT(!to_page);
+		buffer.memset(0, 0, length);
+		return;
+	}
+
+	//Copying to or from userspace could fault while the page is quickmapped, so that goes through a buffer instead
+	if(buffer.is_user()) {
+		uint8_t bounce_buf[PAGE_SIZE];
+		if(to_page) {
+			buffer.read(bounce_buf, length);
+			MM.with_quickmapped(page_index, [&](void* mapped) {
+				memcpy((uint8_t*) mapped + offset, bounce_buf, length);
+			});
+		} else {
+			MM.with_quickmapped(page_index, [&](void* mapped) {
+				memcpy(bounce_buf, (uint8_t*) mapped + offset, length);
+			});
+			buffer.write(bounce_buf, length);
+		}
+	} else {
+		MM.with_quickmapped(page_index, [&](void* mapped) {
+			if(to_page)
+				buffer.read((uint8_t*) mapped + offset, length);
+			else
+				buffer.write((uint8_t*) mapped + offset, length);
+		});
+	}
+}
+
+void TmpFSInode::zero_range(size_t start, size_t end) {
+	if(!_data)
+		return;
+	end = min(end, _data->size());
+	while(start < end) {
+		size_t page_offset = start % PAGE_SIZE;
+		size_t to_zero = min(PAGE_SIZE - page_offset, end - start);
+		PageIndex page_index = _data->physical_page_index(start / PAGE_SIZE);
+		if(page_index) {
+			MM.with_quickmapped(page_index, [&](void* mapped) {
+				memset((uint8_t*) mapped + page_offset, 0, to_zero);
+			});
+		}
+		start += to_zero;
+	}
+}
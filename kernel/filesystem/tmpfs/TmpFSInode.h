@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include <kernel/filesystem/Inode.h>
+#include <kernel/kstd/vector.hpp>
+
+class TmpFS;
+class AnonymousVMObject;
+
+class TmpFSInode: public Inode {
+public:
+	TmpFSInode(TmpFS& fs, ino_t id, mode_t mode, uid_t uid, gid_t gid);
+	~TmpFSInode() override;
+
+	//Inode
+	ino_t find_id(const kstd::string& name) override;
+	ssize_t read(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) override;
+	ssize_t write(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) override;
+	void iterate_entries(kstd::IterationFunc<const DirectoryEntry&> callback) override;
+	Result add_entry(const kstd::string& name, Inode& inode) override;
+	ResultRet<kstd::Arc<Inode>> create_entry(const kstd::string& name, mode_t mode, uid_t uid, gid_t gid) override;
+	Result remove_entry(const kstd::string& name) override;
+	Result truncate(off_t length) override;
+	Result chmod(mode_t mode) override;
+	Result chown(uid_t uid, gid_t gid) override;
+	void open(FileDescriptor& fd, int options) override;
+	void close(FileDescriptor& fd) override;
+	ResultRet<kstd::Arc<VMObject>> data_vm_object() override;
+
+private:
+	struct Entry {
+		kstd::string name;
+		ino_t id;
+		uint8_t type;
+	};
+
+	TmpFS& tmpfs();
+	/** Finds the index of the entry with the given name in the directory, or -1 if there isn't one. **/
+	int find_entry(const kstd::string& name);
+	/** Copies between part of a page of the file and a buffer. Pages that haven't been written to read as zeroes. **/
+	void copy_page(size_t page, size_t offset, size_t length, SafePointer<uint8_t> buffer, bool to_page);
+	/** Zeroes the part of the file's data from start to end that has pages. **/
+	void zero_range(size_t start, size_t end);
+	/** Allocates the object the file's data lives in if it hasn't been yet. **/
+	Result ensure_data();
+	/** Makes sure at least num_pages pages are charged against the filesystem's limit. **/
+	Result charge_pages(size_t num_pages);
+	/** Gives back the pages charged against the filesystem's limit that aren't allocated, unless the file is mapped. **/
+	void uncharge_unused_pages();
+
+	kstd::Arc<AnonymousVMObject> _data; ///< Allocated once the file has something in it or is mapped.
+	size_t _charged_pages = 0; ///< The pages charged against the filesystem's limit. At least the number allocated.
+	kstd::vector<Entry> _entries;
+	ino_t _parent;
+	size_t _links = 0;
+};
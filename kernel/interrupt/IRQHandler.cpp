@@ -18,6 +18,7 @@
 */
 
 #include <kernel/kstd/kstdio.h>
+#include <kernel/kstd/KLog.h>
 #include "IRQHandler.h"
 #include "irq.h"
 
@@ -35,7 +36,7 @@ bool IRQHandler::sent_eoi() {
 }
 
 IRQHandler::IRQHandler(int irq): _irq(irq) {
-	Interrupt::irq_set_handler(irq, this);
+	reinstall_irq();
 }
 
 void IRQHandler::set_irq(int irq) {
@@ -43,12 +44,13 @@ void IRQHandler::set_irq(int irq) {
 }
 
 void IRQHandler::uninstall_irq() {
-	Interrupt::irq_set_handler(_irq, nullptr);
+	Interrupt::irq_remove_handler(_irq, this);
 }
 
 void IRQHandler::reinstall_irq() {
 	if(!_irq) return;
-	Interrupt::irq_set_handler(_irq, this);
+	if(Interrupt::irq_add_handler(_irq, this).is_error())
+		KLog::err("IRQ", "Couldn't install handler for IRQ %d, since too many devices share it", _irq);
 }
 
 bool IRQHandler::mark_in_irq() {
@@ -56,6 +58,9 @@ bool IRQHandler::mark_in_irq() {
 }
 
 void IRQHandler::send_eoi() {
+	//Other handlers on a shared line may not have run yet, so the dispatcher sends the EOI once they all have
+	if(Interrupt::irq_is_shared(_irq))
+		return;
 	Interrupt::send_eoi(_irq);
 	_sent_eoi = true;
 }
@@ -25,16 +25,31 @@
 #include "interrupt.h"
 
 namespace Interrupt {
-	IRQHandler* handlers[16] = {nullptr};
+	IRQHandler* handlers[16][IRQ_MAX_HANDLERS] = {{nullptr}};
 
 	volatile bool _in_interrupt = false;
 
-	void irq_set_handler(int irq, IRQHandler* handler){
-		handlers[irq] = handler;
+	Result irq_add_handler(int irq, IRQHandler* handler){
+		TaskManager::ScopedCritical critical;
+		IRQHandler** free_entry = nullptr;
+		for(auto& entry : handlers[irq]) {
+			if(entry == handler)
+				return Result(SUCCESS);
+			if(!entry && !free_entry)
+				free_entry = &entry;
+		}
+		if(!free_entry)
+			return Result(-EBUSY);
+		*free_entry = handler;
+		return Result(SUCCESS);
 	}
 
-	void irq_remove_handler(int irq){
-		handlers[irq] = nullptr;
+	void irq_remove_handler(int irq, IRQHandler* handler){
+		TaskManager::ScopedCritical critical;
+		for(auto& entry : handlers[irq]) {
+			if(entry == handler)
+				entry = nullptr;
+		}
 	}
 
 	void irq_remap(){
@@ -80,18 +95,35 @@ namespace Interrupt {
 		idt_set_gate(47, (unsigned)irq15, 0x08, 0x8E);
 	}
 
-	void irq_handler(struct Registers *r){
-		auto handler = handlers[r->num - 0x20];
-		if(handler) {
-			//Mark that we're in an interrupt so that yield will be async if it occurs
-			_in_interrupt = handler->mark_in_irq();
+	bool irq_is_shared(int irq) {
+		size_t num_handlers = 0;
+		for(auto handler : handlers[irq]) {
+			if(handler)
+				num_handlers++;
+		}
+		return num_handlers > 1;
+	}
 
-			//Handle the IRQ
+	void irq_handler(struct Registers *r){
+		//Mark that we're in an interrupt so that yield will be async if it occurs. This stays set until the EOI, which
+		//handlers on a shared line leave to us so that it isn't sent before every handler has run.
+		auto& line_handlers = handlers[r->num - 0x20];
+		bool mark_in_irq = false;
+		for(auto handler : line_handlers)
+			mark_in_irq |= handler && handler->mark_in_irq();
+		_in_interrupt = mark_in_irq;
+
+		//Give every handler on the line a chance to handle the IRQ, since any of the devices sharing it could have raised it
+		bool sent_eoi = false;
+		for(auto handler : line_handlers) {
+			if(!handler)
+				continue;
 			handler->handle(r);
+			sent_eoi |= handler->sent_eoi();
 		}
 
 		//Send EOI if we haven't already
-		if(!handler || !handler->sent_eoi())
+		if(!sent_eoi)
 			send_eoi(r->num - 0x20);
 
 		//If we need to yield asynchronously after the interrupt because we called TaskManager::yield() during it, do so
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <kernel/Result.hpp>
+
 #define PIC1 0x20
 #define PIC2 0xA0
 #define PIC1_COMMAND PIC1
@@ -26,6 +28,9 @@
 #define PIC2_COMMAND PIC2
 #define PIC2_DATA (PIC2+1)
 
+/** The maximum number of handlers that can share an IRQ. **/
+#define IRQ_MAX_HANDLERS 4
+
 class IRQHandler;
 
 namespace Interrupt {
@@ -47,8 +52,14 @@ namespace Interrupt {
 	extern "C" void irq15();
 	extern "C" void irq_handler(struct Registers *r);
 
-	void irq_set_handler(int irq, IRQHandler* handler);
-	void irq_remove_handler(int irq);
+	/**
+	 * Adds a handler for an IRQ. PCI devices can share IRQ lines, so each IRQ can have a few handlers.
+	 * @return EBUSY if the IRQ already has IRQ_MAX_HANDLERS handlers.
+	 */
+	Result irq_add_handler(int irq, IRQHandler* handler);
+	void irq_remove_handler(int irq, IRQHandler* handler);
+	/** Whether more than one handler is installed for an IRQ. **/
+	bool irq_is_shared(int irq);
 	void irq_remap();
 	void irq_init();
 	bool in_irq();
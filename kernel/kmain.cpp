@@ -33,6 +33,9 @@
 #include <kernel/tasking/Process.h>
 #include <kernel/tasking/Thread.h>
 #include <kernel/device/PATADevice.h>
+#include <kernel/device/AHCIController.h>
+#include <kernel/device/AHCIDevice.h>
+#include <kernel/device/VirtIOBlockDevice.h>
 #include <kernel/terminal/VirtualTTY.h>
 #include <kernel/filesystem/ext2/Ext2Filesystem.h>
 #include <kernel/device/PartitionDevice.h>
@@ -42,6 +45,7 @@
 #include <kernel/filesystem/VFS.h>
 #include <kernel/filesystem/ptyfs/PTYFS.h>
 #include <kernel/filesystem/socketfs/SocketFS.h>
+#include <kernel/filesystem/tmpfs/TmpFS.h>
 #include <kernel/KernelMapper.h>
 #include <kernel/tasking/ProcessArgs.h>
 #include <kernel/kstd/KLog.h>
@@ -126,14 +130,23 @@ void kmain_late(){
 
 	KLog::dbg("kinit", "Initializing disk...");
 
-	//Setup the disk (Assumes we're using primary master drive
-	auto disk = kstd::Arc<PATADevice>(PATADevice::find(
-					PATADevice::PRIMARY,
-					PATADevice::MASTER,
-					CommandLine::inst().has_option("use_pio") //Use PIO if the command line option is present
-				));
+	//Setup the disk (Assumes we're using the virtio-blk disk if there is one, then the first SATA disk if there's an
+	//AHCI controller, and then the primary master IDE drive)
+	kstd::Arc<DiskDevice> disk;
+	AHCIController* ahci = nullptr;
+	if(auto* virtio_disk = VirtIOBlockDevice::find()) {
+		disk = (kstd::Arc<DiskDevice>) virtio_disk->shared_ptr();
+	} else if((ahci = AHCIController::find()) && !ahci->disks().empty()) {
+		disk = ahci->disks()[0];
+	} else {
+		disk = kstd::Arc<PATADevice>(PATADevice::find(
+			PATADevice::PRIMARY,
+			PATADevice::MASTER,
+			CommandLine::inst().has_option("use_pio") //Use PIO if the command line option is present
+		));
+	}
 	if(!disk) {
-		KLog::crit("kinit", "Couldn't find IDE controller! Hanging...");
+		KLog::crit("kinit", "Couldn't find a disk! Hanging...");
 		while(1);
 	}
 
@@ -219,6 +232,20 @@ void kmain_late(){
 		while(true);
 	}
 
+	//Mount TmpFS, which can use up to half of memory unless the command line gives a size in MiB
+	auto tmp_or_err = VFS::inst().resolve_path("/tmp", VFS::inst().root_ref(), root_user);
+	if(tmp_or_err.is_error()) {
+		KLog::warn("kinit", "Failed to mount tmp: %d", tmp_or_err.code());
+	} else {
+		size_t tmpfs_size = MM.usable_mem() / 2;
+		auto& tmpfs_size_option = CommandLine::inst().get_option_value("tmpfs-size");
+		if(tmpfs_size_option.length())
+			tmpfs_size = (size_t) atoi(tmpfs_size_option.c_str()) * 1024 * 1024;
+		res = VFS::inst().mount(new TmpFS(tmpfs_size), tmp_or_err.value());
+		if(res.is_error())
+			KLog::warn("kinit", "Failed to mount tmp: %d", res.code());
+	}
+
 	//Load the kernel symbols
 	KernelMapper::load_map();
 
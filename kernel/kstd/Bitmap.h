@@ -62,6 +62,27 @@ namespace kstd {
 			memset(m_bits, value ? (~0) : 0, (m_num_bits + 7) / 8);
 		}
 
+		/** Resizes the bitmap, keeping the existing bits. Newly added bits are cleared. **/
+		void resize(size_t num_bits) {
+			size_t old_num_bits = m_num_bits;
+			size_t copy_bytes = ((num_bits < old_num_bits ? num_bits : old_num_bits) + 7) / 8;
+			size_t new_bytes = (num_bits + 7) / 8;
+			auto* new_bits = (uint8_t*) kmalloc(new_bytes);
+			memset(new_bits, 0, new_bytes);
+			if(m_bits) {
+				memcpy(new_bits, m_bits, copy_bytes);
+				kfree(m_bits);
+			}
+			m_bits = new_bits;
+			m_num_bits = num_bits;
+
+			// The last copied byte may contain stale bits past the old end
+			for(size_t i = old_num_bits; i < num_bits && i < copy_bytes * 8; i++)
+				set(i, false);
+		}
+
+		size_t size() const { return m_num_bits; }
+
 	private:
 		uint8_t* m_bits = nullptr;
 		size_t m_num_bits;
@@ -3,92 +3,192 @@
 
 #pragma once
 
-#include "map.hpp"
-#include "vector.hpp"
 #include "pair.hpp"
 #include "../Result.hpp"
 #include "Optional.h"
+#include "../memory/kliballoc.h"
 
 namespace kstd {
+	/**
+	 * A cache that keeps track of the order in which its items were used, so the least recently used ones can be
+	 * evicted first. Items are kept in a hash table and threaded onto an intrusive doubly linked list in order of use,
+	 * so lookups, insertions, promotions and removals are all O(1). Keys must be integers.
+	 */
 	template<typename Key, typename Value>
 	class LRUCache {
 	public:
 		LRUCache() = default;
+		LRUCache(const LRUCache& other) = delete;
+
+		~LRUCache() {
+			prune(m_size);
+			if(m_buckets)
+				kfree(m_buckets);
+		}
 
 		/** Insert the item with the given key and value, replacing it if it exists. **/
 		void insert(Key key, Value value) {
-			auto node = m_map.get(key);
+			auto node = find_node(key);
 			if(node) {
-				*node = value;
-				promote(key);
-			} else {
-				m_map.insert({key, value});
-				m_lru_list.push_back(key);
+				node->value = value;
+				move_to_back(node);
+				return;
 			}
+
+			if(m_size + 1 > m_num_buckets * max_load_factor)
+				rehash(m_num_buckets ? m_num_buckets * 2 : initial_buckets);
+
+			node = new Node {key, value};
+			auto& bucket = m_buckets[bucket_for(key)];
+			node->bucket_next = bucket;
+			bucket = node;
+			link_back(node);
+			m_size++;
 		}
 
 		/** Removes the item with the given key if it exists. **/
 		void erase(Key key) {
-			m_map.erase(key);
-			for(size_t i = 0; i < m_lru_list.size(); i++) {
-				if(m_lru_list[i] == key) {
-					m_lru_list.erase(i);
+			if(!m_buckets)
+				return;
+			auto* link = &m_buckets[bucket_for(key)];
+			while(*link) {
+				auto node = *link;
+				if(node->key == key) {
+					*link = node->bucket_next;
+					unlink(node);
+					delete node;
+					m_size--;
 					return;
 				}
+				link = &node->bucket_next;
 			}
 		}
 
 		/** Promote the item with the given key, if in the list, to be most recently used. **/
 		void promote(Key key) {
-			bool found = false;
-			for(size_t i = 0; i < m_lru_list.size(); i++) {
-				if(m_lru_list[i] == key) {
-					m_lru_list.erase(i);
-					found = true;
-					break;
-				}
-			}
-
-			if(found)
-				m_lru_list.push_back(key);
+			auto node = find_node(key);
+			if(node)
+				move_to_back(node);
 		}
 
 		/** Gets the item with the given key **/
 		kstd::Optional<Value> get(Key key) {
-			auto item = m_map.get(key);
-			if(item) {
-				promote(key);
-				return *item;
+			auto node = find_node(key);
+			if(node) {
+				move_to_back(node);
+				return node->value;
 			}
 			return kstd::nullopt;
 		}
 
+		/** Returns whether an item with the given key is in the cache, without promoting it. **/
+		bool contains(Key key) const {
+			return find_node(key);
+		}
+
 		/** Prunes a number of items from the cache. **/
 		void prune(size_t num) {
-			while(!m_lru_list.empty() && num--) {
-				m_map.erase(m_lru_list[0]);
-				m_lru_list.erase(0);
-			}
+			while(m_lru_head && num--)
+				erase(m_lru_head->key);
 		}
 
 		/** Returns the least recently used item. **/
 		kstd::Optional<kstd::pair<Key, Value&>> lru() {
 			if(empty())
 				return kstd::nullopt;
-			return kstd::pair<Key, Value&> {m_lru_list[0], m_map[m_lru_list[0]]};
+			return kstd::pair<Key, Value&> {m_lru_head->key, m_lru_head->value};
 		}
 
 		/** Returns the least recently used item without wrapping in an optional. **/
 		kstd::pair<Key, Value&> lru_unsafe() {
 			ASSERT(!empty());
-			return kstd::pair<Key, Value&> {m_lru_list[0], m_map[m_lru_list[0]]};
+			return kstd::pair<Key, Value&> {m_lru_head->key, m_lru_head->value};
 		}
 
-		[[nodiscard]] size_t size() const { return m_lru_list.size(); }
-		[[nodiscard]] bool empty() const { return m_lru_list.empty(); }
+		[[nodiscard]] size_t size() const { return m_size; }
+		[[nodiscard]] bool empty() const { return m_size == 0; }
 
 	private:
-		kstd::map<Key, Value> m_map;
-		kstd::vector<Key> m_lru_list;
+		struct Node {
+			Key key;
+			Value value;
+			Node* bucket_next = nullptr;
+			Node* lru_prev = nullptr;
+			Node* lru_next = nullptr;
+		};
+
+		static constexpr size_t initial_buckets = 64;
+		static constexpr size_t max_load_factor = 2;
+
+		inline size_t bucket_for(Key key) const {
+			auto hash = (size_t) key;
+			hash ^= hash >> 16;
+			hash *= 0x45d9f3b;
+			hash ^= hash >> 16;
+			return hash & (m_num_buckets - 1);
+		}
+
+		Node* find_node(Key key) const {
+			if(!m_buckets)
+				return nullptr;
+			auto node = m_buckets[bucket_for(key)];
+			while(node && node->key != key)
+				node = node->bucket_next;
+			return node;
+		}
+
+		void rehash(size_t num_buckets) {
+			auto new_buckets = (Node**) kcalloc(num_buckets, sizeof(Node*));
+			auto old_buckets = m_buckets;
+			auto old_num_buckets = m_num_buckets;
+			m_buckets = new_buckets;
+			m_num_buckets = num_buckets;
+			for(size_t i = 0; i < old_num_buckets; i++) {
+				auto node = old_buckets[i];
+				while(node) {
+					auto next = node->bucket_next;
+					auto& bucket = m_buckets[bucket_for(node->key)];
+					node->bucket_next = bucket;
+					bucket = node;
+					node = next;
+				}
+			}
+			if(old_buckets)
+				kfree(old_buckets);
+		}
+
+		void link_back(Node* node) {
+			node->lru_next = nullptr;
+			node->lru_prev = m_lru_tail;
+			if(m_lru_tail)
+				m_lru_tail->lru_next = node;
+			else
+				m_lru_head = node;
+			m_lru_tail = node;
+		}
+
+		void unlink(Node* node) {
+			if(node->lru_prev)
+				node->lru_prev->lru_next = node->lru_next;
+			else
+				m_lru_head = node->lru_next;
+			if(node->lru_next)
+				node->lru_next->lru_prev = node->lru_prev;
+			else
+				m_lru_tail = node->lru_prev;
+		}
+
+		void move_to_back(Node* node) {
+			if(node == m_lru_tail)
+				return;
+			unlink(node);
+			link_back(node);
+		}
+
+		Node** m_buckets = nullptr;
+		size_t m_num_buckets = 0;
+		size_t m_size = 0;
+		Node* m_lru_head = nullptr; ///< The least recently used item.
+		Node* m_lru_tail = nullptr; ///< The most recently used item.
 	};
-}
\ No newline at end of file
+}
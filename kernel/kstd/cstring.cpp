@@ -68,6 +68,16 @@ extern "C" void* memmove(void* dest, const void* src, size_t n) {
 	return dest;
 }
 
+extern "C" int memcmp(const void* a, const void* b, size_t count) {
+	const uint8_t* a8 = (const uint8_t*) a;
+	const uint8_t* b8 = (const uint8_t*) b;
+	for(size_t i = 0; i < count; i++) {
+		if(a8[i] != b8[i])
+			return a8[i] < b8[i] ? -1 : 1;
+	}
+	return 0;
+}
+
 void* memcpy_uint32(uint32_t* d, uint32_t* s, size_t n) {
 	void* od = d;
 	asm volatile("rep movsl\n" : "+S"(s), "+D"(d), "+c"(n)::"memory");
@@ -27,6 +27,7 @@ char *strcat(char *dest, const char *src);
 bool strcmp(const char *str1, const char *str2);
 extern "C" void *memset(void *dest, int val, size_t count);
 extern "C" void *memcpy(void *dest, const void *src, size_t count);
+extern "C" int memcmp(const void* a, const void* b, size_t count);
 void* memcpy_uint32(uint32_t* d, uint32_t* s, size_t n);
 int strlen(const char *str);
 void substr(int i, char *src, char *dest);
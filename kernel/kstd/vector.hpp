@@ -64,6 +64,19 @@ namespace kstd {
 			new (&_storage[_size++]) T(elem);
 		}
 
+		void insert(size_t index, const T& elem) {
+			ASSERT(index <= _size);
+			if(_size + 1 > _capacity) {
+				realloc(_capacity == 0 ? 1 : _capacity * 2);
+			}
+			for(size_t i = _size; i > index; i--) {
+				new(&_storage[i]) T(_storage[i - 1]);
+				_storage[i - 1].~T();
+			}
+			new (&_storage[index]) T(elem);
+			_size++;
+		}
+
 		void resize(size_t new_size) {
 			if(_size == new_size) return;
 			if(new_size > _capacity) realloc(new_size);
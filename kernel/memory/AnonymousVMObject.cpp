@@ -25,6 +25,11 @@ ResultRet<kstd::Arc<AnonymousVMObject>> AnonymousVMObject::alloc(size_t size, ks
 	return object;
 }
 
+ResultRet<kstd::Arc<AnonymousVMObject>> AnonymousVMObject::alloc_lazy(size_t size, kstd::string name) {
+	kstd::vector<PageIndex> pages(kstd::ceil_div(size, PAGE_SIZE), 0);
+	return kstd::Arc<AnonymousVMObject>(new AnonymousVMObject(name, kstd::move(pages), false));
+}
+
 ResultRet<kstd::Arc<AnonymousVMObject>> AnonymousVMObject::alloc_contiguous(size_t size, kstd::string name) {
 	size_t num_pages = kstd::ceil_div(size, PAGE_SIZE);
 	auto pages = TRY(MemoryManager::inst().alloc_contiguous_physical_pages(num_pages));
@@ -89,6 +94,52 @@ ResultRet<VMProt> AnonymousVMObject::get_shared_permissions(pid_t pid) {
 	return node->data.second;
 }
 
+ResultRet<bool> AnonymousVMObject::alloc_page_if_needed(size_t index) {
+	LOCK(m_page_lock);
+	if(index >= m_physical_pages.size())
+		return Result(ERANGE);
+	if(m_physical_pages[index])
+		return false;
+
+	auto new_page = TRY(MM.alloc_physical_page());
+	MM.with_quickmapped(new_page, [&](void* buf) {
+		memset(buf, 0, PAGE_SIZE);
+	});
+	m_physical_pages[index] = new_page;
+	m_cow_pages.set(index, false);
+	m_resident_pages.add(1);
+
+	return true;
+}
+
+void AnonymousVMObject::discard_pages(size_t start_index, size_t num_pages) {
+	LOCK(m_page_lock);
+	ASSERT(!is_shared());
+	size_t end_index = min(start_index + num_pages, m_physical_pages.size());
+	for(size_t i = start_index; i < end_index; i++) {
+		if(!m_physical_pages[i])
+			continue;
+		MM.get_physical_page(m_physical_pages[i]).unref();
+		m_physical_pages[i] = 0;
+		m_cow_pages.set(i, false);
+		m_resident_pages.sub(1);
+	}
+}
+
+void AnonymousVMObject::resize(size_t new_size) {
+	LOCK(m_page_lock);
+	size_t new_num_pages = kstd::ceil_div(new_size, PAGE_SIZE);
+	for(size_t i = new_num_pages; i < m_physical_pages.size(); i++) {
+		if(!m_physical_pages[i])
+			continue;
+		MM.get_physical_page(m_physical_pages[i]).unref();
+		m_resident_pages.sub(1);
+	}
+	m_physical_pages.resize(new_num_pages);
+	m_cow_pages.resize(new_num_pages);
+	m_size = new_num_pages * PAGE_SIZE;
+}
+
 ResultRet<kstd::Arc<VMObject>> AnonymousVMObject::clone() {
 	LOCK(m_page_lock);
 	ASSERT(!is_shared());
@@ -22,6 +22,14 @@ public:
 	 */
 	static ResultRet<kstd::Arc<AnonymousVMObject>> alloc(size_t size, kstd::string name = "anonymous");
 
+	/**
+	 * Allocates a new anonymous VMObject without allocating any physical pages for it. Pages are allocated and
+	 * zero-filled when they're first accessed, which may fail if there's no memory left by then.
+	 * @param size The minimum size, in bytes, of the object.
+	 * @return The newly allocated object, if successful.
+	 */
+	static ResultRet<kstd::Arc<AnonymousVMObject>> alloc_lazy(size_t size, kstd::string name = "anonymous");
+
 	/**
 	 * Allocates a new anonymous VMObject backed by contiguous physical pages.
 	 * @param size The minimum size, in bytes, of the object.
@@ -64,6 +72,29 @@ public:
 	 */
 	void set_fork_action(ForkAction action) { m_fork_action = action; }
 
+	/**
+	 * Allocates a zeroed page at the given index if the page there was discarded.
+	 * @param index The index of the page to allocate.
+	 * @return A successful result if the index is in range and could be allocated. True if allocated, false if already exists.
+	 */
+	ResultRet<bool> alloc_page_if_needed(size_t index);
+
+	/**
+	 * Releases the physical pages in the given range of the object. They will be replaced with zeroed pages when
+	 * they are next accessed. Regions mapping the object must be unmapped in the given range beforehand.
+	 * @param start_index The index of the first page to discard.
+	 * @param num_pages The number of pages to discard.
+	 */
+	void discard_pages(size_t start_index, size_t num_pages);
+
+	/**
+	 * Resizes the object. New pages are zero-filled when they are first accessed, and pages past the new end are
+	 * released. The object may be grown while it's mapped elsewhere, since everything that looks at its pages does so
+	 * under its page lock, but regions mapping the object must not extend past the new end.
+	 * @param new_size The new size of the object, in bytes. Will be rounded up to a page boundary.
+	 */
+	void resize(size_t new_size);
+
 	bool is_shared() const { return m_is_shared; }
 	pid_t shared_owner() const { return m_shared_owner; }
 	int shm_id() const { return m_shm_id; }
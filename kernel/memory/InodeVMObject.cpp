@@ -41,6 +41,7 @@ ResultRet<bool> InodeVMObject::read_page_if_needed(size_t index) {
 		return Result(-nread);
 	}
 	m_physical_pages[index] = new_page;
+	m_resident_pages.add(1);
 
 	return true;
 }
@@ -14,11 +14,6 @@ public:
 
 	static kstd::Arc<InodeVMObject> make_for_inode(kstd::string name, kstd::Arc<Inode> inode, Type type);
 
-
-	PageIndex& physical_page_index(size_t index) const {
-		return m_physical_pages[index];
-	};
-
 	/**
 	 * Reads in the page at the given index if it isn't allocated yet.
 	 * @param index The index of the page to read in.
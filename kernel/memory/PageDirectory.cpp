@@ -156,6 +156,8 @@ void PageDirectory::map(VMRegion& region, VirtualRange range) {
 	ASSERT(range.size % PAGE_SIZE == 0);
 	ASSERT(range.start + range.size <= region.end());
 
+	//The object could be resized from another address space, so keep its pages from changing while we map them
+	LOCK_N(region.object()->page_lock(), object_lock);
 	for(size_t page_index = start_index; page_index < end_index; page_index++) {
 		auto& page = region.object()->physical_page(page_index + page_offset);
 		if(!page.index())
@@ -10,11 +10,12 @@ VMObject::VMObject(kstd::string name, kstd::vector<PageIndex> physical_pages, bo
 	m_cow_pages(m_physical_pages.size()),
 	m_size(m_physical_pages.size() * PAGE_SIZE)
 {
-	if(all_cow) {
-		for(size_t i = 0; i < m_physical_pages.size(); i++) {
-			if(m_physical_pages[i])
-				m_cow_pages.set(i, true);
-		}
+	for(size_t i = 0; i < m_physical_pages.size(); i++) {
+		if(!m_physical_pages[i])
+			continue;
+		m_resident_pages.add(1);
+		if(all_cow)
+			m_cow_pages.set(i, true);
 	}
 }
 
@@ -25,12 +26,25 @@ VMObject::~VMObject() {
 }
 
 PhysicalPage& VMObject::physical_page(size_t index) const {
-	return MemoryManager::inst().get_physical_page(m_physical_pages[index]);
+	return MemoryManager::inst().get_physical_page(physical_page_index(index));
+}
+
+PageIndex VMObject::physical_page_index(size_t index) const {
+	LOCK(m_page_lock);
+	if(index >= m_physical_pages.size())
+		return 0;
+	return m_physical_pages[index];
+}
+
+bool VMObject::page_is_cow(PageIndex page) const {
+	LOCK(m_page_lock);
+	return page < m_physical_pages.size() && m_cow_pages.get(page);
 }
 
 Result VMObject::try_cow_page(PageIndex page) {
-	ASSERT(page < m_physical_pages.size());
 	LOCK(m_page_lock);
+	if(page >= m_physical_pages.size())
+		return Result(EINVAL);
 
 	// If the page isn't CoW, don't proceed
 	if(!page_is_cow(page))
@@ -56,6 +70,27 @@ ResultRet<kstd::Arc<VMObject>> VMObject::clone() {
 	ASSERT(false);
 }
 
+VMObject::ResidentStats VMObject::resident_stats(size_t start_page, size_t num_pages) {
+	ResidentStats stats;
+	// Lazily-allocated objects often have nothing resident at all, so there's no need to look through their pages
+	if(!m_resident_pages.load())
+		return stats;
+
+	LOCK(m_page_lock);
+	size_t num_maps = max(m_map_count.load(), (size_t) 1);
+	size_t end_page = min(start_page + num_pages, m_physical_pages.size());
+	for(size_t i = start_page; i < end_page; i++) {
+		if(!m_physical_pages[i])
+			continue;
+		size_t sharers = max(physical_page(i).allocated.ref_count.load(), (uint16_t) 1) * num_maps;
+		stats.resident += PAGE_SIZE;
+		stats.proportional += PAGE_SIZE / sharers;
+		if(sharers > 1)
+			stats.shared += PAGE_SIZE;
+	}
+	return stats;
+}
+
 void VMObject::become_cow_and_ref_pages() {
 	LOCK(m_page_lock);
 	for(size_t i = 0; i < m_physical_pages.size(); i++) {
@@ -23,6 +23,13 @@ public:
 		BecomeCoW, Share, Ignore
 	};
 
+	/** Memory usage statistics for a range of an object, in bytes. **/
+	struct ResidentStats {
+		size_t resident = 0; ///< Memory that is actually backed by physical pages.
+		size_t shared = 0; ///< Resident memory whose pages are also mapped elsewhere.
+		size_t proportional = 0; ///< Resident memory, with each page divided evenly between everyone mapping it.
+	};
+
 	explicit VMObject(kstd::string name,  kstd::vector<PageIndex> physical_pages, bool all_cow = false);
 	VMObject(const VMObject& other) = delete;
 	virtual ~VMObject();
@@ -32,19 +39,40 @@ public:
 
 	kstd::string name() const { return m_name; }
 	size_t size() const { return m_size; }
-	/** Gets the physical page at the given index in the object. **/
+	/** Gets the physical page at the given index in the object, or physical page 0 if there isn't one. **/
 	virtual PhysicalPage& physical_page(size_t index) const;
+	/** Gets the index of the physical page at the given index in the object, or 0 if there isn't one. **/
+	PageIndex physical_page_index(size_t index) const;
 	/** What the object should do when a memory space containing it is forked. **/
 	virtual ForkAction fork_action() const { return ForkAction::Share; }
 
 	/** Tries to copy the page at a given index if it is marked CoW. If it is not, EINVAL is returned. **/
 	Result try_cow_page(PageIndex page);
 	/** Returns whether a page in the object is marked CoW. **/
-	bool page_is_cow(PageIndex page) const { return m_cow_pages.get(page); };
+	bool page_is_cow(PageIndex page) const;
+	/**
+	 * The lock held whenever the object's pages are changed. Anonymous objects can also be resized while they're mapped
+	 * elsewhere, so it must be held to look at several pages at once.
+	 */
+	SpinLock& page_lock() const { return m_page_lock; }
 	/** Clones this VMObject using all the same physical pages and properties. **/
 	virtual ResultRet<kstd::Arc<VMObject>> clone();
 
+	/** The number of pages in the object that are backed by physical memory. **/
+	size_t resident_pages() const { return m_resident_pages.load(); }
+	/** The number of VMRegions the object is currently mapped by. **/
+	size_t map_count() const { return m_map_count.load(); }
+	/**
+	 * Calculates how much of a range of the object is resident, and how much of that is shared. A page is considered
+	 * shared between each object referencing its physical page and each region mapping those objects.
+	 * @param start_page The index of the first page of the range.
+	 * @param num_pages The number of pages in the range.
+	 */
+	ResidentStats resident_stats(size_t start_page, size_t num_pages);
+
 protected:
+	friend class VMRegion;
+
 	/** Marks every page in this object as CoW, and increases the reference count of all pages by 1. **/
 	void become_cow_and_ref_pages();
 
@@ -52,5 +80,7 @@ protected:
 	kstd::vector<PageIndex> m_physical_pages;
 	kstd::Bitmap m_cow_pages;
 	size_t m_size;
-	SpinLock m_page_lock;
+	Atomic<size_t, MemoryOrder::SeqCst> m_resident_pages = 0;
+	Atomic<size_t, MemoryOrder::SeqCst> m_map_count = 0;
+	mutable SpinLock m_page_lock;
 };
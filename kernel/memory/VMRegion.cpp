@@ -35,10 +35,11 @@ VMRegion::VMRegion(kstd::Arc<VMObject> object, kstd::Arc<VMSpace> space, Virtual
 	m_object_start(object_start),
 	m_prot(prot)
 {
-
+	m_object->m_map_count.add(1);
 }
 
 VMRegion::~VMRegion() {
+	m_object->m_map_count.sub(1);
 	m_space.with_locked([&](const kstd::Arc<VMSpace>& space) {
 		auto unmap_res = space->unmap_region(*this);
 		ASSERT(unmap_res.is_success());
@@ -47,4 +48,15 @@ VMRegion::~VMRegion() {
 
 void VMRegion::set_prot(VMProt prot) {
 	m_prot = prot;
-}
\ No newline at end of file
+}
+
+size_t VMRegion::fault_around_pages() const {
+	switch(m_access) {
+		case Access::Random:
+			return 1;
+		case Access::Sequential:
+			return 16;
+		default:
+			return 4;
+	}
+}
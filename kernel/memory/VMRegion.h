@@ -24,6 +24,11 @@ class VMSpace;
  */
 class VMRegion: public kstd::ArcSelf<VMRegion> {
 public:
+	/** How the region is expected to be accessed. Used to decide how many pages to fault in at once. **/
+	enum class Access {
+		Normal, Random, Sequential
+	};
+
 	/**
 	 * Creates a new virtual memory region.
 	 * @param object The VMObject that this region corresponds to.
@@ -43,6 +48,13 @@ public:
 	bool contains(VirtualAddress address) const { return m_range.contains(address); }
 	VMProt prot() const { return m_prot; }
 	void set_prot(VMProt prot);
+	Access access() const { return m_access; }
+	void set_access(Access access) { m_access = access; }
+	bool is_locked() const { return m_locked; }
+	void set_locked(bool locked) { m_locked = locked; }
+
+	/** The number of pages that should be read in when a fault occurs in the region. **/
+	size_t fault_around_pages() const;
 
 private:
 	friend class VMSpace;
@@ -51,4 +63,6 @@ private:
 	VirtualRange m_range; /// Where in the VMSpace this region resides.
 	size_t m_object_start; /// Where in the VMObject this region begins.
 	VMProt m_prot; /// The protection of this region.
+	Access m_access = Access::Normal; /// The expected access pattern of this region.
+	bool m_locked = false; /// Whether the pages of this region are pinned in memory.
 };
@@ -71,6 +71,7 @@ kstd::Arc<VMSpace> VMSpace::fork(PageDirectory& page_directory, kstd::vector<kst
 							new_space,
 							region->range(), region->object_start(),
 							region->prot());
+					new_vmRegion->set_access(region->access());
 					page_directory.map(*new_vmRegion);
 					new_region->vmRegion = new_vmRegion.get();
 					regions_vec.push_back(new_vmRegion);
@@ -243,19 +244,36 @@ Result VMSpace::try_pagefault(PageFault fault) {
 					}
 
 					// Or, we may have encountered a race where the page was created by another thread after the fault.
-					m_page_directory.map(*vmRegion, VirtualRange { inode_page * PAGE_SIZE, PAGE_SIZE });
+					m_page_directory.map(*vmRegion, VirtualRange { error_page * PAGE_SIZE, PAGE_SIZE });
 					return Result(SUCCESS);
 				}
 
-				// Otherwise, read in the page and map it
-				auto did_read = TRY(inode_object->read_page_if_needed(inode_page));
+				// Otherwise, read in the page along with the pages after it that we expect to be accessed soon
+				TRY(populate_page(*vmRegion, error_page));
 				ASSERT(inode_object->physical_page_index(inode_page));
-				if(did_read)
-					m_page_directory.map(*vmRegion, VirtualRange { error_page * PAGE_SIZE, PAGE_SIZE });
+				size_t num_pages = min(vmRegion->fault_around_pages(), vmRegion->size() / PAGE_SIZE - error_page);
+				for(size_t i = 1; i < num_pages; i++) {
+					if(populate_page(*vmRegion, error_page + i).is_error())
+						break;
+				}
 
 				return Result(SUCCESS);
 			}
 
+			// Allocate a zeroed page if the page was discarded.
+			if(vmRegion->object()->is_anonymous()) {
+				auto did_alloc = TRY(populate_page(*vmRegion, error_page));
+				if(did_alloc)
+					return Result(SUCCESS);
+
+				// The page may have been allocated through another mapping of the object, so it just needs mapping here.
+				PageIndex object_page = error_page + (vmRegion->object_start() / PAGE_SIZE);
+				if(!vmRegion->object()->page_is_cow(object_page)) {
+					m_page_directory.map(*vmRegion, VirtualRange { error_page * PAGE_SIZE, PAGE_SIZE });
+					return Result(SUCCESS);
+				}
+			}
+
 			// CoW if the region is writeable.
 			if(vmRegion->prot().write) {
 				auto result = vmRegion->m_object->try_cow_page(error_page);
@@ -272,6 +290,115 @@ Result VMSpace::try_pagefault(PageFault fault) {
 	return Result(ENOENT);
 }
 
+Result VMSpace::populate_region(VMRegion& region, VirtualRange range) {
+	ASSERT(range.start % PAGE_SIZE == 0);
+	ASSERT(range.size % PAGE_SIZE == 0);
+	ASSERT(range.start + range.size <= region.size());
+	LOCK(m_lock);
+	for(PageIndex page = range.start / PAGE_SIZE; page < range.end() / PAGE_SIZE; page++) {
+		auto res = populate_page(region, page);
+		if(res.is_error())
+			return res.result();
+	}
+	return Result(SUCCESS);
+}
+
+Result VMSpace::discard_region(VMRegion& region, VirtualRange range) {
+	ASSERT(range.start % PAGE_SIZE == 0);
+	ASSERT(range.size % PAGE_SIZE == 0);
+	ASSERT(range.start + range.size <= region.size());
+	LOCK(m_lock);
+	if(region.is_locked())
+		return Result(EINVAL);
+
+	// Only private anonymous pages can be thrown away, since nobody else can be looking at them.
+	if(!region.object()->is_anonymous() || region.object()->fork_action() != VMObject::ForkAction::BecomeCoW)
+		return Result(EINVAL);
+	auto anon_object = kstd::static_pointer_cast<AnonymousVMObject>(region.object());
+	if(anon_object->is_shared())
+		return Result(EINVAL);
+
+	m_page_directory.unmap(region, range);
+	anon_object->discard_pages((region.object_start() + range.start) / PAGE_SIZE, range.size / PAGE_SIZE);
+	return Result(SUCCESS);
+}
+
+Result VMSpace::resize_region(VMRegion& region, size_t new_size) {
+	ASSERT(new_size % PAGE_SIZE == 0);
+	if(!new_size || region.object_start() + new_size > region.object()->size())
+		return Result(EINVAL);
+
+	// Allocated beforehand in case we need to split off the end of a shrunk region (see alloc_space)
+	auto new_free_region = new VMSpaceRegion;
+	auto to_delete = new_free_region;
+	auto result = Result(SUCCESS);
+
+	{
+		LOCK(m_lock);
+		auto space_region = m_region_map;
+		while(space_region && space_region->vmRegion != &region)
+			space_region = space_region->next;
+
+		auto next = space_region ? space_region->next : nullptr;
+		size_t old_size = region.size();
+		if(!space_region) {
+			result = Result(ENOENT);
+		} else if(new_size > old_size) {
+			size_t delta = new_size - old_size;
+			if(!next || next->used || next->size < delta) {
+				result = Result(ENOMEM);
+			} else {
+				// Take the space we need from the free region after this one
+				if(next->size == delta) {
+					space_region->next = next->next;
+					if(next->next)
+						next->next->prev = space_region;
+					delete new_free_region;
+					to_delete = next;
+				} else {
+					next->start += delta;
+					next->size -= delta;
+				}
+				space_region->size += delta;
+				m_used += delta;
+				region.m_range.size = new_size;
+
+				// Map any pages of the object that already exist in the new part of the region
+				m_page_directory.map(region, VirtualRange { old_size, delta });
+			}
+		} else if(new_size < old_size) {
+			size_t delta = old_size - new_size;
+			m_page_directory.unmap(region, VirtualRange { new_size, delta });
+
+			// Give the space back to the free region after this one, or make a new free region if there isn't one
+			if(next && !next->used) {
+				next->start -= delta;
+				next->size += delta;
+			} else {
+				*new_free_region = VMSpaceRegion {
+					.start = space_region->start + new_size,
+					.size = delta,
+					.used = false,
+					.next = next,
+					.prev = space_region,
+					.vmRegion = nullptr
+				};
+				if(next)
+					next->prev = new_free_region;
+				space_region->next = new_free_region;
+				to_delete = nullptr;
+			}
+			space_region->size -= delta;
+			m_used -= delta;
+			region.m_range.size = new_size;
+		}
+	}
+
+	// We do this while not holding the lock just in case this triggers a page free in the allocator.
+	delete to_delete;
+	return result;
+}
+
 ResultRet<VirtualAddress> VMSpace::find_free_space(size_t size) {
 	LOCK(m_lock);
 	auto cur_region = m_region_map;
@@ -301,6 +428,23 @@ size_t VMSpace::calculate_regular_anonymous_total() {
 	return total;
 }
 
+VMObject::ResidentStats VMSpace::calculate_resident_stats() {
+	LOCK(m_lock);
+	VMObject::ResidentStats total;
+	auto cur_region = m_region_map;
+	while(cur_region) {
+		if(cur_region->used && cur_region->vmRegion) {
+			auto region = cur_region->vmRegion;
+			auto stats = region->m_object->resident_stats(region->object_start() / PAGE_SIZE, region->size() / PAGE_SIZE);
+			total.resident += stats.resident;
+			total.shared += stats.shared;
+			total.proportional += stats.proportional;
+		}
+		cur_region = cur_region->next;
+	}
+	return total;
+}
+
 void VMSpace::iterate_regions(kstd::IterationFunc<VMRegion*> callback) {
 	LOCK(m_lock);
 	auto cur_region = m_region_map;
@@ -311,6 +455,23 @@ void VMSpace::iterate_regions(kstd::IterationFunc<VMRegion*> callback) {
 	}
 }
 
+ResultRet<bool> VMSpace::populate_page(VMRegion& region, PageIndex page) {
+	PageIndex object_page = page + (region.object_start() / PAGE_SIZE);
+	bool did_populate = false;
+	if(region.object()->is_inode()) {
+		auto inode_object = kstd::static_pointer_cast<InodeVMObject>(region.object());
+		LOCK_N(inode_object->lock(), inode_locker);
+		did_populate = TRY(inode_object->read_page_if_needed(object_page));
+	} else if(region.object()->is_anonymous()) {
+		auto anon_object = kstd::static_pointer_cast<AnonymousVMObject>(region.object());
+		did_populate = TRY(anon_object->alloc_page_if_needed(object_page));
+	}
+
+	if(did_populate)
+		m_page_directory.map(region, VirtualRange { page * PAGE_SIZE, PAGE_SIZE });
+	return did_populate;
+}
+
 ResultRet<VMSpace::VMSpaceRegion*> VMSpace::alloc_space(size_t size) {
 	ASSERT(size % PAGE_SIZE == 0);
 
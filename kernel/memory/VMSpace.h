@@ -82,6 +82,31 @@ public:
 	 */
 	Result reserve_region(VirtualAddress start, size_t size);
 
+	/**
+	 * Makes sure the pages in a range of a region are present and mapped, reading them in or allocating them if needed.
+	 * @param region The region to populate.
+	 * @param range The range within the region to populate, relative to the start of the region. Must be page-aligned.
+	 * @return Whether the range was successfully populated.
+	 */
+	Result populate_region(VMRegion& region, VirtualRange range);
+
+	/**
+	 * Unmaps and frees the private anonymous pages in a range of a region. They will be zero-filled on next access.
+	 * @param region The region to discard pages from.
+	 * @param range The range within the region to discard, relative to the start of the region. Must be page-aligned.
+	 * @return Whether the range could be discarded. Fails with EINVAL if the region is locked, or if it's backed by an
+	 *         inode or shared memory, since there's no defined way to throw away pages someone else may be using.
+	 */
+	Result discard_region(VMRegion& region, VirtualRange range);
+
+	/**
+	 * Grows or shrinks a region in place. Growing only works if the space directly after the region is free.
+	 * @param region The region to resize.
+	 * @param new_size The new size of the region. Must be page-aligned, and must fit within the region's object.
+	 * @return Whether the region was resized. Fails with ENOMEM if there isn't enough free space after the region.
+	 */
+	Result resize_region(VMRegion& region, size_t new_size);
+
 	/**
 	 * Tries gracefully handling a pagefault.
 	 * @param fault The page fault.
@@ -103,6 +128,11 @@ public:
 	 */
 	size_t calculate_regular_anonymous_total();
 
+	/**
+	 * Calculates the resident, shared, and proportional memory usage of all the regions in the space.
+	 */
+	VMObject::ResidentStats calculate_resident_stats();
+
 	/**
 	 * Iterates over all VMRegions in the space.
 	 */
@@ -127,6 +157,7 @@ private:
 		bool contains(VirtualAddress address) const { return start <= address && end() > address; }
 	};
 
+	ResultRet<bool> populate_page(VMRegion& region, PageIndex page);
 	ResultRet<VMSpaceRegion*> alloc_space(size_t size);
 	ResultRet<VMSpaceRegion*> alloc_space_at(size_t size, VirtualAddress address);
 	Result free_region(VMSpaceRegion* region);
@@ -82,10 +82,12 @@
 //Device Subclasses
 #define PCI_PCI_BRIDGE 0x4
 #define PCI_IDE_CONTROLLER 0x1
+#define PCI_SATA_CONTROLLER 0x6
 
 //Device types
 #define PCI_TYPE_BRIDGE 0x0604
 #define PCI_TYPE_IDE_CONTROLLER 0x0101
+#define PCI_TYPE_SATA_CONTROLLER 0x0106
 
 namespace PCI {
 	union IOAddress {
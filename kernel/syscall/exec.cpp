@@ -68,7 +68,7 @@ int Process::exec(const kstd::string& filename, ProcessArgs* args) {
 	return -1;
 }
 
-int Process::sys_execve(UserspacePointer<char> filename, UserspacePointer<char*> argv, UserspacePointer<char*> envp) {
+ProcessArgs* Process::read_args(UserspacePointer<char*> argv, UserspacePointer<char*> envp) {
 	auto* args = new ProcessArgs(_cwd);
 	if(argv) {
 		int i = 0;
@@ -84,5 +84,9 @@ int Process::sys_execve(UserspacePointer<char> filename, UserspacePointer<char*>
 			i++;
 		}
 	}
-	return exec(filename.str(), args);
+	return args;
+}
+
+int Process::sys_execve(UserspacePointer<char> filename, UserspacePointer<char*> argv, UserspacePointer<char*> envp) {
+	return exec(filename.str(), read_args(argv, envp));
 }
\ No newline at end of file
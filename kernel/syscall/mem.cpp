@@ -10,6 +10,35 @@
 #include "../filesystem/InodeFile.h"
 #include "../memory/InodeVMObject.h"
 
+/**
+ * Calls a callback for each region overlapping a range of memory with the range relative to the start of the region.
+ * Fails with ENOMEM if any part of the range is not mapped, or EINVAL if the start isn't page-aligned.
+ */
+template<typename F>
+static Result for_each_region_in_range(VMSpace& space, void* addr, size_t length, F&& callback) {
+	auto start = (VirtualAddress) addr;
+	if(start % PAGE_SIZE)
+		return Result(EINVAL);
+	auto end = start + kstd::ceil_div(length, PAGE_SIZE) * PAGE_SIZE;
+	if(end < start)
+		return Result(ENOMEM);
+
+	auto cur = start;
+	while(cur < end) {
+		auto region_res = space.get_region_containing(cur);
+		if(region_res.is_error())
+			return Result(ENOMEM);
+		auto region = region_res.value();
+		auto region_end = min(region->end(), end);
+		auto res = callback(*region, VirtualRange { cur - region->start(), region_end - cur });
+		if(res.is_error())
+			return res;
+		cur = region_end;
+	}
+
+	return Result(SUCCESS);
+}
+
 int Process::sys_shmcreate(UserspacePointer<shmcreate_args> args_p) {
 	auto args = args_p.get();
 
@@ -82,7 +111,7 @@ int Process::sys_shmdetach(int id) {
 	LOCK(m_mem_lock);
 	for(size_t i = 0; i < _vm_regions.size(); i++) {
 		if(_vm_regions[i]->object() == object) {
-			m_used_shmem -= object->size();
+			m_used_shmem -= _vm_regions[i]->size();
 			_vm_regions.erase(i);
 			return SUCCESS;
 		}
@@ -137,7 +166,11 @@ Result Process::sys_mmap(UserspacePointer<struct mmap_args> args_ptr) {
 		kstd::string name = "anonymous";
 		if (args.name)
 			name = UserspacePointer<const char>(args.name).str();
-		vm_object = TRY(AnonymousVMObject::alloc(args.length, name));
+		// With MAP_NORESERVE, pages are only allocated once they're touched
+		if((args.flags & MAP_NORESERVE) && !(args.flags & MAP_POPULATE))
+			vm_object = TRY(AnonymousVMObject::alloc_lazy(args.length, name));
+		else
+			vm_object = TRY(AnonymousVMObject::alloc(args.length, name));
 	} else {
 		if(args.fd >= _file_descriptors.size() || !_file_descriptors[args.fd])
 			return Result(EBADF);
@@ -148,9 +181,14 @@ Result Process::sys_mmap(UserspacePointer<struct mmap_args> args_ptr) {
 		if(!file || !file->is_inode())
 			return Result(EBADF);
 		auto inode = kstd::static_pointer_cast<InodeFile>(file)->inode();
-		if(args.flags & MAP_SHARED)
-			vm_object = inode->shared_vm_object(file_desc->path());
-		else
+		if(args.flags & MAP_SHARED) {
+			auto data_or_err = inode->data_vm_object();
+			if(data_or_err.is_error())
+				return Result(-data_or_err.code());
+			vm_object = data_or_err.value();
+			if(!vm_object)
+				vm_object = inode->shared_vm_object(file_desc->path());
+		} else
 			vm_object = InodeVMObject::make_for_inode(file_desc->path(), inode, InodeVMObject::Type::Private);
 	}
 
@@ -169,6 +207,12 @@ Result Process::sys_mmap(UserspacePointer<struct mmap_args> args_ptr) {
 	if(!region)
 		return Result(EINVAL);
 
+	if(args.flags & MAP_POPULATE) {
+		auto populate_res = _vm_space->populate_region(*region, VirtualRange { 0, region->size() });
+		if(populate_res.is_error())
+			return populate_res;
+	}
+
 	m_used_pmem += region->size();
 	_vm_regions.push_back(region);
 	UserspacePointer<void*>(args.addr_p).set((void*) region->start());
@@ -212,4 +256,123 @@ int Process::sys_mprotect(void* addr, size_t length, int prot_flags) {
 
 	KLog::warn("Process", "mprotect() for %s(%d) failed.", _name.c_str(), _pid);
 	return ENOENT;
-}
\ No newline at end of file
+}
+
+Result Process::sys_madvise(void* addr, size_t length, int advice) {
+	LOCK(m_mem_lock);
+	return for_each_region_in_range(*_vm_space, addr, length, [&](VMRegion& region, VirtualRange range) -> Result {
+		switch(advice) {
+			case MADV_NORMAL:
+				region.set_access(VMRegion::Access::Normal);
+				return Result(SUCCESS);
+			case MADV_RANDOM:
+				region.set_access(VMRegion::Access::Random);
+				return Result(SUCCESS);
+			case MADV_SEQUENTIAL:
+				region.set_access(VMRegion::Access::Sequential);
+				return Result(SUCCESS);
+			case MADV_WILLNEED:
+				return _vm_space->populate_region(region, range);
+			case MADV_DONTNEED:
+				return _vm_space->discard_region(region, range);
+			default:
+				return Result(EINVAL);
+		}
+	});
+}
+
+Result Process::sys_mlock(void* addr, size_t length) {
+	LOCK(m_mem_lock);
+	return for_each_region_in_range(*_vm_space, addr, length, [&](VMRegion& region, VirtualRange range) -> Result {
+		// Pages are never evicted once present, so locking just means making them present and refusing to discard them.
+		auto res = _vm_space->populate_region(region, range);
+		if(res.is_success())
+			region.set_locked(true);
+		return res;
+	});
+}
+
+Result Process::sys_munlock(void* addr, size_t length) {
+	LOCK(m_mem_lock);
+	return for_each_region_in_range(*_vm_space, addr, length, [&](VMRegion& region, VirtualRange range) -> Result {
+		region.set_locked(false);
+		return Result(SUCCESS);
+	});
+}
+
+Result Process::sys_mremap(UserspacePointer<struct mremap_args> args_ptr) {
+	auto args = args_ptr.get();
+	if((VirtualAddress) args.old_address % PAGE_SIZE || !args.new_size || (args.flags & ~MREMAP_MAYMOVE))
+		return Result(EINVAL);
+	size_t old_size = kstd::ceil_div(args.old_size, PAGE_SIZE) * PAGE_SIZE;
+	size_t new_size = kstd::ceil_div(args.new_size, PAGE_SIZE) * PAGE_SIZE;
+	if(new_size < args.new_size)
+		return Result(ENOMEM);
+
+	LOCK(m_mem_lock);
+
+	// Find the region. Like munmap, only whole regions can be remapped.
+	size_t region_index;
+	for(region_index = 0; region_index < _vm_regions.size(); region_index++) {
+		if(_vm_regions[region_index]->start() == (VirtualAddress) args.old_address)
+			break;
+	}
+	if(region_index == _vm_regions.size())
+		return Result(EFAULT);
+	auto region = _vm_regions[region_index];
+	if(region->size() != old_size)
+		return Result(EINVAL);
+
+	auto object = region->object();
+	size_t object_end = region->object_start() + new_size;
+	bool is_shared = object->is_anonymous() && kstd::static_pointer_cast<AnonymousVMObject>(object)->is_shared();
+
+	// Anonymous objects that only we can resize can grow to fit the region, and shrink along with it.
+	kstd::Arc<AnonymousVMObject> resizable_object;
+	if(object->is_anonymous()) {
+		auto anon_object = kstd::static_pointer_cast<AnonymousVMObject>(object);
+		if(anon_object->is_shared() ? anon_object->shared_owner() == _pid : object->map_count() == 1)
+			resizable_object = anon_object;
+	}
+	size_t old_object_size = object->size();
+	if(object_end > old_object_size) {
+		if(!resizable_object)
+			return Result(EINVAL);
+		resizable_object->resize(object_end);
+	}
+
+	// If the region can't be resized, shrink the object back down so it doesn't keep the pages we grew it by
+	auto undo_grow = [&]() {
+		if(object->size() > old_object_size)
+			resizable_object->resize(old_object_size);
+	};
+
+	// First try resizing in place, and then move the region somewhere else if allowed. Either way, the pages are
+	// just remapped and never copied.
+	auto resize_res = _vm_space->resize_region(*region, new_size);
+	if(resize_res.code() == ENOMEM && (args.flags & MREMAP_MAYMOVE)) {
+		auto move_res = _vm_space->map_object(object, region->prot(), VirtualRange { 0, new_size }, region->object_start());
+		if(move_res.is_error()) {
+			undo_grow();
+			return move_res.result();
+		}
+		auto new_region = move_res.value();
+		new_region->set_access(region->access());
+		new_region->set_locked(region->is_locked());
+		_vm_regions[region_index] = new_region;
+		region = new_region;
+	} else if(resize_res.is_error()) {
+		undo_grow();
+		return resize_res;
+	}
+
+	// Release the pages past the end of a shrunk object that nobody else can see
+	if(resizable_object && !is_shared && object_end < object->size())
+		resizable_object->resize(object_end);
+
+	size_t& used = is_shared ? m_used_shmem : m_used_pmem;
+	used = used - old_size + new_size;
+
+	UserspacePointer<void*>(args.new_address_p).set((void*) region->start());
+	return Result(SUCCESS);
+}
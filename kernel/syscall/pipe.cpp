@@ -33,4 +33,57 @@ int Process::sys_pipe(UserspacePointer<int> filedes, int options) {
 	filedes.set(1, (int) _file_descriptors.size() - 1);
 
 	return SUCCESS;
-}
\ No newline at end of file
+}
+
+ssize_t Process::sys_splice(UserspacePointer<struct splice_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd_in < 0 || args.fd_in >= (int) _file_descriptors.size() || !_file_descriptors[args.fd_in])
+		return -EBADF;
+	if(args.fd_out < 0 || args.fd_out >= (int) _file_descriptors.size() || !_file_descriptors[args.fd_out])
+		return -EBADF;
+	if(args.flags & ~(SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE))
+		return -EINVAL;
+
+	auto in = _file_descriptors[args.fd_in];
+	auto out = _file_descriptors[args.fd_out];
+	if(!in->readable() || !out->writable())
+		return -EBADF;
+
+	//At least one end has to be a pipe, and pipes don't have offsets
+	bool in_pipe = in->file()->is_fifo();
+	bool out_pipe = out->file()->is_fifo();
+	if(!in_pipe && !out_pipe)
+		return -EINVAL;
+	if((in_pipe && args.off_in) || (out_pipe && args.off_out))
+		return -ESPIPE;
+
+	//Between two pipes, the data can go straight from one buffer to the other
+	if(in_pipe && out_pipe) {
+		auto& in_pipe_file = *((Pipe*) in->file().get());
+		auto& out_pipe_file = *((Pipe*) out->file().get());
+		return in_pipe_file.splice_to(out_pipe_file, args.len, args.flags & SPLICE_F_NONBLOCK);
+	}
+
+	//Between a pipe and a file, the data goes straight between the pipe's buffer and the file, and only what the other
+	//end accepts is moved. The pipe stays locked while the file is read or written, so like sendfile, the other end
+	//has to be a regular file that won't block indefinitely.
+	if(!(in_pipe ? out : in)->metadata().is_simple_file())
+		return -EINVAL;
+	bool nonblock = args.flags & SPLICE_F_NONBLOCK;
+	auto offset_ptr = UserspacePointer<off_t>(in_pipe ? args.off_out : args.off_in);
+	off_t offset = 0;
+	if(offset_ptr.raw()) {
+		offset = offset_ptr.get();
+		if(offset < 0)
+			return -EINVAL;
+	}
+
+	ssize_t ret;
+	if(in_pipe)
+		ret = ((Pipe*) in->file().get())->splice_to_file(*out, offset_ptr.raw() ? &offset : nullptr, args.len, nonblock || in->nonblock());
+	else
+		ret = ((Pipe*) out->file().get())->splice_from_file(*in, offset_ptr.raw() ? &offset : nullptr, args.len, nonblock || out->nonblock());
+	if(offset_ptr.raw())
+		offset_ptr.set(offset);
+	return ret;
+}
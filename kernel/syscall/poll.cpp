@@ -5,6 +5,7 @@
 #include "../memory/SafePointer.h"
 #include "../filesystem/FileDescriptor.h"
 #include "../tasking/PollBlocker.h"
+#include "../filesystem/Epoll.h"
 
 int Process::sys_poll(UserspacePointer<pollfd> pollfd, nfds_t nfd, int timeout) {
 	//Build the list of PollBlocker::PollFDs
@@ -28,15 +29,65 @@ int Process::sys_poll(UserspacePointer<pollfd> pollfd, nfds_t nfd, int timeout)
 	if(blocker.was_interrupted())
 		return -EINTR;
 
-	//Set appropriate revent
+	//Report every file descriptor that's ready, not just the one that woke us up
+	int num_ready = 0;
 	for(nfds_t i = 0; i < nfd; i++) {
 		auto poll = pollfd.get(i);
-		if(poll.fd == blocker.polled) {
-			poll.revents = blocker.polled_revent;
+		if(poll.fd < 0 || poll.fd >= (int) _file_descriptors.size() || !_file_descriptors[poll.fd])
+			continue;
+		poll.revents = PollBlocker::ready_events({poll.fd, _file_descriptors[poll.fd], poll.events});
+		if(poll.revents) {
 			pollfd.set(i, poll);
-			break;
+			num_ready++;
 		}
 	}
 
-	return SUCCESS;
-}
\ No newline at end of file
+	return num_ready;
+}
+
+int Process::sys_epoll_create(int flags) {
+	if(flags & ~EPOLL_CLOEXEC)
+		return -EINVAL;
+
+	auto epoll_fd = kstd::make_shared<FileDescriptor>(kstd::make_shared<Epoll>());
+	epoll_fd->set_owner(_self_ptr);
+	epoll_fd->set_options(O_RDONLY | flags);
+	_file_descriptors.push_back(epoll_fd);
+	epoll_fd->set_id((int) _file_descriptors.size() - 1);
+	return (int) _file_descriptors.size() - 1;
+}
+
+int Process::sys_epoll_ctl(UserspacePointer<struct epoll_ctl_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.epfd < 0 || args.epfd >= (int) _file_descriptors.size() || !_file_descriptors[args.epfd])
+		return -EBADF;
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd])
+		return -EBADF;
+	auto epoll_file = _file_descriptors[args.epfd]->file();
+	if(!epoll_file->is_epoll() || args.epfd == args.fd)
+		return -EINVAL;
+
+	epoll_event event = {0, {nullptr}};
+	if(args.op != EPOLL_CTL_DEL)
+		event = UserspacePointer<epoll_event>(args.event).get();
+	return ((Epoll*) epoll_file.get())->control(args.op, args.fd, _file_descriptors[args.fd], event).code();
+}
+
+int Process::sys_epoll_wait(UserspacePointer<struct epoll_wait_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.epfd < 0 || args.epfd >= (int) _file_descriptors.size() || !_file_descriptors[args.epfd])
+		return -EBADF;
+	auto epoll_file = _file_descriptors[args.epfd]->file();
+	if(!epoll_file->is_epoll() || args.maxevents <= 0)
+		return -EINVAL;
+
+	auto events_res = ((Epoll*) epoll_file.get())->wait(args.maxevents, Time(0, args.timeout * 1000));
+	if(events_res.is_error())
+		return events_res.code();
+
+	//Copy all of the events out at once
+	auto& events = events_res.value();
+	if(!events.empty())
+		UserspacePointer<epoll_event>(args.events).write(events.storage(), events.size());
+	return (int) events.size();
+}
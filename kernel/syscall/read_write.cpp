@@ -3,6 +3,7 @@
 
 #include "../tasking/Process.h"
 #include "../filesystem/FileDescriptor.h"
+#include "../filesystem/InodeFile.h"
 #include <kernel/filesystem/VFS.h>
 
 ssize_t Process::sys_read(int fd, UserspacePointer<uint8_t> buf, size_t count) {
@@ -24,6 +25,106 @@ ssize_t Process::sys_write(int fd, UserspacePointer<uint8_t> buffer, size_t coun
 	return ret;
 }
 
+ssize_t Process::sys_pread(UserspacePointer<struct pread_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd])
+		return -EBADF;
+	return _file_descriptors[args.fd]->pread(args.offset, UserspacePointer<uint8_t>((uint8_t*) args.buf), args.count);
+}
+
+ssize_t Process::sys_pwrite(UserspacePointer<struct pread_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd])
+		return -EBADF;
+	return _file_descriptors[args.fd]->pwrite(args.offset, UserspacePointer<uint8_t>((uint8_t*) args.buf), args.count);
+}
+
+ssize_t Process::sys_readv(int fd, UserspacePointer<struct iovec> iov, int iovcnt) {
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	return _file_descriptors[fd]->readv(iov, iovcnt);
+}
+
+ssize_t Process::sys_writev(int fd, UserspacePointer<struct iovec> iov, int iovcnt) {
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	return _file_descriptors[fd]->writev(iov, iovcnt);
+}
+
+ssize_t Process::sys_preadv(UserspacePointer<struct preadv_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd])
+		return -EBADF;
+	return _file_descriptors[args.fd]->preadv(args.offset, UserspacePointer<struct iovec>((struct iovec*) args.iov), args.iovcnt);
+}
+
+ssize_t Process::sys_pwritev(UserspacePointer<struct preadv_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd])
+		return -EBADF;
+	return _file_descriptors[args.fd]->pwritev(args.offset, UserspacePointer<struct iovec>((struct iovec*) args.iov), args.iovcnt);
+}
+
+ssize_t Process::sys_copy_file_range(UserspacePointer<struct copy_file_range_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.fd_in < 0 || args.fd_in >= (int) _file_descriptors.size() || !_file_descriptors[args.fd_in])
+		return -EBADF;
+	if(args.fd_out < 0 || args.fd_out >= (int) _file_descriptors.size() || !_file_descriptors[args.fd_out])
+		return -EBADF;
+	if(args.flags)
+		return -EINVAL;
+
+	auto in = _file_descriptors[args.fd_in];
+	auto out = _file_descriptors[args.fd_out];
+	if(out->append_mode())
+		return -EBADF;
+	auto in_meta = in->metadata();
+	auto out_meta = out->metadata();
+	if(in_meta.is_directory() || out_meta.is_directory())
+		return -EISDIR;
+	if(!in_meta.is_simple_file() || !out_meta.is_simple_file())
+		return -EINVAL;
+
+	off_t off_in = args.off_in ? UserspacePointer<off_t>(args.off_in).get() : in->offset();
+	off_t off_out = args.off_out ? UserspacePointer<off_t>(args.off_out).get() : out->offset();
+	if(off_in < 0 || off_out < 0)
+		return -EINVAL;
+
+	//Copying a file's data over itself would give different results depending on how it's chunked
+	auto in_inode = kstd::static_pointer_cast<InodeFile>(in->file())->inode();
+	auto out_inode = kstd::static_pointer_cast<InodeFile>(out->file())->inode();
+	if(in_inode == out_inode && (uint64_t) off_in < (uint64_t) off_out + args.len
+		&& (uint64_t) off_out < (uint64_t) off_in + args.len)
+		return -EINVAL;
+
+	ssize_t ret = in->copy_to(*out, args.off_in ? &off_in : nullptr, args.off_out ? &off_out : nullptr, args.len);
+	if(args.off_in)
+		UserspacePointer<off_t>(args.off_in).set(off_in);
+	if(args.off_out)
+		UserspacePointer<off_t>(args.off_out).set(off_out);
+	return ret;
+}
+
+ssize_t Process::sys_sendfile(UserspacePointer<struct sendfile_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.in_fd < 0 || args.in_fd >= (int) _file_descriptors.size() || !_file_descriptors[args.in_fd])
+		return -EBADF;
+	if(args.out_fd < 0 || args.out_fd >= (int) _file_descriptors.size() || !_file_descriptors[args.out_fd])
+		return -EBADF;
+
+	//Unlike copy_file_range, the output can be anything, but the input has to be a regular file
+	auto in = _file_descriptors[args.in_fd];
+	if(!in->metadata().is_simple_file())
+		return -EINVAL;
+
+	if(!args.offset)
+		return in->copy_to(*_file_descriptors[args.out_fd], nullptr, nullptr, args.count);
+	off_t offset = UserspacePointer<off_t>(args.offset).get();
+	ssize_t ret = in->copy_to(*_file_descriptors[args.out_fd], &offset, nullptr, args.count);
+	UserspacePointer<off_t>(args.offset).set(offset);
+	return ret;
+}
+
 int Process::sys_lseek(int file, off_t off, int whence) {
 	if(file < 0 || file >= (int) _file_descriptors.size() || !_file_descriptors[file])
 		return -EBADF;
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "../tasking/Process.h"
+#include "../tasking/TaskManager.h"
+#include "../tasking/ProcessArgs.h"
+#include "../memory/SafePointer.h"
+#include "../filesystem/VFS.h"
+#include "../filesystem/FileDescriptor.h"
+
+/**
+ * Creates a new process running the given executable without forking, so none of our address space needs to be
+ * copied or marked CoW just to be thrown away by exec(). The file actions are applied to a copy of our file
+ * descriptor table, in the same way the child of a fork() would dup2/close/open before exec()ing.
+ */
+Result Process::sys_posix_spawn(UserspacePointer<struct posix_spawn_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSID))
+		return Result(EINVAL);
+	auto path = UserspacePointer<char>((char*) args.path).str();
+
+	// Make sure the process group we're joining (if any) is in our session
+	if((args.flags & POSIX_SPAWN_SETPGROUP) && args.pgroup) {
+		if(args.pgroup < 0)
+			return Result(EINVAL);
+		auto* procs = TaskManager::process_list();
+		for(size_t i = 0; i < procs->size(); i++) {
+			auto c_proc = procs->at(i);
+			if(c_proc->_pgid == args.pgroup && c_proc->_sid != _sid)
+				return Result(EPERM);
+		}
+	}
+
+	// Copy our file descriptors and apply the file actions to them
+	kstd::vector<kstd::Arc<FileDescriptor>> fds;
+	fds.resize(_file_descriptors.size());
+	for(size_t i = 0; i < _file_descriptors.size(); i++) {
+		if(_file_descriptors[i])
+			fds[i] = kstd::make_shared<FileDescriptor>(*_file_descriptors[i]);
+	}
+
+	UserspacePointer<posix_spawn_file_action> actions((posix_spawn_file_action*) args.file_actions);
+	for(size_t i = 0; i < args.num_file_actions; i++) {
+		auto action = actions.get(i);
+		if(action.fd < 0)
+			return Result(EBADF);
+		switch(action.type) {
+			case POSIX_SPAWN_FILE_ACTION_OPEN: {
+				auto action_path = UserspacePointer<char>((char*) action.path).str();
+				auto fd = TRY(VFS::inst().open(action_path, action.oflag, (action.mode & 04777) & ~_umask, _user, _cwd));
+				fd->set_path(action_path);
+				if((size_t) action.fd >= fds.size())
+					fds.resize(action.fd + 1);
+				fds[action.fd] = fd;
+				break;
+			}
+
+			case POSIX_SPAWN_FILE_ACTION_CLOSE:
+				if((size_t) action.fd >= fds.size() || !fds[action.fd])
+					return Result(EBADF);
+				fds[action.fd].reset();
+				break;
+
+			case POSIX_SPAWN_FILE_ACTION_DUP2: {
+				if((size_t) action.fd >= fds.size() || !fds[action.fd] || action.newfd < 0)
+					return Result(EBADF);
+				if(action.newfd == action.fd) {
+					fds[action.fd]->unset_options(O_CLOEXEC);
+					break;
+				}
+				if((size_t) action.newfd >= fds.size())
+					fds.resize(action.newfd + 1);
+				auto new_fd = kstd::make_shared<FileDescriptor>(*fds[action.fd]);
+				new_fd->unset_options(O_CLOEXEC);
+				fds[action.newfd] = new_fd;
+				break;
+			}
+
+			default:
+				return Result(EINVAL);
+		}
+	}
+
+	// Create the process
+	auto* proc_args = read_args(UserspacePointer<char*>((char**) args.argv), UserspacePointer<char*>((char**) args.envp));
+	auto new_proc_res = Process::create_user(path, _user, proc_args, TaskManager::get_new_pid(), _pid);
+	delete proc_args;
+	if(new_proc_res.is_error())
+		return new_proc_res.result();
+	auto* new_proc = new_proc_res.value();
+
+	// Give it the file descriptors that should survive an exec
+	new_proc->_file_descriptors.resize(fds.size());
+	int last_fd = 0;
+	for(size_t i = 0; i < fds.size(); i++) {
+		if(fds[i] && !fds[i]->cloexec()) {
+			last_fd = i;
+			fds[i]->set_owner(new_proc);
+			fds[i]->set_id(i);
+			new_proc->_file_descriptors[i] = fds[i];
+		} else {
+			new_proc->_file_descriptors[i].reset();
+		}
+	}
+	new_proc->_file_descriptors.resize(last_fd + 1);
+
+	// Inherit everything else exec() would keep
+	new_proc->_user = _user;
+	if(args.flags & POSIX_SPAWN_RESETIDS) {
+		new_proc->_user.euid = _user.uid;
+		new_proc->_user.egid = _user.gid;
+	}
+	new_proc->_umask = _umask;
+	new_proc->_tty = _tty;
+	new_proc->_sid = _sid;
+	new_proc->_pgid = _pgid;
+	if(args.flags & POSIX_SPAWN_SETSID) {
+		new_proc->_sid = new_proc->_pid;
+		new_proc->_pgid = new_proc->_pid;
+		new_proc->_tty.reset();
+	} else if(args.flags & POSIX_SPAWN_SETPGROUP) {
+		new_proc->_pgid = args.pgroup ? args.pgroup : new_proc->_pid;
+	}
+
+	auto pid = new_proc->_pid;
+	if(args.pid_p)
+		UserspacePointer<pid_t>(args.pid_p).set(pid);
+	TaskManager::add_process(new_proc);
+	return Result(SUCCESS);
+}
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "../tasking/Process.h"
+#include "../filesystem/FileDescriptor.h"
+#include "../filesystem/File.h"
+#include "../device/DiskDevice.h"
+
+Result Process::sys_sync() {
+	return DiskDevice::sync_all();
+}
+
+Result Process::sys_fsync(int fd) {
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return Result(EBADF);
+	return _file_descriptors[fd]->file()->sync();
+}
+
+Result Process::sys_fdatasync(int fd) {
+	// fsync only writes back the file's data and the blocks needed to find it, which fdatasync has to write anyway.
+	return sys_fsync(fd);
+}
@@ -182,6 +182,46 @@ int handle_syscall(Registers& regs, uint32_t call, uint32_t arg1, uint32_t arg2,
 			return cur_proc->sys_mprotect((void*) arg1, (size_t) arg2, arg3);
 		case SYS_UNAME:
 			return cur_proc->sys_uname((struct utsname*) arg1);
+		case SYS_MADVISE:
+			return -cur_proc->sys_madvise((void*) arg1, (size_t) arg2, (int) arg3).code();
+		case SYS_MLOCK:
+			return -cur_proc->sys_mlock((void*) arg1, (size_t) arg2).code();
+		case SYS_MUNLOCK:
+			return -cur_proc->sys_munlock((void*) arg1, (size_t) arg2).code();
+		case SYS_POSIX_SPAWN:
+			return -cur_proc->sys_posix_spawn((struct posix_spawn_args*) arg1).code();
+		case SYS_MREMAP:
+			return -cur_proc->sys_mremap((struct mremap_args*) arg1).code();
+		case SYS_SYNC:
+			return -cur_proc->sys_sync().code();
+		case SYS_FSYNC:
+			return -cur_proc->sys_fsync((int) arg1).code();
+		case SYS_FDATASYNC:
+			return -cur_proc->sys_fdatasync((int) arg1).code();
+		case SYS_PREAD:
+			return cur_proc->sys_pread((struct pread_args*) arg1);
+		case SYS_PWRITE:
+			return cur_proc->sys_pwrite((struct pread_args*) arg1);
+		case SYS_READV:
+			return cur_proc->sys_readv((int) arg1, (struct iovec*) arg2, (int) arg3);
+		case SYS_WRITEV:
+			return cur_proc->sys_writev((int) arg1, (struct iovec*) arg2, (int) arg3);
+		case SYS_PREADV:
+			return cur_proc->sys_preadv((struct preadv_args*) arg1);
+		case SYS_PWRITEV:
+			return cur_proc->sys_pwritev((struct preadv_args*) arg1);
+		case SYS_COPY_FILE_RANGE:
+			return cur_proc->sys_copy_file_range((struct copy_file_range_args*) arg1);
+		case SYS_SENDFILE:
+			return cur_proc->sys_sendfile((struct sendfile_args*) arg1);
+		case SYS_SPLICE:
+			return cur_proc->sys_splice((struct splice_args*) arg1);
+		case SYS_EPOLL_CREATE:
+			return cur_proc->sys_epoll_create((int) arg1);
+		case SYS_EPOLL_CTL:
+			return cur_proc->sys_epoll_ctl((struct epoll_ctl_args*) arg1);
+		case SYS_EPOLL_WAIT:
+			return cur_proc->sys_epoll_wait((struct epoll_wait_args*) arg1);
 
 		//TODO: Implement these syscalls
 		case SYS_TIMES:
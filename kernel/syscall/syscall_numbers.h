@@ -79,6 +79,26 @@
 #define SYS_MPROTECT 76
 #define SYS_UNAME 77
 #define SYS_PTRACE 78
+#define SYS_MADVISE 79
+#define SYS_MLOCK 80
+#define SYS_MUNLOCK 81
+#define SYS_POSIX_SPAWN 82
+#define SYS_MREMAP 83
+#define SYS_SYNC 84
+#define SYS_FSYNC 85
+#define SYS_FDATASYNC 86
+#define SYS_PREAD 87
+#define SYS_PWRITE 88
+#define SYS_READV 89
+#define SYS_WRITEV 90
+#define SYS_PREADV 91
+#define SYS_PWRITEV 92
+#define SYS_COPY_FILE_RANGE 93
+#define SYS_SENDFILE 94
+#define SYS_SPLICE 95
+#define SYS_EPOLL_CREATE 96
+#define SYS_EPOLL_CTL 97
+#define SYS_EPOLL_WAIT 98
 
 #ifndef DUCKOS_KERNEL
 #include <sys/types.h>
@@ -29,16 +29,10 @@ PollBlocker::PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout):
 bool PollBlocker::is_ready() {
 	for(size_t i = 0; i < polls.size(); i++) {
 		auto& poll = polls[i];
-
-		if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd)) {
-			polled = poll.fd_num;
-			polled_revent = POLLIN;
-			return true;
-		}
-
-		if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd)) {
+		short revents = ready_events(poll);
+		if(revents) {
 			polled = poll.fd_num;
-			polled_revent = POLLOUT;
+			polled_revent = revents;
 			return true;
 		}
 	}
@@ -47,4 +41,13 @@ bool PollBlocker::is_ready() {
 		return true;
 
 	return false;
-}
\ No newline at end of file
+}
+
+short PollBlocker::ready_events(const PollFD& poll) {
+	short revents = 0;
+	if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd))
+		revents |= POLLIN;
+	if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd))
+		revents |= POLLOUT;
+	return revents;
+}
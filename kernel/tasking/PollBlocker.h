@@ -36,6 +36,8 @@ public:
 
 	PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout);
 	bool is_ready() override;
+	/** Returns which of the events being polled for a file descriptor are ready. **/
+	static short ready_events(const PollFD& poll);
 
 	int polled;
 	short polled_revent;
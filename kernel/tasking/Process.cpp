@@ -313,6 +313,12 @@ size_t Process::used_shmem() const {
 	return m_used_shmem;
 }
 
+VMObject::ResidentStats Process::resident_stats() const {
+	if(!_vm_space)
+		return {};
+	return _vm_space->calculate_resident_stats();
+}
+
 /************
  * SYSCALLS *
  ************/
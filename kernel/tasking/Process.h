@@ -28,6 +28,10 @@
 #include <kernel/kstd/string.h>
 #include "../api/poll.h"
 #include "../api/mmap.h"
+#include "../api/spawn.h"
+#include "../api/uio.h"
+#include "../api/sendfile.h"
+#include "../api/epoll.h"
 
 class FileDescriptor;
 class Blocker;
@@ -92,15 +96,25 @@ public:
 	size_t used_pmem() const;
 	size_t used_vmem() const;
 	size_t used_shmem() const;
+	VMObject::ResidentStats resident_stats() const;
 
 	//Syscalls
 	void check_ptr(const void* ptr, bool write = false);
 	void sys_exit(int status);
 	ssize_t sys_read(int fd, UserspacePointer<uint8_t> buf, size_t count);
 	ssize_t sys_write(int fd, UserspacePointer<uint8_t> buf, size_t count);
+	ssize_t sys_pread(UserspacePointer<struct pread_args> args);
+	ssize_t sys_pwrite(UserspacePointer<struct pread_args> args);
+	ssize_t sys_readv(int fd, UserspacePointer<struct iovec> iov, int iovcnt);
+	ssize_t sys_writev(int fd, UserspacePointer<struct iovec> iov, int iovcnt);
+	ssize_t sys_preadv(UserspacePointer<struct preadv_args> args);
+	ssize_t sys_pwritev(UserspacePointer<struct preadv_args> args);
+	ssize_t sys_copy_file_range(UserspacePointer<struct copy_file_range_args> args);
+	ssize_t sys_sendfile(UserspacePointer<struct sendfile_args> args);
 	pid_t sys_fork(Registers& regs);
 	int exec(const kstd::string& filename, ProcessArgs* args);
 	int sys_execve(UserspacePointer<char> filename, UserspacePointer<char*> argv, UserspacePointer<char*> envp);
+	Result sys_posix_spawn(UserspacePointer<struct posix_spawn_args> args);
 	int sys_open(UserspacePointer<char> filename, int options, int mode);
 	int sys_close(int file);
 	int sys_chdir(UserspacePointer<char> path);
@@ -122,6 +136,7 @@ public:
 	int sys_truncate(UserspacePointer<char> path, off_t length);
 	int sys_ftruncate(int fd, off_t length);
 	int sys_pipe(UserspacePointer<int>, int options);
+	ssize_t sys_splice(UserspacePointer<struct splice_args> args);
 	int sys_dup(int oldfd);
 	int sys_dup2(int oldfd, int newfd);
 	int sys_isatty(int fd);
@@ -156,6 +171,9 @@ public:
 	int sys_shmdetach(int id);
 	int sys_shmallow(int id, pid_t pid, int perms);
 	int sys_poll(UserspacePointer<pollfd> pollfd, nfds_t nfd, int timeout);
+	int sys_epoll_create(int flags);
+	int sys_epoll_ctl(UserspacePointer<struct epoll_ctl_args> args);
+	int sys_epoll_wait(UserspacePointer<struct epoll_wait_args> args);
 	int sys_ptsname(int fd, UserspacePointer<char> buf, size_t bufsize);
 	int sys_sleep(UserspacePointer<timespec> time, UserspacePointer<timespec> remainder);
 	int sys_threadcreate(void* (*entry_func)(void* (*)(void*), void*), void* (*thread_func)(void*), void* arg);
@@ -166,6 +184,13 @@ public:
 	Result sys_mmap(UserspacePointer<struct mmap_args> args);
 	int sys_munmap(void* addr, size_t length);
 	int sys_mprotect(void* addr, size_t length, int prot);
+	Result sys_madvise(void* addr, size_t length, int advice);
+	Result sys_mlock(void* addr, size_t length);
+	Result sys_munlock(void* addr, size_t length);
+	Result sys_mremap(UserspacePointer<struct mremap_args> args);
+	Result sys_sync();
+	Result sys_fsync(int fd);
+	Result sys_fdatasync(int fd);
 	int sys_uname(UserspacePointer<struct utsname> buf);
 
 private:
@@ -174,6 +199,7 @@ private:
 	Process(const kstd::string& name, size_t entry_point, bool kernel, ProcessArgs* args, pid_t pid, pid_t ppid);
 	Process(Process* to_fork, Registers& regs);
 
+	ProcessArgs* read_args(UserspacePointer<char*> argv, UserspacePointer<char*> envp);
 	void alert_thread_died(kstd::Arc<Thread> thread);
 	void recalculate_pmem_total();
 	void insert_thread(const kstd::Arc<Thread>& thread);
@@ -25,6 +25,7 @@
 #include "Process.h"
 #include "Thread.h"
 #include "Reaper.h"
+#include <kernel/device/DiskDevice.h>
 #include <kernel/Processor.h>
 #include <kernel/kstd/KLog.h>
 
@@ -146,6 +147,8 @@ void TaskManager::init(){
 
 	//Create kernel threads
 	kernel_process->spawn_kernel_thread(kreaper_entry);
+	kernel_process->spawn_kernel_thread(kflusher_entry);
+	kernel_process->spawn_kernel_thread(kprefetch_entry);
 
 	//Preempt
 	cur_thread = kernel_process->get_thread(kernel_process->pid());
@@ -2,6 +2,7 @@
 /* Copyright © 2016-2022 Byteduck */
 #include "KernelTest.h"
 #include "../memory/PageDirectory.h"
+#include "../memory/AnonymousVMObject.h"
 #include "../random.h"
 
 #define NUM_REGIONS 100
@@ -23,4 +24,24 @@ KERNEL_TEST(allocate_and_free_regions) {
 		regions[i].reset();
 		ENSURE(!MM.kernel_page_directory.is_mapped(start, true));
 	}
-}
\ No newline at end of file
+}
+
+KERNEL_TEST(resize_region) {
+	auto object = AnonymousVMObject::alloc(PAGE_SIZE * 4).value();
+	auto region = MM.map_object(object);
+	auto start = region->start();
+
+	// Shrinking should unmap the end of the region
+	ENSURE(MM.kernel_space()->resize_region(*region, PAGE_SIZE * 2).is_success());
+	ENSURE_EQ(region->size(), PAGE_SIZE * 2);
+	ENSURE(MM.kernel_page_directory.is_mapped(start + PAGE_SIZE, true));
+	ENSURE(!MM.kernel_page_directory.is_mapped(start + PAGE_SIZE * 2, true));
+
+	// Growing back into the freed space should map the object's pages again
+	ENSURE(MM.kernel_space()->resize_region(*region, PAGE_SIZE * 4).is_success());
+	ENSURE_EQ(region->size(), PAGE_SIZE * 4);
+	ENSURE(MM.kernel_page_directory.is_mapped(start + PAGE_SIZE * 3, true));
+
+	// Regions can't grow past the end of their object
+	ENSURE(MM.kernel_space()->resize_region(*region, PAGE_SIZE * 5).is_error());
+}
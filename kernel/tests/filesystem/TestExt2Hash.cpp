@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "../KernelTest.h"
+#include <kernel/filesystem/ext2/Ext2.h>
+#include <kernel/filesystem/ext2/Ext2Hash.h>
+#include <kernel/kstd/cstring.h>
+
+// The expected hashes are what `debugfs -R "dx_hash -h <version> <name>"` from e2fsprogs 1.47.0 gives.
+
+struct HashVector {
+	const char* name;
+	uint32_t hashes[6]; ///< The hash for each of the EXT2_HASH_* versions, in order.
+};
+
+static const HashVector s_vectors[] = {
+	{"", {0x2547fc5a, 0xefcdab88, 0x67452300, 0x2547fc5a, 0xefcdab88, 0x67452300}},
+	{"a", {0xe74b53e2, 0xd5fa7d7a, 0x6d0ea4c0, 0xe74b53e2, 0xd5fa7d7a, 0x6d0ea4c0}},
+	{"lost+found", {0x5e2aba24, 0x591de422, 0x2dbf9e80, 0x5e2aba24, 0x591de422, 0x2dbf9e80}},
+	{"hello_world.txt", {0x2c210aea, 0x57d08270, 0x136a32e2, 0x2c210aea, 0x57d08270, 0x136a32e2}},
+	{"a_rather_long_filename_that_spans_more_than_one_block_of_input.dat",
+		{0x0fd4670c, 0x7cf4ce68, 0xf24f4408, 0x0fd4670c, 0x7cf4ce68, 0xf24f4408}},
+	// Names with high-bit characters hash differently depending on whether the version treats chars as signed
+	{"caf\xc3\xa9", {0x96ca5a2c, 0xfb9c5e5c, 0x105842ea, 0x6dde4230, 0x9d72aed6, 0x6621f032}},
+	{"\xff\xfe\x80hi", {0x618ba584, 0xa7213ad4, 0xcc2be128, 0x2c8f9b22, 0xeeab7a72, 0xbc1335f8}},
+};
+
+KERNEL_TEST(ext2_hash_known_answers) {
+	for(auto& vector : s_vectors) {
+		for(uint8_t version = EXT2_HASH_LEGACY; version <= EXT2_HASH_TEA_UNSIGNED; version++)
+			ENSURE_EQ(Ext2Hash::hash(vector.name, strlen(vector.name), version, nullptr), vector.hashes[version]);
+	}
+}
+
+KERNEL_TEST(ext2_hash_seeded) {
+	// The seed from the UUID 3c2d1e0f-5a4b-7869-8796-a5b4c3d2e1f0, as it's stored in the superblock
+	const uint32_t seed[4] = {0x0f1e2d3c, 0x69784b5a, 0xb4a59687, 0xf0e1d2c3};
+	ENSURE_EQ(Ext2Hash::hash("lost+found", 10, EXT2_HASH_HALF_MD4, seed), 0xac9c667a);
+	ENSURE_EQ(Ext2Hash::hash("lost+found", 10, EXT2_HASH_TEA, seed), 0xea1b908c);
+
+	// An all-zero seed means the default one should be used
+	const uint32_t zero_seed[4] = {0, 0, 0, 0};
+	ENSURE_EQ(Ext2Hash::hash("lost+found", 10, EXT2_HASH_HALF_MD4, zero_seed), 0x591de422);
+}
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "../KernelTest.h"
+#include <kernel/kstd/LRUCache.h>
+
+using IntCache = kstd::LRUCache<int, int>;
+
+KERNEL_TEST(lru_cache_insert_get) {
+	IntCache cache;
+	for(int i = 0; i < 1000; i++)
+		cache.insert(i, i * 2);
+	ENSURE_EQ(cache.size(), 1000);
+	for(int i = 0; i < 1000; i++) {
+		auto val = cache.get(i);
+		ENSURE(val);
+		ENSURE_EQ(val.value(), i * 2);
+	}
+	ENSURE(!cache.get(1000));
+	cache.insert(5, 1);
+	ENSURE_EQ(cache.size(), 1000);
+	ENSURE_EQ(cache.get(5).value(), 1);
+}
+
+KERNEL_TEST(lru_cache_erase) {
+	IntCache cache;
+	for(int i = 0; i < 1000; i++)
+		cache.insert(i, i);
+	for(int i = 0; i < 1000; i += 2)
+		cache.erase(i);
+	ENSURE_EQ(cache.size(), 500);
+	for(int i = 0; i < 1000; i++)
+		ENSURE_EQ((bool) cache.get(i), (bool) (i % 2));
+}
+
+KERNEL_TEST(lru_cache_order) {
+	IntCache cache;
+	for(int i = 0; i < 100; i++)
+		cache.insert(i, i);
+	ENSURE_EQ(cache.lru_unsafe().first, 0);
+
+	// Using an item should make it the most recently used
+	cache.get(0);
+	cache.promote(1);
+	ENSURE_EQ(cache.lru_unsafe().first, 2);
+
+	cache.prune(98);
+	ENSURE_EQ(cache.size(), 2);
+	ENSURE_EQ(cache.lru_unsafe().first, 0);
+	cache.prune(1);
+	ENSURE_EQ(cache.lru_unsafe().first, 1);
+	cache.prune(5);
+	ENSURE(cache.empty());
+	ENSURE(!cache.lru());
+}
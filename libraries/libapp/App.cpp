@@ -21,6 +21,7 @@
 #include <libgraphics/PNG.h>
 #include <libduck/Config.h>
 #include <unistd.h>
+#include <spawn.h>
 
 using namespace App;
 using Duck::Result, Duck::ResultRet, Duck::Path;
@@ -180,22 +181,26 @@ bool Info::can_handle(Duck::Path path) const {
 }
 
 Result Info::run(const std::vector<std::string>& args, bool do_fork) const {
-	if(!do_fork || !fork()) {
-		std::string exec_str = exec();
-		auto c_args = new char*[2 + args.size()];
-		c_args[0] = (char*) exec_str.c_str();
-		int i = 1;
-		for(auto& arg : args)
-			c_args[i++] = (char*) arg.c_str();
-		c_args[i] = NULL;
-		execve(exec_str.c_str(), c_args, environ);
-		if(do_fork)
-			exit(-1);
-		else
-			return Result(errno);
+	std::string exec_str = exec();
+	auto c_args = new char*[2 + args.size()];
+	c_args[0] = (char*) exec_str.c_str();
+	int i = 1;
+	for(auto& arg : args)
+		c_args[i++] = (char*) arg.c_str();
+	c_args[i] = NULL;
+
+	if(do_fork) {
+		pid_t pid;
+		int res = posix_spawn(&pid, exec_str.c_str(), nullptr, nullptr, c_args, environ);
+		delete[] c_args;
+		if(res)
+			return Result(res);
+		return Result::SUCCESS;
 	}
 
-	return Result::SUCCESS;
+	execve(exec_str.c_str(), c_args, environ);
+	delete[] c_args;
+	return Result(errno);
 }
 
 std::vector<Info> App::get_all_apps() {
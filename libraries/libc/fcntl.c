@@ -38,4 +38,9 @@ int openat(int dirfd, const char* pathname, int flags) {
 
 int fcntl(int fd, int cmd, ...) {
 	return -1;
+}
+
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags) {
+	struct splice_args args = {fd_in, off_in, fd_out, off_out, len, flags};
+	return syscall2(SYS_SPLICE, (int) &args);
 }
\ No newline at end of file
@@ -53,4 +53,6 @@
 #include <kernel/api/page_size.h>
 #endif
 
+#define PIPE_BUF PAGE_SIZE
+
 #endif //DUCKOS_LIBC_LIMITS_H
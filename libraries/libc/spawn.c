@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "spawn.h"
+#include <sys/syscall.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern char** environ;
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+	struct posix_spawn_args args = {
+		.path = path,
+		.argv = argv,
+		.envp = envp ? envp : environ,
+		.file_actions = file_actions ? file_actions->actions : NULL,
+		.num_file_actions = file_actions ? file_actions->count : 0,
+		.flags = attrp ? attrp->flags : 0,
+		.pgroup = attrp ? attrp->pgroup : 0,
+		.pid_p = pid
+	};
+	if(syscall2(SYS_POSIX_SPAWN, (int) &args) < 0)
+		return errno;
+	return 0;
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attrp, char* const argv[], char* const envp[]) {
+	// If the path contains a slash, ignore the path
+	if(strchr(file, '/'))
+		return posix_spawn(pid, file, file_actions, attrp, argv, envp);
+
+	// Get the path
+	char* path = getenv("PATH");
+	if(!path)
+		path = DEFAULT_PATH;
+	path = strdup(path);
+
+	// Try each element of path
+	int res = ENOENT;
+	char* path_elem = strtok(path, ":");
+	while(path_elem) {
+		// Create a string with the full path of the executable
+		size_t path_len = strlen(path_elem);
+		char* full_path = malloc(path_len + strlen(file) + 2);
+		strcpy(full_path, path_elem);
+		full_path[path_len] = '/';
+		strcpy(full_path + path_len + 1, file);
+
+		// Try spawning it
+		res = posix_spawn(pid, full_path, file_actions, attrp, argv, envp);
+		free(full_path);
+		if(res != ENOENT)
+			break;
+		path_elem = strtok(NULL, ":");
+	}
+
+	free(path);
+	return res;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* file_actions) {
+	file_actions->actions = NULL;
+	file_actions->count = 0;
+	file_actions->capacity = 0;
+	return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* file_actions) {
+	for(size_t i = 0; i < file_actions->count; i++)
+		free((void*) file_actions->actions[i].path);
+	free(file_actions->actions);
+	return posix_spawn_file_actions_init(file_actions);
+}
+
+static int add_file_action(posix_spawn_file_actions_t* file_actions, struct posix_spawn_file_action action) {
+	if(action.fd < 0)
+		return EBADF;
+	if(file_actions->count == file_actions->capacity) {
+		size_t new_capacity = file_actions->capacity ? file_actions->capacity * 2 : 4;
+		void* new_actions = realloc(file_actions->actions, new_capacity * sizeof(struct posix_spawn_file_action));
+		if(!new_actions)
+			return ENOMEM;
+		file_actions->actions = new_actions;
+		file_actions->capacity = new_capacity;
+	}
+	file_actions->actions[file_actions->count++] = action;
+	return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* file_actions, int fd, const char* path, int oflag, mode_t mode) {
+	char* path_copy = strdup(path);
+	if(!path_copy)
+		return ENOMEM;
+	struct posix_spawn_file_action action = {
+		.type = POSIX_SPAWN_FILE_ACTION_OPEN,
+		.fd = fd,
+		.newfd = -1,
+		.path = path_copy,
+		.oflag = oflag,
+		.mode = mode
+	};
+	int res = add_file_action(file_actions, action);
+	if(res)
+		free(path_copy);
+	return res;
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* file_actions, int fd) {
+	struct posix_spawn_file_action action = {
+		.type = POSIX_SPAWN_FILE_ACTION_CLOSE,
+		.fd = fd,
+		.newfd = -1,
+		.path = NULL
+	};
+	return add_file_action(file_actions, action);
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* file_actions, int fd, int newfd) {
+	if(newfd < 0)
+		return EBADF;
+	struct posix_spawn_file_action action = {
+		.type = POSIX_SPAWN_FILE_ACTION_DUP2,
+		.fd = fd,
+		.newfd = newfd,
+		.path = NULL
+	};
+	return add_file_action(file_actions, action);
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr) {
+	attr->flags = 0;
+	attr->pgroup = 0;
+	return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t* attr) {
+	return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags) {
+	*flags = attr->flags;
+	return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags) {
+	if(flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSID))
+		return EINVAL;
+	attr->flags = flags;
+	return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t* attr, pid_t* pgroup) {
+	*pgroup = attr->pgroup;
+	return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t* attr, pid_t pgroup) {
+	attr->pgroup = pgroup;
+	return 0;
+}
@@ -38,7 +38,9 @@
 //typedef	unsigned long	uintptr_t;
 
 //This lets you prefix malloc and friends
+#ifndef __DUCKOS_LIBALLOC_PREFIX
 #define __DUCKOS_LIBALLOC_PREFIX(func) func
+#endif
 
 #ifdef __cplusplus
 extern "C" {
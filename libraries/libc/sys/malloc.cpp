@@ -0,0 +1,433 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "malloc.h"
+#include "mman.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <libc/stdio.h>
+#include <libduck/SpinLock.h>
+#include <kernel/api/page_size.h>
+
+/**
+ * A size-class based allocator.
+ *
+ * Small allocations are rounded up to one of a fixed set of size classes. Each size class carves its objects out of
+ * spans, which are runs of pages mmap'd from the kernel that only hold objects of that class. Spans are mapped with
+ * MAP_NORESERVE, so their pages are only allocated once objects are carved out of them. Freed objects are kept
+ * in one of several caches, which hand them out again without touching the spans at all. When a cache holds too many
+ * objects of a class, a batch of them is returned to the central free list of the class, and when a cache runs out,
+ * it takes a batch from the central free list. Spans that become completely free give their pages back to the kernel
+ * with madvise(MADV_DONTNEED), and are unmapped entirely if the class already has enough empty spans.
+ *
+ * Large allocations get their own mapping, which is resized with mremap() on realloc and unmapped when freed.
+ *
+ * There's no thread-local storage, so a cache is picked by hashing the stack pointer. Every thread has its own stack,
+ * so threads usually end up with a cache to themselves and the cache's lock is uncontended.
+ */
+
+#define MALLOC_ALIGNMENT 16
+#define MALLOC_NUM_CACHES 8
+#define MALLOC_MIN_SPAN_PAGES 16
+#define MALLOC_MIN_SPAN_OBJECTS 8
+#define MALLOC_MAX_EMPTY_SPANS 2
+#define MALLOC_MAX_BATCH 32
+#define MALLOC_SPAN_MAGIC 0xc001d00d
+#define MALLOC_DEAD_MAGIC 0xdeaddead
+#define MALLOC_THREAD_STACK_SHIFT 20
+
+namespace {
+	constexpr size_t s_size_classes[] = {
+		16, 32, 48, 64, 80, 96, 112, 128,
+		160, 192, 224, 256, 320, 384, 448, 512,
+		640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+		2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+		10240, 12288, 14336, 16384
+	};
+	constexpr size_t NUM_SIZE_CLASSES = sizeof(s_size_classes) / sizeof(s_size_classes[0]);
+	constexpr size_t MAX_SMALL_SIZE = s_size_classes[NUM_SIZE_CLASSES - 1];
+
+	struct FreeObject {
+		FreeObject* next;
+	};
+
+	/** The header at the beginning of every span and every large allocation. **/
+	struct Span {
+		uint32_t magic;
+		bool is_large;
+		bool in_list;
+		uint16_t size_class;
+		size_t num_pages;
+		size_t object_size; ///< The size of each object, or the usable size of a large allocation.
+		size_t capacity; ///< The number of objects that fit in the span.
+		size_t num_used; ///< The number of objects that are allocated or sitting in a cache.
+		uintptr_t bump; ///< The next object in the span that has never been handed out.
+		uintptr_t end;
+		FreeObject* free_list;
+		Span* prev;
+		Span* next;
+	};
+
+	constexpr size_t SPAN_HEADER_SIZE = (sizeof(Span) + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1);
+
+	/** The spans of a size class that have free objects in them. **/
+	struct CentralList {
+		Duck::SpinLock lock;
+		Span* spans;
+		size_t num_empty;
+	};
+
+	struct ClassCache {
+		FreeObject* head;
+		size_t count;
+	};
+
+	struct Cache {
+		Duck::SpinLock lock;
+		ClassCache classes[NUM_SIZE_CLASSES];
+	};
+
+	CentralList s_central[NUM_SIZE_CLASSES];
+	Cache s_caches[MALLOC_NUM_CACHES];
+
+	/**
+	 * Maps every page that belongs to a span to that span. The first level is indexed by the top 10 bits of the page
+	 * number, and the second level (allocated on demand) by the bottom 10 bits.
+	 */
+	Span** s_pagemap[1024];
+	Duck::SpinLock s_pagemap_lock;
+
+	inline size_t size_class_for(size_t size) {
+		size_t lo = 0;
+		size_t hi = NUM_SIZE_CLASSES - 1;
+		while(lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if(s_size_classes[mid] < size)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	inline size_t batch_size(size_t size_class) {
+		size_t batch = 32768 / s_size_classes[size_class];
+		if(batch < 2)
+			return 2;
+		if(batch > MALLOC_MAX_BATCH)
+			return MALLOC_MAX_BATCH;
+		return batch;
+	}
+
+	inline Cache& current_cache() {
+		auto stack = (uintptr_t) __builtin_frame_address(0);
+		return s_caches[(stack >> MALLOC_THREAD_STACK_SHIFT) % MALLOC_NUM_CACHES];
+	}
+
+	inline Span* span_for(void* ptr) {
+		auto page = (uintptr_t) ptr / PAGE_SIZE;
+		auto* leaf = __atomic_load_n(&s_pagemap[page >> 10], __ATOMIC_ACQUIRE);
+		if(!leaf)
+			return nullptr;
+		auto* span = leaf[page & 1023];
+		if(!span || span->magic != MALLOC_SPAN_MAGIC)
+			return nullptr;
+		return span;
+	}
+
+	bool set_pagemap(Span* span, size_t num_pages, Span* value) {
+		LOCK(s_pagemap_lock);
+		auto start_page = (uintptr_t) span / PAGE_SIZE;
+		for(size_t page = start_page; page < start_page + num_pages; page++) {
+			auto*& leaf = s_pagemap[page >> 10];
+			if(!leaf) {
+				auto* new_leaf = mmap_named(NULL, 1024 * sizeof(Span*), PROT_READ | PROT_WRITE, MAP_ANONYMOUS, 0, 0, "heap pagemap");
+				if(new_leaf == MAP_FAILED)
+					return false;
+				__atomic_store_n(&leaf, (Span**) new_leaf, __ATOMIC_RELEASE);
+			}
+			leaf[page & 1023] = value;
+		}
+		return true;
+	}
+
+	Span* map_span(size_t num_pages) {
+		// Only the pages that get touched are allocated, so a span that's mostly unused doesn't cost much memory
+		auto* mem = mmap_named(NULL, num_pages * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_NORESERVE, 0, 0, "heap");
+		if(mem == MAP_FAILED)
+			return nullptr;
+		auto* span = (Span*) mem;
+		span->magic = MALLOC_SPAN_MAGIC;
+		span->num_pages = num_pages;
+		return span;
+	}
+
+	void unmap_span(Span* span) {
+		span->magic = MALLOC_DEAD_MAGIC;
+		set_pagemap(span, span->is_large ? 1 : span->num_pages, nullptr);
+		if(munmap(span, span->num_pages * PAGE_SIZE) < 0)
+			fprintf(stderr, "malloc: Failed to unmap span at %p\n", span);
+	}
+
+	void list_insert(CentralList& central, Span* span) {
+		span->prev = nullptr;
+		span->next = central.spans;
+		if(central.spans)
+			central.spans->prev = span;
+		central.spans = span;
+		span->in_list = true;
+	}
+
+	void list_remove(CentralList& central, Span* span) {
+		if(span->prev)
+			span->prev->next = span->next;
+		else
+			central.spans = span->next;
+		if(span->next)
+			span->next->prev = span->prev;
+		span->prev = nullptr;
+		span->next = nullptr;
+		span->in_list = false;
+	}
+
+	/** Allocates a new span for a size class. Must be called with the central list of the class locked. **/
+	Span* alloc_small_span(size_t size_class) {
+		size_t object_size = s_size_classes[size_class];
+		size_t num_pages = (SPAN_HEADER_SIZE + object_size * MALLOC_MIN_SPAN_OBJECTS + PAGE_SIZE - 1) / PAGE_SIZE;
+		if(num_pages < MALLOC_MIN_SPAN_PAGES)
+			num_pages = MALLOC_MIN_SPAN_PAGES;
+
+		auto* span = map_span(num_pages);
+		if(!span)
+			return nullptr;
+		span->is_large = false;
+		span->in_list = false;
+		span->size_class = size_class;
+		span->object_size = object_size;
+		span->capacity = (num_pages * PAGE_SIZE - SPAN_HEADER_SIZE) / object_size;
+		span->num_used = 0;
+		span->bump = (uintptr_t) span + SPAN_HEADER_SIZE;
+		span->end = (uintptr_t) span + num_pages * PAGE_SIZE;
+		span->free_list = nullptr;
+		if(!set_pagemap(span, num_pages, span)) {
+			unmap_span(span);
+			return nullptr;
+		}
+		return span;
+	}
+
+	/**
+	 * Called when every object in a span has been freed. Gives the span's pages (other than the one holding the
+	 * header) back to the kernel, or unmaps the span if its class already has enough empty spans lying around.
+	 * Must be called with the central list of the class locked.
+	 */
+	void release_span(CentralList& central, Span* span) {
+		if(central.num_empty >= MALLOC_MAX_EMPTY_SPANS) {
+			list_remove(central, span);
+			unmap_span(span);
+			return;
+		}
+
+		central.num_empty++;
+		span->free_list = nullptr;
+		span->bump = (uintptr_t) span + SPAN_HEADER_SIZE;
+		if(span->num_pages > 1)
+			madvise((void*) ((uintptr_t) span + PAGE_SIZE), (span->num_pages - 1) * PAGE_SIZE, MADV_DONTNEED);
+	}
+
+	/** Moves up to a batch of objects from the central list of a class into a cache. **/
+	void refill_cache(ClassCache& cache, size_t size_class) {
+		auto& central = s_central[size_class];
+		size_t batch = batch_size(size_class);
+		LOCK(central.lock);
+		while(cache.count < batch) {
+			auto* span = central.spans;
+			if(!span) {
+				span = alloc_small_span(size_class);
+				if(!span)
+					return;
+				list_insert(central, span);
+				central.num_empty++;
+			}
+
+			if(!span->num_used)
+				central.num_empty--;
+
+			while(cache.count < batch && span->num_used < span->capacity) {
+				FreeObject* object;
+				if(span->free_list) {
+					object = span->free_list;
+					span->free_list = object->next;
+				} else {
+					object = (FreeObject*) span->bump;
+					span->bump += span->object_size;
+				}
+				object->next = cache.head;
+				cache.head = object;
+				cache.count++;
+				span->num_used++;
+			}
+
+			if(span->num_used == span->capacity)
+				list_remove(central, span);
+		}
+	}
+
+	/** Returns a batch of objects from a cache to the central list of their class. **/
+	void drain_cache(ClassCache& cache, size_t size_class, size_t count) {
+		auto& central = s_central[size_class];
+		LOCK(central.lock);
+		while(count-- && cache.head) {
+			auto* object = cache.head;
+			cache.head = object->next;
+			cache.count--;
+
+			auto* span = span_for(object);
+			object->next = span->free_list;
+			span->free_list = object;
+			if(!span->in_list)
+				list_insert(central, span);
+			if(!--span->num_used)
+				release_span(central, span);
+		}
+	}
+
+	void* alloc_large(size_t size) {
+		if(size > SIZE_MAX - SPAN_HEADER_SIZE - PAGE_SIZE)
+			return nullptr;
+		size_t num_pages = (size + SPAN_HEADER_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+		auto* span = map_span(num_pages);
+		if(!span)
+			return nullptr;
+		span->is_large = true;
+		span->in_list = false;
+		span->object_size = num_pages * PAGE_SIZE - SPAN_HEADER_SIZE;
+		if(!set_pagemap(span, 1, span)) {
+			unmap_span(span);
+			return nullptr;
+		}
+		return (void*) ((uintptr_t) span + SPAN_HEADER_SIZE);
+	}
+
+	/** Resizes a large allocation by remapping its pages, so its contents never have to be copied. **/
+	void* realloc_large(Span* span, size_t size) {
+		if(size > SIZE_MAX - SPAN_HEADER_SIZE - PAGE_SIZE)
+			return nullptr;
+		size_t num_pages = (size + SPAN_HEADER_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+		if(num_pages != span->num_pages) {
+			auto* mem = mremap(span, span->num_pages * PAGE_SIZE, num_pages * PAGE_SIZE, MREMAP_MAYMOVE);
+			if(mem == MAP_FAILED)
+				return nullptr;
+			if(mem != span) {
+				set_pagemap(span, 1, nullptr);
+				span = (Span*) mem;
+				if(!set_pagemap(span, 1, span))
+					fprintf(stderr, "malloc: Failed to register moved allocation at %p\n", span);
+			}
+			span->num_pages = num_pages;
+			span->object_size = num_pages * PAGE_SIZE - SPAN_HEADER_SIZE;
+		}
+		return (void*) ((uintptr_t) span + SPAN_HEADER_SIZE);
+	}
+}
+
+void* malloc(size_t size) {
+	if(size > MAX_SMALL_SIZE) {
+		auto* ret = alloc_large(size);
+		if(!ret)
+			errno = ENOMEM;
+		return ret;
+	}
+
+	size_t size_class = size_class_for(size);
+	auto& cache = current_cache();
+	LOCK(cache.lock);
+	auto& class_cache = cache.classes[size_class];
+	if(!class_cache.head) {
+		refill_cache(class_cache, size_class);
+		if(!class_cache.head) {
+			errno = ENOMEM;
+			return nullptr;
+		}
+	}
+
+	auto* object = class_cache.head;
+	class_cache.head = object->next;
+	class_cache.count--;
+	return object;
+}
+
+void free(void* ptr) {
+	if(!ptr)
+		return;
+
+	auto* span = span_for(ptr);
+	if(!span) {
+		fprintf(stderr, "malloc: Bad free(%p) called from %p\n", ptr, __builtin_return_address(0));
+		return;
+	}
+
+	if(span->is_large) {
+		unmap_span(span);
+		return;
+	}
+
+	size_t size_class = span->size_class;
+	auto& cache = current_cache();
+	LOCK(cache.lock);
+	auto& class_cache = cache.classes[size_class];
+	auto* object = (FreeObject*) ptr;
+	object->next = class_cache.head;
+	class_cache.head = object;
+	class_cache.count++;
+
+	size_t batch = batch_size(size_class);
+	if(class_cache.count > batch * 2)
+		drain_cache(class_cache, size_class, batch);
+}
+
+void* calloc(size_t nobj, size_t size) {
+	if(size && nobj > SIZE_MAX / size) {
+		errno = ENOMEM;
+		return nullptr;
+	}
+	auto* ret = malloc(nobj * size);
+	if(ret)
+		memset(ret, 0, nobj * size);
+	return ret;
+}
+
+void* realloc(void* ptr, size_t size) {
+	if(!ptr)
+		return malloc(size);
+	if(!size) {
+		free(ptr);
+		return nullptr;
+	}
+
+	auto* span = span_for(ptr);
+	if(!span) {
+		fprintf(stderr, "malloc: Bad realloc(%p) called from %p\n", ptr, __builtin_return_address(0));
+		return nullptr;
+	}
+
+	// If the allocation is still a good fit, keep it where it is
+	size_t old_size = span->object_size;
+	if(size <= old_size && !span->is_large && size_class_for(size) == span->size_class)
+		return ptr;
+
+	if(span->is_large && size > MAX_SMALL_SIZE) {
+		auto* ret = realloc_large(span, size);
+		if(!ret)
+			errno = ENOMEM;
+		return ret;
+	}
+
+	auto* new_ptr = malloc(size);
+	if(!new_ptr)
+		return nullptr;
+	memcpy(new_ptr, ptr, size < old_size ? size : old_size);
+	free(ptr);
+	return new_ptr;
+}
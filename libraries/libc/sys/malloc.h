@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "cdefs.h"
+#include <stddef.h>
+
+__DECL_BEGIN
+
+void* malloc(size_t size);
+void* calloc(size_t nobj, size_t size);
+void* realloc(void* ptr, size_t size);
+void free(void* ptr);
+
+__DECL_END
@@ -23,4 +23,24 @@ int munmap(void* addr, size_t length) {
 
 int mprotect(void *addr, size_t len, int prot) {
 	return syscall4(SYS_MPROTECT, (int) addr, (int) len, prot);
-}
\ No newline at end of file
+}
+
+int madvise(void* addr, size_t length, int advice) {
+	return syscall4(SYS_MADVISE, (int) addr, (int) length, advice);
+}
+
+int mlock(const void* addr, size_t len) {
+	return syscall3(SYS_MLOCK, (int) addr, (int) len);
+}
+
+int munlock(const void* addr, size_t len) {
+	return syscall3(SYS_MUNLOCK, (int) addr, (int) len);
+}
+
+void* mremap(void* old_address, size_t old_size, size_t new_size, int flags) {
+	void* ret;
+	struct mremap_args args = { old_address, old_size, new_size, flags, &ret };
+	if (syscall2(SYS_MREMAP, (int) &args) == -1)
+		return MAP_FAILED;
+	return ret;
+}
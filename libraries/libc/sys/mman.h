@@ -11,4 +11,8 @@ void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
 void* mmap_named(void* addr, size_t length, int prot, int flags, int fd, off_t offset, const char* name);
 int munmap(void* addr, size_t length);
 int mprotect(void *addr, size_t len, int prot);
+int madvise(void* addr, size_t length, int advice);
+int mlock(const void* addr, size_t len);
+int munlock(const void* addr, size_t len);
+void* mremap(void* old_address, size_t old_size, size_t new_size, int flags);
 __DECL_END
\ No newline at end of file
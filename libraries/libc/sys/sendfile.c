@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include "sendfile.h"
+#include "syscall.h"
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+	struct sendfile_args args = {out_fd, in_fd, offset, count};
+	return syscall2(SYS_SENDFILE, (int) &args);
+}
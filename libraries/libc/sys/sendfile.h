@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "cdefs.h"
+#include <kernel/api/sendfile.h>
+
+__DECL_BEGIN
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+__DECL_END
@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 struct socketfs_packet* read_packet(int fd) {
 	struct socketfs_packet packet_header;
@@ -45,14 +46,26 @@ struct socketfs_packet* read_packet(int fd) {
 }
 
 int write_packet_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, size_t length, void* data) {
-	struct socketfs_packet* packet = malloc(sizeof(struct socketfs_packet) + length);
-	packet->type = SOCKETFS_TYPE_MSG;
-	packet->recipient = id;
-	packet->length = length;
-	packet->shm_id = shm_id;
-	packet->shm_perms = shm_perms;
-	memcpy(packet->data, data, length);
-	int ret = write(fd, packet, length);
-	free(packet);
-	return ret;
+	struct iovec iov = {data, length};
+	return write_packetv_of_type(fd, type, id, shm_id, shm_perms, &iov, 1);
+}
+
+int write_packetv_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, const struct iovec* iov, int iovcnt) {
+	//The header and each part of the data are written together, so they arrive as one packet without being copied into one buffer first
+	struct socketfs_packet packet;
+	packet.type = type;
+	packet.recipient = id;
+	packet.length = 0;
+	packet.shm_id = shm_id;
+	packet.shm_perms = shm_perms;
+
+	struct iovec packet_iov[iovcnt + 1];
+	packet_iov[0].iov_base = &packet;
+	packet_iov[0].iov_len = sizeof(struct socketfs_packet);
+	for(int i = 0; i < iovcnt; i++) {
+		packet_iov[i + 1] = iov[i];
+		packet.length += iov[i].iov_len;
+	}
+
+	return writev(fd, packet_iov, iovcnt + 1);
 }
\ No newline at end of file
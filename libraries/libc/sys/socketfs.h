@@ -21,6 +21,7 @@
 #define DUCKOS_LIBC_SOCKETFS_H
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <kernel/filesystem/socketfs/socketfs_defines.h>
 
 struct socketfs_packet {
@@ -51,6 +52,12 @@ __DECL_BEGIN
 struct socketfs_packet* read_packet(int fd);
 
 int write_packet_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, size_t length, void* data);
+/** Writes a packet whose data is made up of each of the given buffers in turn. **/
+int write_packetv_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, const struct iovec* iov, int iovcnt);
+
+inline int write_packetv(int fd, sockid_t id, const struct iovec* iov, int iovcnt) {
+	return write_packetv_of_type(fd, SOCKETFS_TYPE_MSG, id, 0, 0, iov, iovcnt);
+}
 
 inline int write_packet(int fd, sockid_t id, size_t length, void* data) {
 	return write_packet_of_type(fd, SOCKETFS_TYPE_MSG, id, 0, 0, length, data);
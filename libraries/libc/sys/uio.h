@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#pragma once
+
+#include "cdefs.h"
+#include <kernel/api/uio.h>
+
+__DECL_BEGIN
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+ssize_t preadv(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+ssize_t pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+
+__DECL_END
@@ -21,6 +21,8 @@
 #include <assert.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <kernel/api/sendfile.h>
 #include <termios.h>
 #include <stdlib.h>
 #include <string.h>
@@ -155,7 +157,8 @@ ssize_t read(int fd, void* buf, size_t count) {
 }
 
 ssize_t pread(int fd, void* buf, size_t count, off_t offset) {
-	return -1;
+	struct pread_args args = {fd, buf, count, offset};
+	return syscall2(SYS_PREAD, (int) &args);
 }
 
 ssize_t write(int fd, const void* buf, size_t count) {
@@ -163,7 +166,13 @@ ssize_t write(int fd, const void* buf, size_t count) {
 }
 
 ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) {
-	return -1;
+	struct pread_args args = {fd, (void*) buf, count, offset};
+	return syscall2(SYS_PWRITE, (int) &args);
+}
+
+ssize_t copy_file_range(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags) {
+	struct copy_file_range_args args = {fd_in, off_in, fd_out, off_out, len, flags};
+	return syscall2(SYS_COPY_FILE_RANGE, (int) &args);
 }
 
 off_t lseek(int fd, off_t off, int whence) {
@@ -178,6 +187,18 @@ int ftruncate(int fd, off_t length) {
 	return syscall3(SYS_FTRUNCATE, fd, length);
 }
 
+int fsync(int fd) {
+	return syscall2(SYS_FSYNC, fd);
+}
+
+int fdatasync(int fd) {
+	return syscall2(SYS_FDATASYNC, fd);
+}
+
+void sync() {
+	syscall(SYS_SYNC);
+}
+
 int close(int fd) {
 	return syscall2(SYS_CLOSE, fd);
 }
@@ -19,6 +19,8 @@
 
 #include "SharedBuffer.h"
 #include "Log.h"
+#include <sys/mman.h>
+#include <kernel/api/page_size.h>
 using namespace Duck;
 
 ResultRet<Duck::Ptr<SharedBuffer>> SharedBuffer::alloc(size_t size, std::string name) {
@@ -52,6 +54,15 @@ ResultRet<Duck::Ptr<SharedBuffer>> SharedBuffer::copy(std::string name) const {
 	return std::move(cpy_res.value());
 }
 
+Result SharedBuffer::resize(size_t new_size) {
+	auto* new_ptr = mremap(m_shm.ptr, m_shm.size, new_size, MREMAP_MAYMOVE);
+	if(new_ptr == MAP_FAILED)
+		return Result(errno);
+	m_shm.ptr = new_ptr;
+	m_shm.size = ((new_size + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+	return Result::SUCCESS;
+}
+
 int SharedBuffer::allow(int pid, bool read, bool write) {
 	return shmallow(m_shm.id, pid, (read ? SHM_READ : 0) | (write ? SHM_WRITE : 0));
 }
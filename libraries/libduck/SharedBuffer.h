@@ -38,6 +38,14 @@ namespace Duck {
 		[[nodiscard]] ResultRet<Duck::Ptr<SharedBuffer>> copy(std::string name) const;
 		int allow(int pid, bool read = true, bool write = true);
 
+		/**
+		 * Resizes the buffer by remapping it, without copying its contents. The buffer may move in memory.
+		 * Only the creator of the buffer can grow it past its current size. Other processes attached to the buffer
+		 * keep their old mapping until they resize it themselves.
+		 * @param new_size The new size of the buffer.
+		 */
+		Result resize(size_t new_size);
+
 		[[nodiscard]] void* ptr() const { return m_shm.ptr; }
 		[[nodiscard]] size_t size() const { return m_shm.size; }
 		[[nodiscard]] int id() const { return m_shm.id; }
@@ -21,6 +21,7 @@
 #include "Window.h"
 #include <cstdio>
 #include <sys/shm.h>
+#include <sys/mman.h>
 #include <libgraphics/Font.h>
 #include <utility>
 #include <libriver/river.h>
@@ -221,10 +222,22 @@ void Context::handle_window_resized(const WindowResizedPkt& pkt, Event& event) {
 			struct shm shm;
 			if(shmattach(pkt.shm_id, NULL, &shm) < 0) {
 				Log::errf("libpond: Failed to attach window shm on resize!");
-				event.window_create.window = NULL;
+				event.window_resize.window = NULL;
 				return;
 			}
 			window->_shm = shm;
+		} else if(window->_shm.size < IMGSIZE(pkt.rect.width, pkt.rect.height) * 2) {
+			// The framebuffer was grown in place, so grow our mapping of it to match. Like shmattach, keep the size
+			// of the mapping itself, which is rounded up to a whole page.
+			size_t new_size = ((IMGSIZE(pkt.rect.width, pkt.rect.height) * 2 + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+			auto* new_ptr = mremap(window->_shm.ptr, window->_shm.size, new_size, MREMAP_MAYMOVE);
+			if(new_ptr == MAP_FAILED) {
+				Log::errf("libpond: Failed to remap window shm on resize!");
+				event.window_resize.window = NULL;
+				return;
+			}
+			window->_shm.ptr = new_ptr;
+			window->_shm.size = new_size;
 		}
 	} else {
 		event.type = PEVENT_UNKNOWN;
@@ -145,27 +145,25 @@ Duck::ResultRet<RiverPacket> River::receive_packet(int fd, bool block)  {
 
 Result River::send_packet(int fd, sockid_t recipient, const RiverPacket& packet) {
 	auto full_name = packet.endpoint + ":" + packet.path;
-	size_t n_bytes = full_name.length() + 1 + packet.data.size();
 
-	auto* raw_packet = (RawPacket*) malloc(sizeof(RawPacket) + n_bytes);
-	raw_packet->__river_magic = LIBRIVER_PACKET_MAGIC;
-	raw_packet->type = packet.type;
-	raw_packet->error = packet.error;
-	raw_packet->data_length = packet.data.size();
-	raw_packet->path_length = full_name.length() + 1;
-	raw_packet->id = packet.recipient;
-
-	memcpy(raw_packet->data, full_name.c_str(), full_name.length() + 1);
-	if(!packet.data.empty())
-		memcpy(raw_packet->data + full_name.length() + 1, packet.data.data(), packet.data.size());
-
-	if(::write_packet(fd, recipient, sizeof(RawPacket) + n_bytes, raw_packet)) {
+	RawPacket raw_packet;
+	raw_packet.type = packet.type;
+	raw_packet.error = packet.error;
+	raw_packet.data_length = packet.data.size();
+	raw_packet.path_length = full_name.length() + 1;
+	raw_packet.id = packet.recipient;
+
+	//Send the header, path, and data straight from where they are instead of copying them into one buffer
+	struct iovec iov[] = {
+		{&raw_packet, sizeof(RawPacket)},
+		{(void*) full_name.c_str(), full_name.length() + 1},
+		{(void*) packet.data.data(), packet.data.size()}
+	};
+	if(::write_packetv(fd, recipient, iov, packet.data.empty() ? 2 : 3)) {
 		if (errno != ENOSPC)
 			Log::err("[River] Error writing packet: ", strerror(errno));
-		free(raw_packet);
 		return Result(errno);
 	}
 
-	free(raw_packet);
 	return Result::SUCCESS;
 }
\ No newline at end of file
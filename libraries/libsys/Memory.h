@@ -36,6 +36,7 @@ namespace Sys::Mem {
 		Amount kernel_phys;
 		Amount kernel_heap;
 		Amount kernel_disk_cache;
+		Amount kernel_disk_cache_dirty;
 
 		inline double used_frac() const {
 			return (double)((long double) used / (long double) usable);
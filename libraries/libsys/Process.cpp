@@ -103,6 +103,9 @@ Result Process::update() {
 	_physical_mem = {std::stoul(proc["pmem"])};
 	_virtual_mem = {std::stoul(proc["vmem"])};
 	_shared_mem = {std::stoul(proc["shmem"])};
+	_resident_mem = {std::stoul(proc["rss"])};
+	_proportional_mem = {std::stoul(proc["pss"])};
+	_resident_shared_mem = {std::stoul(proc["rss_shared"])};
 
 	return Result::SUCCESS;
 }
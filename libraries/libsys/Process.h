@@ -50,6 +50,9 @@ namespace Sys {
 		Mem::Amount physical_mem() const { return _physical_mem; }
 		Mem::Amount virtual_mem() const { return _virtual_mem; }
 		Mem::Amount shared_mem() const { return _shared_mem; }
+		Mem::Amount resident_mem() const { return _resident_mem; }
+		Mem::Amount proportional_mem() const { return _proportional_mem; }
+		Mem::Amount resident_shared_mem() const { return _resident_shared_mem; }
 
 		Duck::ResultRet<App::Info> app_info() const;
 
@@ -65,6 +68,9 @@ namespace Sys {
 		Mem::Amount _physical_mem;
 		Mem::Amount _virtual_mem;
 		Mem::Amount _shared_mem;
+		Mem::Amount _resident_mem;
+		Mem::Amount _proportional_mem;
+		Mem::Amount _resident_shared_mem;
 	};
 }
 
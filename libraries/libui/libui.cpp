@@ -20,7 +20,8 @@
 #include "libui.h"
 #include "Theme.h"
 #include "UIException.h"
-#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 #include <map>
 #include <utility>
 #include <libduck/Config.h>
@@ -28,8 +29,11 @@
 
 using namespace UI;
 
+/** The most events handled each time UI::update() waits for them. **/
+#define UI_MAX_EVENTS 16
+
 Pond::Context* UI::pond_context = nullptr;
-std::vector<pollfd> pollfds;
+int epoll_fd = -1;
 std::map<int, Poll> polls;
 std::map<int, std::shared_ptr<Window>> windows;
 int cur_timeout = 0;
@@ -42,7 +46,10 @@ void handle_pond_events();
 
 void UI::init(char** argv, char** envp) {
 	pond_context = Pond::Context::init();
-	pollfds.clear();
+	if(epoll_fd >= 0)
+		close(epoll_fd);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	polls.clear();
 
 	auto app_res = App::Info::from_current_app();
 	if(app_res.has_value()) {
@@ -204,16 +211,18 @@ void UI::update(int timeout) {
 			window.second->repaint_now();
 	}
 
-	//Read and process events
-	poll(pollfds.data(), pollfds.size(), timeout);
-	for(auto& pollfd : pollfds) {
-		if(pollfd.revents) {
-			auto& poll = polls[pollfd.fd];
-			if(poll.on_ready_to_read && pollfd.revents & POLLIN)
-				poll.on_ready_to_read();
-			if(poll.on_ready_to_write && pollfd.revents & POLLOUT)
-				poll.on_ready_to_write();
-		}
+	//Read and process events for every file descriptor that's ready
+	epoll_event events[UI_MAX_EVENTS];
+	int num_events = epoll_wait(epoll_fd, events, UI_MAX_EVENTS, timeout);
+	for(int i = 0; i < num_events; i++) {
+		auto poll_it = polls.find(events[i].data.fd);
+		if(poll_it == polls.end())
+			continue;
+		auto poll = poll_it->second;
+		if(poll.on_ready_to_read && events[i].events & EPOLLIN)
+			poll.on_ready_to_read();
+		if(poll.on_ready_to_write && events[i].events & EPOLLOUT)
+			poll.on_ready_to_write();
 	}
 }
 
@@ -252,13 +261,14 @@ App::Info& UI::app_info() {
 void UI::add_poll(const Poll& poll) {
 	if(!poll.on_ready_to_read && !poll.on_ready_to_write)
 		return;
-	pollfd pfd = {.fd = poll.fd, .events = 0, .revents = 0};
+	epoll_event event = {.events = 0, .data = {.fd = poll.fd}};
 	if(poll.on_ready_to_read)
-		pfd.events |= POLLIN;
+		event.events |= EPOLLIN;
 	if(poll.on_ready_to_write)
-		pfd.events |= POLLOUT;
+		event.events |= EPOLLOUT;
+	bool exists = polls.find(poll.fd) != polls.end();
 	polls[poll.fd] = poll;
-	pollfds.push_back(pfd);
+	epoll_ctl(epoll_fd, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, poll.fd, &event);
 }
 
 Duck::Ptr<const Gfx::Image> UI::icon(Duck::Path path) {
@@ -58,6 +58,9 @@ void ProcessInspectorWidget::initialize() {
 		stack->add_child(m_memory_phys = UI::Label::make("", UI::BEGINNING));
 		stack->add_child(m_memory_virt = UI::Label::make("", UI::BEGINNING));
 		stack->add_child(m_memory_shared = UI::Label::make("", UI::BEGINNING));
+		stack->add_child(m_memory_resident = UI::Label::make("", UI::BEGINNING));
+		stack->add_child(m_memory_proportional = UI::Label::make("", UI::BEGINNING));
+		stack->add_child(m_memory_resident_shared = UI::Label::make("", UI::BEGINNING));
 		add_child(UI::NamedCell::make("Memory", stack));
 	}
 
@@ -73,4 +76,7 @@ void ProcessInspectorWidget::update() {
 	m_memory_phys->set_label("Physical: " + m_process.physical_mem().readable());
 	m_memory_virt->set_label("Virtual: " + m_process.virtual_mem().readable());
 	m_memory_shared->set_label("Shared: " + m_process.shared_mem().readable());
+	m_memory_resident->set_label("Resident: " + m_process.resident_mem().readable());
+	m_memory_proportional->set_label("Proportional: " + m_process.proportional_mem().readable());
+	m_memory_resident_shared->set_label("Resident (shared): " + m_process.resident_shared_mem().readable());
 }
\ No newline at end of file
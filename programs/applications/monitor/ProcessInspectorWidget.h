@@ -33,4 +33,7 @@ private:
 	Duck::Ptr<UI::Label> m_memory_phys;
 	Duck::Ptr<UI::Label> m_memory_virt;
 	Duck::Ptr<UI::Label> m_memory_shared;
+	Duck::Ptr<UI::Label> m_memory_resident;
+	Duck::Ptr<UI::Label> m_memory_proportional;
+	Duck::Ptr<UI::Label> m_memory_resident_shared;
 };
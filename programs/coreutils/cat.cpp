@@ -22,6 +22,7 @@
 #include <libduck/File.h>
 #include <libduck/Args.h>
 #include <libduck/Stream.h>
+#include <sys/sendfile.h>
 
 using Duck::File, Duck::Args, Duck::Stream, Duck::ResultRet;
 
@@ -43,8 +44,18 @@ int main(int argc, char** argv) {
 		file = res.value();
 	}
 
+	//Have the kernel copy the file straight to stdout if it can
+	ssize_t sent;
+	while((sent = sendfile(File::std_out.fd(), file.fd(), nullptr, 1024 * 1024)) > 0);
+	if(sent == 0)
+		return 0;
+	if(errno != EINVAL) {
+		Stream::std_err << "cat: Couldn't write: " << strerror(errno) << "\n";
+		return errno;
+	}
+
+	//Otherwise (if it isn't a regular file), copy it ourselves
 	char buf[512];
-	bool eof = false;
 	while(true) {
 		auto read_res = read(file.fd(), buf, 512);
 		if(read_res < 0) {
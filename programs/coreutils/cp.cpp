@@ -28,6 +28,8 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
 int main(int argc, char** argv) {
 	if(argc < 3) {
 		printf("Missing operands\nUsage: cp FILE NEWFILE\n");
@@ -54,24 +56,36 @@ int main(int argc, char** argv) {
 
 	errno = 0;
 
-	ssize_t nread;
-	auto* buf = (char*) malloc(1024);
-	while((nread = read(from_fd, buf, 1024))) {
-		ssize_t nwrote;
-		nwrote = write(to_fd, buf, nread);
-		if(nwrote <= 0) {
-			if(errno) {
+	//Let the kernel copy the file directly if it can
+	ssize_t ncopied;
+	while((ncopied = copy_file_range(from_fd, NULL, to_fd, NULL, COPY_CHUNK_SIZE, 0)) > 0);
+	if(ncopied < 0 && errno != EINVAL) {
+		perror("cp");
+		return errno;
+	}
+
+	//Otherwise (if one of them isn't a regular file), copy it ourselves
+	if(ncopied < 0) {
+		errno = 0;
+		ssize_t nread;
+		auto* buf = (char*) malloc(COPY_CHUNK_SIZE);
+		while((nread = read(from_fd, buf, COPY_CHUNK_SIZE))) {
+			ssize_t nwrote;
+			nwrote = write(to_fd, buf, nread);
+			if(nwrote <= 0) {
+				if(errno) {
+					perror("cp");
+					return errno;
+				}
 				perror("cp");
-				return errno;
+				return 1;
 			}
-			perror("cp");
-			return 1;
 		}
+		free(buf);
 	}
 
 	close(to_fd);
 	close(from_fd);
-	free(buf);
 
 	return 0;
 }
@@ -23,6 +23,43 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
+//Moves a file to another filesystem by copying it over and then removing the original.
+int move_across_filesystems(const char* from, const char* to) {
+	struct stat from_st;
+	if(lstat(from, &from_st) < 0)
+		return -1;
+	if(!S_ISREG(from_st.st_mode)) {
+		errno = EXDEV;
+		return -1;
+	}
+
+	int from_fd = open(from, O_RDONLY);
+	if(from_fd < 0)
+		return -1;
+	int to_fd = open(to, O_WRONLY | O_CREAT | O_TRUNC, from_st.st_mode);
+	if(to_fd < 0) {
+		close(from_fd);
+		return -1;
+	}
+
+	ssize_t ncopied;
+	while((ncopied = copy_file_range(from_fd, NULL, to_fd, NULL, COPY_CHUNK_SIZE, 0)) > 0);
+	close(from_fd);
+	close(to_fd);
+	if(ncopied < 0) {
+		int err = errno;
+		unlink(to);
+		errno = err;
+		return -1;
+	}
+
+	return unlink(from);
+}
 
 int main(int argc, char** argv) {
 	if(argc < 3) {
@@ -31,6 +68,8 @@ int main(int argc, char** argv) {
 	}
 
 	int res = rename(argv[1], argv[2]);
+	if(res < 0 && errno == EXDEV)
+		res = move_across_filesystems(argv[1], argv[2]);
 	if(res == 0) return 0;
 	perror("mv");
 	return errno;
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+// A program that writes cached data to disk, either for the given files or for everything.
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		sync();
+		return 0;
+	}
+
+	int ret = 0;
+	for(int i = 1; i < argc; i++) {
+		int fd = open(argv[i], O_RDONLY);
+		if(fd < 0 || fsync(fd) < 0) {
+			fprintf(stderr, "sync: %s: %s\n", argv[i], strerror(errno));
+			ret = 1;
+		}
+		if(fd >= 0)
+			close(fd);
+	}
+	return ret;
+}
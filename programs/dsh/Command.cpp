@@ -21,6 +21,7 @@
 #include <utility>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <spawn.h>
 #include <cstring>
 #include "Command.h"
 
@@ -45,30 +46,33 @@ void Command::evaluate(pid_t pgid) {
 		return;
 	}
 
-	//If it's not a built-in, fork and evaluate
-	_pid = fork();
-	if(!_pid) {
-		//Replace all of the FDs we need to
-		for(auto& fd : fds) {
-			dup2(fd.second, fd.first);
-		}
-
-		//Create a c-string array of the arguments
-		const char* c_args[args.size() + 2];
-		c_args[0] = cmd.c_str();
-		for(int i = 0; i < args.size(); i++) {
-			c_args[i + 1] = args[i].c_str();
-		}
-		c_args[args.size() + 1] = NULL;
-		execvp(cmd.c_str(), (char* const*) c_args);
-		fprintf(stderr, "Could not execute %s: %s\n", c_args[0], strerror(errno));
-		exit(errno);
+	//If it's not a built-in, spawn it with its file descriptors replaced and in the right process group
+	posix_spawn_file_actions_t file_actions;
+	posix_spawn_file_actions_init(&file_actions);
+	for(auto& fd : fds)
+		posix_spawn_file_actions_adddup2(&file_actions, fd.second, fd.first);
+
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+	posix_spawnattr_setpgroup(&attr, pgid);
+
+	//Create a c-string array of the arguments
+	const char* c_args[args.size() + 2];
+	c_args[0] = cmd.c_str();
+	for(int i = 0; i < args.size(); i++) {
+		c_args[i + 1] = args[i].c_str();
 	}
-
-	//Set the pgid appropriately
-	if(setpgid(_pid, pgid) < 0) {
-		perror("setpgid");
-		exit(errno);
+	c_args[args.size() + 1] = NULL;
+
+	int res = posix_spawnp(&_pid, cmd.c_str(), &file_actions, &attr, (char* const*) c_args, environ);
+	posix_spawn_file_actions_destroy(&file_actions);
+	posix_spawnattr_destroy(&attr);
+	if(res) {
+		fprintf(stderr, "Could not execute %s: %s\n", c_args[0], strerror(res));
+		_pid = 0;
+		spawn_error = res;
+		return;
 	}
 
 	//Set the controlling process of the terminal if this is the first process in the chain
@@ -107,6 +111,8 @@ int Command::wait() {
 }
 
 int Command::status() {
+	if(spawn_error)
+		return spawn_error;
 	if(!WIFEXITED(return_status))
 		return WIFSIGNALED(return_status);
 	return WEXITSTATUS(return_status);
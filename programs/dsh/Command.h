@@ -42,6 +42,7 @@ private:
 	std::vector<std::string> args;
 	std::map<int, int> fds;
 	int return_status = EXIT_SUCCESS;
+	int spawn_error = 0;
 	pid_t _pid = 0;
 	bool waited = false;
 };
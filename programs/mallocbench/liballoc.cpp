@@ -0,0 +1,6 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+// Builds the old liballoc-based allocator with its functions renamed, so it can be compared against the libc malloc.
+#define __DUCKOS_LIBALLOC_PREFIX(func) liballoc_old_##func
+#include <libc/sys/liballoc.cpp>
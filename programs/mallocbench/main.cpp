@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2023 Byteduck */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/thread.h>
+
+extern "C" {
+	void* liballoc_old_malloc(size_t);
+	void* liballoc_old_realloc(void*, size_t);
+	void liballoc_old_free(void*);
+}
+
+#define NUM_SLOTS 1024
+#define NUM_THREADS 4
+
+struct Allocator {
+	const char* name;
+	void* (*malloc)(size_t);
+	void* (*realloc)(void*, size_t);
+	void (*free)(void*);
+};
+
+struct Benchmark {
+	const char* name;
+	void (*run)(const Allocator&, int);
+	int iterations;
+};
+
+const Allocator allocators[] = {
+	{"liballoc", liballoc_old_malloc, liballoc_old_realloc, liballoc_old_free},
+	{"malloc", malloc, realloc, free}
+};
+
+uint32_t next_rand(uint32_t& state) {
+	state = state * 1103515245 + 12345;
+	return state >> 8;
+}
+
+// Repeatedly allocates and frees small objects of a single size.
+void bench_small(const Allocator& alloc, int iterations) {
+	void* slots[NUM_SLOTS] = {};
+	for(int i = 0; i < iterations; i++) {
+		int slot = i % NUM_SLOTS;
+		if(slots[slot])
+			alloc.free(slots[slot]);
+		slots[slot] = alloc.malloc(32);
+	}
+	for(auto slot : slots)
+		alloc.free(slot);
+}
+
+// Allocates, reallocates and frees objects of random sizes up to 8KiB in a random order.
+void bench_mixed(const Allocator& alloc, int iterations) {
+	void* slots[NUM_SLOTS] = {};
+	uint32_t state = 1;
+	for(int i = 0; i < iterations; i++) {
+		int slot = next_rand(state) % NUM_SLOTS;
+		size_t size = next_rand(state) % 8192 + 1;
+		if(!slots[slot]) {
+			slots[slot] = alloc.malloc(size);
+		} else if(i % 4 == 0) {
+			slots[slot] = alloc.realloc(slots[slot], size);
+		} else {
+			alloc.free(slots[slot]);
+			slots[slot] = nullptr;
+		}
+		if(slots[slot])
+			memset(slots[slot], 0, size < 64 ? size : 64);
+	}
+	for(auto slot : slots)
+		alloc.free(slot);
+}
+
+// Allocates large buffers that don't fit in any size class.
+void bench_large(const Allocator& alloc, int iterations) {
+	for(int i = 0; i < iterations; i++) {
+		auto* buf = alloc.malloc(64 * 1024 + i % 4096);
+		alloc.free(buf);
+	}
+}
+
+struct ThreadArgs {
+	const Allocator* alloc;
+	int iterations;
+};
+
+void* mixed_thread(void* arg) {
+	auto* args = (ThreadArgs*) arg;
+	bench_mixed(*args->alloc, args->iterations);
+	return nullptr;
+}
+
+// Runs the mixed benchmark on several threads at once.
+void bench_threads(const Allocator& alloc, int iterations) {
+	ThreadArgs args = {&alloc, iterations / NUM_THREADS};
+	tid_t threads[NUM_THREADS];
+	for(auto& thread : threads)
+		thread = thread_create(mixed_thread, &args);
+	for(auto thread : threads)
+		thread_join(thread, nullptr);
+}
+
+const Benchmark benchmarks[] = {
+	{"small", bench_small, 1000000},
+	{"mixed", bench_mixed, 200000},
+	{"large", bench_large, 10000},
+	{"threads", bench_threads, 200000}
+};
+
+long elapsed_ms(const timespec& start, const timespec& end) {
+	return (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+}
+
+int main(int argc, char** argv) {
+	const char* only = argc > 1 ? argv[1] : nullptr;
+	for(auto& bench : benchmarks) {
+		if(only && strcmp(only, bench.name))
+			continue;
+		for(auto& alloc : allocators) {
+			timespec start, end;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			bench.run(alloc, bench.iterations);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			printf("%-8s %-8s %6ldms\n", bench.name, alloc.name, elapsed_ms(start, end));
+		}
+	}
+	return 0;
+}
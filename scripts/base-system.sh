@@ -49,6 +49,10 @@ msg "Setting up /proc/..."
 mkdir -p "$FS_DIR"/proc
 chmod 555 "$FS_DIR"/proc
 
+msg "Setting up /tmp/..."
+mkdir -p "$FS_DIR"/tmp
+chmod 1777 "$FS_DIR"/tmp
+
 msg "Setting up /sock/..."
 mkdir -p "$FS_DIR"/sock
 chmod 777 "$FS_DIR"/sock
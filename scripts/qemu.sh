@@ -48,6 +48,23 @@ elif "$DUCKOS_QEMU" --display help | grep -iq cocoa; then
 	DUCKOS_QEMU_DISPLAY="--display cocoa"
 fi
 
+# Determine how the disk should be attached (ide, ahci, or virtio)
+if [ -z "$DUCKOS_DISK_INTERFACE" ]; then
+	DUCKOS_DISK_INTERFACE="ide"
+fi
+
+case "$DUCKOS_DISK_INTERFACE" in
+	ahci)
+		DUCKOS_QEMU_DISK="-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=none -device ahci,id=ahci -device ide-hd,drive=disk,bus=ahci.0"
+		;;
+	virtio)
+		DUCKOS_QEMU_DISK="-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=none -device virtio-blk-pci,drive=disk,disable-modern=on"
+		;;
+	*)
+		DUCKOS_QEMU_DISK="-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=ide"
+		;;
+esac
+
 if [ -z "$DUCKOS_KERNEL_ARGS" ]; then
   DUCKOS_KERNEL_ARGS="$@"
 fi
@@ -56,7 +73,7 @@ fi
 DUCKOS_QEMU_ARGS="
 	-s
 	-kernel kernel/duckk32
-	-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=ide
+	$DUCKOS_QEMU_DISK
 	-m 512M
 	-serial stdio
 	-device ac97
@@ -21,6 +21,7 @@
 #include <libduck/Config.h>
 #include <libduck/StringStream.h>
 #include <unistd.h>
+#include <spawn.h>
 
 Duck::ResultRet<Service> Service::load_service(Duck::Path path) {
 	auto config_res = Duck::Config::read_from(path);
@@ -72,33 +73,30 @@ const std::string& Service::after() const {
 
 void Service::execute() const {
 	Duck::Log::info("Starting service ", m_name, "...");
-	pid_t pid = fork();
-
-	if(pid == 0) {
-		Duck::StringInputStream exec_stream(m_exec);
-		exec_stream.set_delimeter(' ');
-
-		//Split arguments from exec command
-		std::vector<std::string> args;
-		std::string arg;
-		while(!exec_stream.eof()) {
-			exec_stream >> arg;
-			args.push_back(arg);
-		}
+	Duck::StringInputStream exec_stream(m_exec);
+	exec_stream.set_delimeter(' ');
+
+	//Split arguments from exec command
+	std::vector<std::string> args;
+	std::string arg;
+	while(!exec_stream.eof()) {
+		exec_stream >> arg;
+		args.push_back(arg);
+	}
 
-		//Convert c++ string vector into cstring array
-		const char* c_args[args.size() + 1];
-		for(auto i = 0; i < args.size(); i++)
-			c_args[i] = args[i].c_str();
-		c_args[args.size()] = NULL;
+	//Convert c++ string vector into cstring array
+	const char* c_args[args.size() + 1];
+	for(auto i = 0; i < args.size(); i++)
+		c_args[i] = args[i].c_str();
+	c_args[args.size()] = NULL;
 
-		char* env[] = {NULL};
+	char* env[] = {NULL};
 
-		//Execute the command
-		execvpe(c_args[0], (char* const*) c_args, env);
-		Duck::Log::err("Failed to execute ", m_exec, ": ", strerror(errno));
-		exit(-1);
-	}
+	//Execute the command
+	pid_t pid;
+	int res = posix_spawnp(&pid, c_args[0], nullptr, nullptr, (char* const*) c_args, env);
+	if(res)
+		Duck::Log::err("Failed to execute ", m_exec, ": ", strerror(res));
 }
 
 Service::Service(std::string name, std::string exec, std::string after):
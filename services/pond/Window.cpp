@@ -23,6 +23,8 @@
 #include <libgraphics/Image.h>
 #include <libduck/Log.h>
 #include <memory.h>
+#include <sys/mman.h>
+#include <kernel/api/page_size.h>
 #include <libpond/Window.h>
 
 using namespace Gfx;
@@ -310,6 +312,17 @@ bool Window::flip() {
 void Window::alloc_framebuffer() {
 	// Only reallocate if we need more space in the buffer
 	auto new_buffer_size = IMGSIZE(_rect.width, _rect.height) * 2;
+	if(_framebuffer.data && new_buffer_size > _framebuffer_shm.size) {
+		// Try growing the old framebuffer by remapping it, which keeps its shm id and doesn't copy anything.
+		auto* new_ptr = mremap(_framebuffer_shm.ptr, _framebuffer_shm.size, new_buffer_size, MREMAP_MAYMOVE);
+		if(new_ptr != MAP_FAILED) {
+			_framebuffer_shm.ptr = new_ptr;
+			_framebuffer_shm.size = ((new_buffer_size + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+		} else {
+			perror("Failed to grow framebuffer for window");
+		}
+	}
+
 	if(!_framebuffer.data || new_buffer_size > _framebuffer_shm.size) {
 		//Deallocate the old framebuffer if there is one
 		if(_framebuffer.data && shmdetach(_framebuffer_shm.id) < 0) {
@@ -24,7 +24,7 @@
 #include "FontManager.h"
 #include <libduck/Log.h>
 #include <string.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 
 int main(int argc, char** argv, char** envp) {
@@ -35,13 +35,13 @@ int main(int argc, char** argv, char** envp) {
 	auto* mouse = new Mouse(main_window);
 	auto* font_manager = new FontManager();
 
-	struct pollfd polls[3];
-	polls[0].fd = mouse->fd();
-	polls[0].events = POLLIN;
-	polls[1].fd = server->fd();
-	polls[1].events = POLLIN;
-	polls[2].fd = display->keyboard_fd();
-	polls[2].events = POLLIN;
+	//Pond handles every kind of event each time around the loop, so it only cares whether any of them are ready
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	for(int fd : {mouse->fd(), server->fd(), display->keyboard_fd()}) {
+		struct epoll_event event = {.events = EPOLLIN, .data = {.fd = fd}};
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+	struct epoll_event events[3];
 
 	if(!fork()) {
 		char* argv[] = {NULL};
@@ -55,7 +55,7 @@ int main(int argc, char** argv, char** envp) {
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
 	while(true) {
-		poll(polls, 3, display->buffer_is_dirty() ? display->millis_until_next_flip() : -1);
+		epoll_wait(epoll_fd, events, 3, display->buffer_is_dirty() ? display->millis_until_next_flip() : -1);
 		mouse->update();
 		display->update_keyboard();
 		server->handle_packets();